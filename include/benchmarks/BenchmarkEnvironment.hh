@@ -0,0 +1,129 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+#include "G4HCofThisEvent.hh"
+#include "G4RunManager.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+
+#include "NDetectorConstruction.hh"
+#include "SensitiveDetector.hh"
+#include "TupleManager.hh"
+
+/**
+ * \brief Minimal geometry for the microbenchmarks
+ *
+ * A row of germanium cubes, each of which is registered as a separate
+ * sensitive detector, and a cylindrical source volume in the center of the
+ * world.
+ */
+class BenchmarkDetectorConstruction : public NDetectorConstruction {
+public:
+  BenchmarkDetectorConstruction(const size_t n_detectors);
+
+  G4VPhysicalVolume *Construct() override final;
+
+private:
+  const size_t n_detectors;
+};
+
+/**
+ * \brief Step with a track and a detector, created without tracking
+ */
+struct SyntheticStep {
+  unique_ptr<G4Track> track;
+  unique_ptr<G4Step> step;
+  size_t detector;
+};
+
+/**
+ * \brief Geant4 environment for microbenchmarks of nutr's user code
+ *
+ * Creates a sequential G4RunManager with a BenchmarkDetectorConstruction and
+ * the sensitive detectors of the selected SENSITIVE_DETECTOR_DIR, but never
+ * initializes the run manager. This means that there is no physics list and
+ * no run: hot paths like ProcessHits() or EndOfEventAction() are called
+ * directly with synthetic inputs.
+ *
+ * The environment is created on first use and must be destroyed with
+ * Shutdown() before the program exits.
+ */
+class BenchmarkEnvironment {
+public:
+  static constexpr size_t n_detectors = 8;
+
+  static BenchmarkEnvironment &Instance();
+  static void Shutdown();
+
+  BenchmarkDetectorConstruction *GetDetectorConstruction() const {
+    return detector_construction;
+  }
+  SensitiveDetector *GetSensitiveDetector(const size_t detector) const {
+    return sensitive_detectors[detector];
+  }
+
+  /**
+   * \brief Get a TupleManager whose ntuple has been booked
+   *
+   * The output file is created in the temporary directory of the system and
+   * deleted by Shutdown().
+   */
+  TupleManager *GetTupleManager();
+
+  /**
+   * \brief Create reproducible steps of photons with random energies and
+   * directions
+   *
+   * The steps are distributed over the detectors in turn. Every tenth step
+   * has no energy deposition, like a pure transportation step.
+   */
+  vector<SyntheticStep> CreateSteps(const size_t n_steps,
+                                    const unsigned int seed) const;
+
+  /**
+   * \brief Create a hits collection of this event for all sensitive detectors
+   * and call their Initialize() method, like G4SDManager at the beginning of
+   * an event.
+   */
+  G4HCofThisEvent *CreateHitsCollections() const;
+
+private:
+  BenchmarkEnvironment();
+  ~BenchmarkEnvironment();
+
+  unique_ptr<G4RunManager> run_manager;
+  BenchmarkDetectorConstruction *detector_construction;
+  vector<SensitiveDetector *> sensitive_detectors;
+
+  unique_ptr<TupleManager> tuple_manager;
+  string output_file_name;
+
+  inline static BenchmarkEnvironment *instance = nullptr;
+};
@@ -19,21 +19,118 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIcommand.hh"
 #include "G4UIdirectory.hh"
 #include "G4UImessenger.hh"
 
+#include "Histogram.hh"
+#include "NextEventEstimator.hh"
+#include "OutputBackend.hh"
+
 class NutrMessenger : public G4UImessenger {
 public:
   NutrMessenger();
   void SetNewValue(G4UIcommand *command, G4String str) override;
   static std::string GetFilename() { return filename; };
+  static const std::vector<std::pair<std::string, ColumnPrecision>> &
+  GetPrecisions() {
+    return precisions;
+  };
+  static std::string GetTrigger() { return trigger; };
+  static bool GetMerge() { return merge; };
+  static uint64_t GetRotateEvents() { return rotate_events; };
+  static uint64_t GetRotateBytes() { return rotate_bytes; };
+  static unsigned int GetShard() { return shard; };
+  static bool GetRecordPrimaries() { return record_primaries; };
+  static std::string GetCalibration() { return calibration; };
+  static const std::string &GetChargeCollection() {
+    return charge_collection;
+  };
+  static bool GetKeepEdep() { return keep_edep; };
+  static bool GetAddback() { return addback; };
+  static bool GetKeepCrystals() { return keep_crystals; };
+  static double GetTimeWindow() { return time_window; };
+  static bool GetSplitTimeWindows() { return split_time_windows; };
+  static bool GetWriteWeights() { return write_weights; };
+  static const Histogram::Axis &GetSpectrum() { return spectrum; };
+  static size_t GetAngleBins() { return angle_bins; };
+  static bool GetTrackLength() { return track_length; };
+  static size_t GetBatchSize() { return batch_size; };
+  static const std::vector<PointDetector> &GetPointDetectors() {
+    return point_detectors;
+  };
+  static const std::vector<std::string> &GetPointDetectorVolumes() {
+    return point_detector_volumes;
+  };
+  static const std::vector<std::string> &GetScorers() { return scorers; };
 
 private:
+  /**
+   * \brief Set the value of a command
+   *
+   * \throw std::runtime_error if the value is invalid, in which case the
+   * previous value is kept.
+   */
+  void ApplyNewValue(G4UIcommand *command, const G4String &str);
+
   G4UIdirectory dir;
   G4UIcmdWithAString cmd_filename;
+  G4UIcommand cmd_precision;
+  G4UIcmdWithAString cmd_trigger;
+  G4UIcmdWithABool cmd_merge;
+  G4UIcmdWithAnInteger cmd_rotate_events;
+  G4UIcommand cmd_rotate_size;
+  G4UIcmdWithAnInteger cmd_shard;
+  G4UIcmdWithABool cmd_record_primaries;
+  G4UIcmdWithAString cmd_calibration;
+  G4UIcmdWithAString cmd_charge_collection;
+  G4UIcmdWithABool cmd_keep_edep;
+  G4UIcmdWithABool cmd_addback;
+  G4UIcmdWithABool cmd_keep_crystals;
+  G4UIcmdWithADoubleAndUnit cmd_time_window;
+  G4UIcmdWithABool cmd_split_time_windows;
+  G4UIcmdWithABool cmd_weights;
+  G4UIcommand cmd_spectrum;
+  G4UIcmdWithAnInteger cmd_angle_bins;
+  G4UIcmdWithABool cmd_track_length;
+  G4UIcmdWithAnInteger cmd_batch_size;
+  G4UIcommand cmd_point_detector;
+  G4UIcmdWithAString cmd_point_detector_volume;
+  G4UIcmdWithoutParameter cmd_clear_point_detectors;
+  G4UIcmdWithAString cmd_scorer;
 
   inline static std::string filename = "";
+  inline static std::vector<std::pair<std::string, ColumnPrecision>>
+      precisions;
+  inline static std::string trigger = "";
+  inline static bool merge = true;
+  inline static uint64_t rotate_events = 0;
+  inline static uint64_t rotate_bytes = 0;
+  inline static unsigned int shard = 0;
+  inline static bool record_primaries = false;
+  inline static std::string calibration = "";
+  inline static std::string charge_collection = "";
+  inline static bool keep_edep = true;
+  inline static bool addback = false;
+  inline static bool keep_crystals = true;
+  inline static double time_window = 0.;
+  inline static bool split_time_windows = false;
+  inline static bool write_weights = false;
+  inline static Histogram::Axis spectrum = {"energy", 0, 0., 0.};
+  inline static size_t angle_bins = 9;
+  inline static bool track_length = false;
+  inline static size_t batch_size = 1000;
+  inline static std::vector<PointDetector> point_detectors;
+  inline static std::vector<std::string> point_detector_volumes;
+  inline static std::vector<std::string> scorers;
 };
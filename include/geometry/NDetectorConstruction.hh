@@ -52,6 +52,16 @@ public:
   size_t GetNumberOfSensitiveDetectors() const {
     return sensitive_logical_volumes.size();
   };
+  /**
+   * \brief Detector IDs of the volumes of each call of
+   * RegisterSensitiveLogicalVolumes()
+   *
+   * Since each Detector registers all of its sensitive volumes at once, a
+   * group contains, for example, the four crystals of a clover.
+   */
+  const vector<vector<size_t>> &GetSensitiveDetectorGroups() const {
+    return sensitive_detector_groups;
+  };
   vector<shared_ptr<SourceVolume>> GetSourceVolumes() { return source_volumes; }
 
   void set_molly_x(const double x) { molly_x = x; }
@@ -66,6 +76,7 @@ protected:
   NDetectorConstructionMessenger *messenger;
 
   vector<G4LogicalVolume *> sensitive_logical_volumes;
+  vector<vector<size_t>> sensitive_detector_groups;
   vector<shared_ptr<SourceVolume>> source_volumes;
 
   double molly_x, zero_degree_x, zero_degree_y;
@@ -0,0 +1,47 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIdirectory.hh"
+#include "G4UImessenger.hh"
+
+/**
+ * \brief Macro commands for the optional instrumentation of nutr
+ *
+ * The settings apply to the whole process, not to individual threads. For this
+ * reason, none of the commands are broadcast to the worker threads.
+ */
+class InstrumentationMessenger : public G4UImessenger {
+public:
+  InstrumentationMessenger();
+  void SetNewValue(G4UIcommand *command, G4String str) override;
+
+private:
+  G4UIdirectory dir;
+  G4UIcmdWithAString cmd_trace;
+  G4UIcmdWithAnInteger cmd_trace_buffer_size;
+  G4UIcmdWithoutParameter cmd_memory_report;
+  G4UIcmdWithABool cmd_memory_report_each_run;
+  G4UIcmdWithABool cmd_perf_counters;
+};
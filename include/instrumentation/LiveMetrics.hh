@@ -0,0 +1,106 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * \brief Live progress metrics of a simulation
+ *
+ * Collects the number of processed events per thread and the progress of the
+ * current run, and exposes them together with the memory usage and the size
+ * of the output in the Prometheus text format (see MetricsServer).
+ *
+ * Each thread counts its events in its own slot, which is registered once per
+ * thread. After that, a thread only writes to atomic variables of its own
+ * slot, so reading the metrics at any time never blocks or slows down the
+ * threads that process events.
+ *
+ * Counting is disabled by default and enabled by a MetricsServer.
+ */
+class LiveMetrics {
+public:
+  static void Enable() { enabled.store(true, std::memory_order_relaxed); }
+  static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+  /**
+   * \brief Mark the beginning of a run
+   *
+   * Must be called by the master thread before the workers start the run.
+   */
+  static void BeginOfRun(const int run_id, const long n_events);
+  static void EndOfRun();
+  static void SetOutputFile(const string &file_name);
+
+  static void EventFinished() {
+    if (IsEnabled()) {
+      record_event();
+    }
+  }
+
+  /**
+   * \brief All metrics in the Prometheus text-based exposition format
+   */
+  static string Expose();
+
+private:
+  struct ThreadSlot {
+    int thread_id;
+    std::atomic<uint64_t> events{0};
+    std::atomic<int64_t> last_event_time{0};
+  };
+
+  static void record_event();
+  static ThreadSlot *register_thread();
+  static int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - epoch)
+        .count();
+  }
+  static uint64_t total_events();
+  static size_t output_bytes();
+
+  inline static std::atomic<bool> enabled{false};
+  inline static std::mutex slots_mutex;
+  inline static vector<unique_ptr<ThreadSlot>> slots;
+
+  inline static std::atomic<int> run_id{-1};
+  inline static std::atomic<bool> run_active{false};
+  inline static std::atomic<long> run_events_requested{0};
+  inline static std::atomic<uint64_t> run_events_offset{0};
+  inline static std::atomic<int64_t> run_start_time{0};
+  inline static std::atomic<int64_t> run_end_time{0};
+
+  inline static std::mutex output_file_mutex;
+  inline static string output_file;
+
+  inline static const std::chrono::steady_clock::time_point epoch =
+      std::chrono::steady_clock::now();
+};
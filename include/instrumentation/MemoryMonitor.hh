@@ -0,0 +1,110 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * \brief Accounting of the memory footprint of nutr per subsystem
+ *
+ * The MemoryMonitor collects the resident set size (RSS) of the process, the
+ * size of the G4Allocator pools and the peak size of the hits collections of
+ * each thread, the size of the ntuple output of each thread, and the number of
+ * geometry objects and materials.
+ *
+ * Each thread publishes its numbers into its own record, which is registered
+ * once per thread. G4Allocator pools are thread-local, so their sizes can
+ * only be determined by the thread that owns them. For this reason, the hit
+ * classes register a function that returns the size of their allocator pool,
+ * and each thread evaluates these functions when it updates its record.
+ */
+class MemoryMonitor {
+public:
+  /**
+   * \brief Register a function that returns the size of an allocator pool
+   *
+   * \param name Name of the allocated class.
+   * \param allocated_size Function that returns the current size of the pool
+   * of the calling thread in bytes.
+   *
+   * \return Always true, so that the registration can initialize a static
+   * variable.
+   */
+  static bool RegisterAllocator(const string &name,
+                                std::function<size_t()> allocated_size);
+
+  static void SetReportAtRunBoundaries(const bool report) {
+    report_at_run_boundaries = report;
+  }
+  static bool ReportAtRunBoundaries() { return report_at_run_boundaries; }
+
+  static void RecordHitsCollectionSize(const size_t size);
+  static void RecordNtupleRow(const size_t n_columns);
+  static void RecordOutputFile(const string &file_name);
+
+  /**
+   * \brief Current and peak resident set size of the process in bytes
+   *
+   * Both are zero on systems without a /proc file system.
+   */
+  static size_t ResidentSetSize();
+  static size_t PeakResidentSetSize();
+
+  /**
+   * \brief Publish the allocator pool sizes of the calling thread
+   */
+  static void UpdateThread();
+
+  /**
+   * \brief Print a memory report to G4cout
+   *
+   * \param title Short description of the point in time at which the report is
+   * created.
+   */
+  static void Report(const string &title);
+
+private:
+  struct ThreadRecord {
+    int thread_id;
+    vector<std::atomic<size_t>> allocator_bytes;
+    std::atomic<size_t> hits_collection_peak_size{0};
+    std::atomic<size_t> ntuple_columns{0};
+    std::atomic<size_t> ntuple_rows{0};
+  };
+
+  static ThreadRecord *thread_record();
+  static vector<std::pair<string, std::function<size_t()>>> &allocators();
+
+  inline static bool report_at_run_boundaries = false;
+  inline static std::mutex records_mutex;
+  inline static vector<unique_ptr<ThreadRecord>> records;
+  inline static std::mutex output_files_mutex;
+  inline static vector<string> output_files;
+};
@@ -0,0 +1,62 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <string>
+#include <thread>
+
+using std::string;
+
+/**
+ * \brief Background thread that serves the LiveMetrics via HTTP
+ *
+ * The server listens either on a TCP port of the loopback interface or on a
+ * Unix domain socket, and answers each HTTP GET request with the current
+ * metrics in the Prometheus text format. Requests are answered one after
+ * another by a single thread, which only reads the metrics.
+ *
+ * Constructing a server enables the LiveMetrics. The server is stopped when
+ * it is destroyed.
+ */
+class MetricsServer {
+public:
+  /**
+   * \brief Listen on localhost:port
+   */
+  explicit MetricsServer(const int port);
+  /**
+   * \brief Listen on the Unix domain socket at socket_path
+   */
+  explicit MetricsServer(const string &socket_path);
+  ~MetricsServer();
+
+  MetricsServer(const MetricsServer &) = delete;
+  MetricsServer &operator=(const MetricsServer &) = delete;
+
+private:
+  void start();
+  void serve();
+  void respond(const int client);
+
+  int listen_socket;
+  int stop_pipe[2];
+  string unix_socket_path;
+  std::thread thread;
+};
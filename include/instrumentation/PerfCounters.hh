@@ -0,0 +1,147 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using std::array;
+using std::unique_ptr;
+using std::vector;
+
+#include "InstrumentationBuildOptions.hh"
+
+/**
+ * \brief Opt-in hardware performance counters for the phases of a run
+ *
+ * If nutr was built with the CMake option `WITH_PERF_COUNTERS`, each thread
+ * opens a group of Linux `perf_event_open` counters (CPU cycles, retired
+ * instructions, last-level cache misses, and branch misses) that count the
+ * user-space activity of that thread only.
+ *
+ * The counters are read at every transition between the phases of an event
+ * (primary generation, tracking, ProcessHits of the sensitive detectors, and
+ * end-of-event output). The difference since the previous transition is
+ * attributed to the innermost active phase, i.e. the phases are exclusive:
+ * the time spent in ProcessHits is not counted as tracking. Everything
+ * outside of these phases is attributed to 'other'.
+ *
+ * Reading the counters requires a system call, which is why the counters
+ * are disabled by default even if nutr was built with them. They are enabled
+ * via the macro command `/instrumentation/perf_counters`. Without
+ * `WITH_PERF_COUNTERS`, all calls compile to nothing.
+ */
+class PerfCounters {
+public:
+  enum Phase : size_t {
+    other,
+    generation,
+    tracking,
+    process_hits,
+    output,
+    n_phases
+  };
+  enum Counter : size_t {
+    cycles,
+    instructions,
+    cache_misses,
+    branch_misses,
+    n_counters
+  };
+
+  static void SetEnabled(const bool enable);
+  static bool IsEnabled() {
+    if constexpr (instrumentation_build_options.with_perf_counters) {
+      return enabled.load(std::memory_order_relaxed);
+    }
+    return false;
+  }
+
+  static void Begin(const Phase phase) {
+    if (IsEnabled()) {
+      transition(phase, true);
+    }
+  }
+  static void End(const Phase phase) {
+    if (IsEnabled()) {
+      transition(phase, false);
+    }
+  }
+
+  /**
+   * \brief Print the counters of all threads and reset them
+   *
+   * Must only be called when no other thread is counting, i.e. by the master
+   * thread at the end of a run.
+   */
+  static void Report(const int run_id);
+
+private:
+  static constexpr size_t max_depth = 8;
+
+  struct ThreadCounters {
+    ~ThreadCounters();
+
+    int thread_id;
+    array<int, n_counters> file_descriptors;
+    bool valid;
+    array<Phase, max_depth> stack;
+    size_t depth;
+    array<uint64_t, n_counters> last_values;
+    uint64_t last_time_enabled;
+    uint64_t last_time_running;
+    array<array<uint64_t, n_counters>, n_phases> totals;
+    uint64_t time_enabled;
+    uint64_t time_running;
+  };
+
+  static void transition(const Phase phase, const bool begin);
+  static ThreadCounters *register_thread();
+  static bool open_counters(ThreadCounters &counters);
+  static bool read_counters(ThreadCounters &counters,
+                            array<uint64_t, n_counters> &values,
+                            uint64_t &time_enabled, uint64_t &time_running);
+
+  inline static std::atomic<bool> enabled{false};
+  inline static std::mutex threads_mutex;
+  inline static vector<unique_ptr<ThreadCounters>> threads;
+};
+
+/**
+ * \brief RAII helper that attributes the hardware counters of a scope to a
+ * phase
+ */
+class PerfCounterScope {
+public:
+  PerfCounterScope(const PerfCounters::Phase _phase) : phase(_phase) {
+    PerfCounters::Begin(phase);
+  }
+  ~PerfCounterScope() { PerfCounters::End(phase); }
+
+  PerfCounterScope(const PerfCounterScope &) = delete;
+  PerfCounterScope &operator=(const PerfCounterScope &) = delete;
+
+private:
+  PerfCounters::Phase phase;
+};
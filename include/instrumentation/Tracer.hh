@@ -0,0 +1,115 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * \brief Opt-in timeline tracing of the phases of a run
+ *
+ * The Tracer records begin and end timestamps of named phases (primary
+ * generation, tracking, end-of-event processing, output, ...) on each thread.
+ * Every thread writes into its own preallocated buffer, so recording an event
+ * neither locks nor allocates. Buffers are registered with the Tracer once per
+ * thread, which is the only operation that takes a lock.
+ *
+ * At the end of a run, the master thread writes all buffers to a file in the
+ * Chrome trace event format, which can be inspected with chrome://tracing or
+ * https://ui.perfetto.dev. Each Geant4 thread appears as a separate track.
+ *
+ * Tracing is disabled by default. It is enabled by setting an output file via
+ * the macro command `/instrumentation/trace`.
+ */
+class Tracer {
+public:
+  static void Enable(const string &file_name);
+  static void SetBufferSize(const size_t n_events) { buffer_size = n_events; }
+  static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+  static void Begin(const char *name) {
+    if (IsEnabled()) {
+      record(name, 'B');
+    }
+  }
+  static void End(const char *name) {
+    if (IsEnabled()) {
+      record(name, 'E');
+    }
+  }
+
+  /**
+   * \brief Write all recorded events to the trace file and reset the buffers
+   *
+   * Must only be called when no other thread is recording, i.e. by the master
+   * thread at the end of a run.
+   *
+   * \param run_id ID of the run that has just ended. For all runs except the
+   * first one, the run ID is appended to the file name.
+   */
+  static void Dump(const int run_id);
+
+private:
+  struct TraceEvent {
+    const char *name; /**< Must point to a string literal. */
+    std::chrono::steady_clock::rep time_stamp;
+    char phase;
+  };
+  struct TraceBuffer {
+    int thread_id;
+    vector<TraceEvent> events;
+    size_t n_events;
+    size_t n_dropped;
+  };
+
+  static void record(const char *name, const char phase);
+  static TraceBuffer *register_thread();
+
+  inline static std::atomic<bool> enabled{false};
+  inline static string trace_file_name;
+  inline static size_t buffer_size = 1 << 18;
+  inline static std::mutex buffers_mutex;
+  inline static vector<unique_ptr<TraceBuffer>> buffers;
+  inline static const std::chrono::steady_clock::time_point epoch =
+      std::chrono::steady_clock::now();
+};
+
+/**
+ * \brief RAII helper that traces the lifetime of a scope as a phase
+ */
+class TraceScope {
+public:
+  TraceScope(const char *_name) : name(_name) { Tracer::Begin(name); }
+  ~TraceScope() { Tracer::End(name); }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+  const char *name;
+};
@@ -0,0 +1,84 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * \brief Encodings of column chunks in the nutr columnar output format
+ *
+ * Integer columns, including quantized columns, are encoded either as plain
+ * 64-bit values, or with the minimum value (frame of reference) subtracted
+ * and the remainders bit-packed, or as bit-packed differences between
+ * consecutive values. Both integer and floating-point columns can also be
+ * encoded in a sparse representation that stores a bitmap of the non-zero
+ * entries and only the non-zero values. Simulated detector responses are
+ * dominated by zeros, because most detectors are not hit in most events.
+ *
+ * The encoder tries all encodings of a type and keeps the smallest result. If
+ * nutr was built with zstd, the result is compressed further if this saves a
+ * significant amount of space, which is indicated by the compressed flag in
+ * the codec byte.
+ */
+namespace columnar {
+
+enum Codec : uint8_t {
+  plain = 0,
+  frame_of_reference = 1,
+  delta = 2,
+  sparse = 3,
+};
+constexpr uint8_t compressed_flag = 0x80;
+
+struct EncodedChunk {
+  string bytes;
+  uint64_t encoded_size; /**< Size before general-purpose compression. */
+  uint8_t codec;
+};
+
+EncodedChunk EncodeIntegers(const vector<int64_t> &values);
+EncodedChunk EncodeFloats(const vector<double> &values);
+EncodedChunk EncodeFloats(const vector<float> &values);
+
+/**
+ * \brief Decode a chunk and append its n_rows values to values
+ *
+ * \throw std::runtime_error if the chunk is corrupt or if it was compressed
+ * and nutr was built without zstd.
+ */
+void DecodeIntegers(const uint8_t *data, const size_t size,
+                    const uint64_t encoded_size, const uint8_t codec,
+                    const size_t n_rows, vector<int64_t> &values);
+void DecodeFloats(const uint8_t *data, const size_t size,
+                  const uint64_t encoded_size, const uint8_t codec,
+                  const size_t n_rows, vector<double> &values);
+void DecodeFloats(const uint8_t *data, const size_t size,
+                  const uint64_t encoded_size, const uint8_t codec,
+                  const size_t n_rows, vector<float> &values);
+
+string CodecName(const uint8_t codec);
+
+} // namespace columnar
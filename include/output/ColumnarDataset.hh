@@ -0,0 +1,108 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+#include "ColumnarFormat.hh"
+#include "ColumnarReader.hh"
+
+/**
+ * \brief Several columnar files that are read as a single dataset
+ *
+ * The dataset is opened either from a manifest, which lists the files that
+ * were written by the threads of a simulation, or from a single columnar
+ * file. Tables are matched by name, and a table must have the same columns in
+ * all files that contain it. The rows of a table are ordered by file and, in
+ * each file, by row group.
+ */
+class ColumnarDataset {
+public:
+  /**
+   * \brief Row group of a table in one of the files
+   */
+  struct RowGroup {
+    size_t file;
+    size_t row_group;
+  };
+
+  /**
+   * \throw std::runtime_error if a file cannot be opened, or if the schemas
+   * of the files do not match.
+   */
+  explicit ColumnarDataset(const string &path);
+  /**
+   * \brief Open several manifests or files as a single dataset
+   */
+  explicit ColumnarDataset(const vector<string> &paths);
+
+  const vector<columnar::TableSchema> &GetTables() const { return tables; }
+  /**
+   * \throw std::runtime_error if the table or the column does not exist.
+   */
+  size_t GetTableID(const string &name) const;
+  size_t GetColumnID(const size_t table, const string &name) const;
+  uint64_t GetNumberOfRows(const size_t table) const;
+  vector<RowGroup> GetRowGroups(const size_t table) const;
+  uint64_t GetNumberOfRows(const RowGroup &row_group) const {
+    return files[row_group.file]->GetRowGroup(row_group.row_group).n_rows;
+  }
+
+  size_t GetNumberOfFiles() const { return files.size(); }
+  const ColumnarReader &GetFile(const size_t file) const {
+    return *files.at(file);
+  }
+  /**
+   * \brief Index of a table of the dataset in one of its files, or
+   * ColumnarDataset::missing if the file does not contain the table
+   */
+  size_t GetFileTableID(const size_t file, const size_t table) const {
+    return table_ids.at(file).at(table);
+  }
+  static constexpr size_t missing = std::numeric_limits<size_t>::max();
+
+  /**
+   * \brief Append the values of a column to values
+   *
+   * See ColumnarReader::ReadColumn for the allowed types.
+   */
+  void ReadColumn(const size_t table, const size_t column,
+                  vector<int64_t> &values) const;
+  void ReadColumn(const size_t table, const size_t column,
+                  vector<double> &values) const;
+  void ReadColumn(const RowGroup &row_group, const size_t table,
+                  const size_t column, vector<int64_t> &values) const;
+  void ReadColumn(const RowGroup &row_group, const size_t table,
+                  const size_t column, vector<double> &values) const;
+
+private:
+  vector<unique_ptr<ColumnarReader>> files;
+  vector<columnar::TableSchema> tables;
+  vector<vector<size_t>> table_ids;
+};
@@ -0,0 +1,106 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using std::atomic;
+using std::map;
+using std::mutex;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+#include "ColumnarFileWriter.hh"
+
+/**
+ * \brief Sequence of numbered columnar files that replaces a single output
+ * file, shared by all threads which write to the same path
+ *
+ * A new file (chunk) is started when the current one contains more than
+ * max_events events, or when it has reached max_bytes bytes. Each thread
+ * reports the beginning of an event with AddEvent() and switches to the
+ * latest chunk if it has changed, so that the rows of an event are never
+ * split between two chunks. The limits are approximate: rows that a thread
+ * has buffered are written to its current chunk when it switches.
+ *
+ * The chunks of OUTPUT.nutr are named OUTPUT_cN.nutr. A chunk is complete
+ * when the last thread has released it, and the index OUTPUT.manifest then
+ * lists all complete chunks, so that they can be processed while the
+ * simulation is still running.
+ */
+class ColumnarFileSeries {
+public:
+  /**
+   * \param max_events Maximum number of events per chunk, or 0 for no limit.
+   * \param max_bytes Maximum size of a chunk in bytes, or 0 for no limit.
+   */
+  static ColumnarFileSeries *Acquire(const string &path,
+                                     const uint64_t max_events,
+                                     const uint64_t max_bytes);
+  static void Release(ColumnarFileSeries *series);
+
+  /**
+   * \brief Count an event that is about to be written to current_chunk
+   *
+   * \param bytes Size of current_chunk so far.
+   *
+   * \return The latest chunk, to which the event should be written.
+   */
+  unsigned int AddEvent(const unsigned int current_chunk,
+                        const uint64_t bytes);
+  /**
+   * \brief Open the latest chunk that is not complete yet
+   *
+   * \param chunk Set to the index of the chunk.
+   *
+   * \throw std::runtime_error if the file cannot be created.
+   */
+  ColumnarFileWriter *AcquireChunk(unsigned int &chunk);
+  /**
+   * \brief Release a chunk, and add it to the index if it is complete
+   *
+   * \throw std::runtime_error if the file or the index cannot be written.
+   */
+  void ReleaseChunk(ColumnarFileWriter *file, const unsigned int chunk);
+  vector<string> GetCompletedFileNames() const;
+
+private:
+  ColumnarFileSeries(const string &path, const uint64_t max_events,
+                     const uint64_t max_bytes);
+
+  static mutex registry_mutex;
+  static map<string, std::pair<unique_ptr<ColumnarFileSeries>, unsigned int>>
+      registry;
+
+  const string path;
+  const uint64_t max_events;
+  const uint64_t max_bytes;
+  atomic<unsigned int> latest_chunk;
+  atomic<uint64_t> n_events; /**< In the latest chunk. */
+  mutable mutex chunk_mutex;
+  map<unsigned int, string> completed;
+};
@@ -0,0 +1,107 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using std::atomic;
+using std::map;
+using std::mutex;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+#include "ColumnCodec.hh"
+#include "ColumnarFormat.hh"
+
+/**
+ * \brief Columnar output file that is shared by all threads which write to
+ * the same path
+ *
+ * Each thread acquires the file with Acquire() and releases it with Release()
+ * when it is done. The first thread that acquires a path creates the file,
+ * and the last thread that releases it writes the footer and closes it.
+ * Threads append row groups concurrently: the space for a row group is
+ * reserved with an atomic counter, and the data is written with pwrite()
+ * without holding a lock. Only the bookkeeping for the footer is serialized.
+ */
+class ColumnarFileWriter {
+public:
+  /**
+   * \throw std::runtime_error if the file cannot be created.
+   */
+  static ColumnarFileWriter *Acquire(const string &path);
+  /**
+   * \return true if this was the last user, and the file is complete.
+   *
+   * \throw std::runtime_error if the footer cannot be written.
+   */
+  static bool Release(ColumnarFileWriter *file);
+
+  ~ColumnarFileWriter();
+
+  /**
+   * \brief Obtain a unique identifier for the rows written by one thread
+   */
+  uint32_t NewWriter() { return n_writers++; }
+  /**
+   * \brief Register a table and obtain its index in the footer
+   *
+   * Threads register the same tables independently. A table with the same
+   * name as an existing table must have the same schema.
+   *
+   * \throw std::runtime_error if the schemas do not match.
+   */
+  uint32_t DefineTable(const columnar::TableSchema &schema);
+  /**
+   * \throw std::runtime_error if the data cannot be written.
+   */
+  void WriteRowGroup(const uint32_t table, const uint32_t writer,
+                     const uint64_t n_rows,
+                     const vector<columnar::EncodedChunk> &chunks);
+
+  const string &GetPath() const { return path; }
+  /**
+   * \brief Size of the data that has been written so far, without the footer
+   */
+  uint64_t GetSize() const { return end_of_data; }
+
+private:
+  explicit ColumnarFileWriter(const string &path);
+  void WriteAt(const char *data, const size_t size, uint64_t offset);
+  void Finalize();
+
+  static mutex registry_mutex;
+  static map<string, std::pair<unique_ptr<ColumnarFileWriter>, unsigned int>>
+      registry;
+
+  const string path;
+  int file_descriptor;
+  atomic<uint64_t> end_of_data;
+  atomic<uint32_t> n_writers;
+  mutex footer_mutex;
+  columnar::Footer footer;
+};
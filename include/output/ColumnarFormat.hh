@@ -0,0 +1,126 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * \brief Definitions shared by the writer and the reader of the nutr columnar
+ * output format
+ *
+ * A columnar file has the following layout:
+ *
+ *   header       magic number (8 bytes) and format version (8 bytes)
+ *   chunks       encoded column chunks, written by any number of threads
+ *   footer       index of all tables, columns, row groups, and chunks
+ *   trailer      offset and size of the footer and the magic number
+ *
+ * The rows of a table are stored in row groups. A row group contains one
+ * chunk for each column of the table, and all chunks of a row group have the
+ * same number of rows. Each writer (usually one per thread) produces its own
+ * row groups, so the order of the rows in a table is only defined within the
+ * rows of a single writer.
+ *
+ * The footer is written once, when the file is closed. It makes it possible
+ * to read any column of any row group without parsing the rest of the file.
+ * All numbers are stored in little-endian byte order.
+ */
+namespace columnar {
+
+constexpr char magic[8] = {'N', 'U', 'T', 'R', 'C', 'O', 'L', '1'};
+constexpr uint64_t format_version = 1;
+constexpr size_t header_size = 16;
+constexpr size_t trailer_size = 24;
+
+// The writers and readers of the columnar and stream formats copy numbers in
+// the byte order of the machine.
+static_assert(std::endian::native == std::endian::little,
+              "nutr output files are little-endian.");
+
+/**
+ * \brief Data types of columns
+ *
+ * Quantized columns store floating-point values as integer multiples of the
+ * scale of the column, like the channels of an analog-to-digital converter.
+ * The reader converts them back to floating-point values.
+ */
+enum class ColumnType : uint8_t {
+  int32 = 0,
+  float64 = 1,
+  float32 = 2,
+  quantized = 3,
+  int64 = 4
+};
+
+size_t ColumnTypeSize(const ColumnType type);
+bool IsIntegerType(const ColumnType type);
+string ColumnTypeName(const ColumnType type);
+
+struct ColumnSchema {
+  string name;
+  ColumnType type;
+  double scale = 1.; /**< Only stored for quantized columns. */
+
+  bool operator==(const ColumnSchema &) const = default;
+};
+
+struct TableSchema {
+  string name;
+  string title;
+  vector<ColumnSchema> columns;
+
+  bool operator==(const TableSchema &) const = default;
+};
+
+struct ChunkInfo {
+  uint64_t offset;       /**< Position of the chunk in the file. */
+  uint64_t stored_size;  /**< Size of the chunk in the file. */
+  uint64_t encoded_size; /**< Size before general-purpose compression. */
+  uint8_t codec;         /**< See ColumnCodec.hh. */
+};
+
+struct RowGroupInfo {
+  uint32_t table;
+  uint32_t writer;
+  uint64_t n_rows;
+  vector<ChunkInfo> chunks; /**< One chunk per column of the table. */
+};
+
+struct Footer {
+  vector<TableSchema> tables;
+  vector<RowGroupInfo> row_groups;
+};
+
+string SerializeFooter(const Footer &footer);
+/**
+ * \brief Parse a serialized footer
+ *
+ * \throw std::runtime_error if the footer is corrupt.
+ */
+Footer ParseFooter(const uint8_t *data, const size_t size);
+
+} // namespace columnar
@@ -0,0 +1,122 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#include "ColumnarFileSeries.hh"
+#include "ColumnarFileWriter.hh"
+#include "ColumnarFormat.hh"
+#include "OutputBackend.hh"
+
+/**
+ * \brief Output backend for the nutr columnar format
+ *
+ * The rows of each thread are buffered column by column and written to the
+ * shared ColumnarFileWriter as a row group whenever the buffer of a table
+ * reaches row_group_bytes, and when the file is closed.
+ * As in G4AnalysisManager, the value of a column is kept for the next row if
+ * it is not filled again.
+ *
+ * If a rotation limit is set with SetRotation() before the file is opened,
+ * the output is written to a ColumnarFileSeries instead of a single file.
+ * Each chunk is only created when the first event is written to it.
+ */
+class ColumnarOutputBackend : public OutputBackend {
+public:
+  ColumnarOutputBackend()
+      : file(nullptr), writer(0), max_events(0), max_bytes(0),
+        series(nullptr), chunk(0){};
+  ~ColumnarOutputBackend() override;
+
+  void OpenFile(const string &file_name) override;
+  int CreateNtuple(const string &name, const string &title) override;
+  int CreateNtupleIColumn(const string &name) override;
+  int CreateNtupleLColumn(const string &name) override;
+  using OutputBackend::CreateNtupleDColumn;
+  int CreateNtupleDColumn(const string &name,
+                          const ColumnPrecision precision) override;
+  void FinishNtuple() override;
+
+  bool FillNtupleIColumn(const int ntuple, const int column,
+                         const int value) override;
+  bool FillNtupleLColumn(const int ntuple, const int column,
+                         const int64_t value) override;
+  bool FillNtupleDColumn(const int ntuple, const int column,
+                         const double value) override;
+  bool AddNtupleRow(const int ntuple = 0) override;
+  void NewEvent() override;
+
+  void Write() override;
+  void CloseFile() override;
+  string GetFileName() const override { return file_name; }
+  vector<string> GetFileNames() const override;
+
+  /**
+   * \brief Start a new output file after max_events events or max_bytes
+   * bytes, where 0 means no limit
+   */
+  void SetRotation(const uint64_t _max_events, const uint64_t _max_bytes) {
+    max_events = _max_events;
+    max_bytes = _max_bytes;
+  }
+
+  static constexpr size_t row_group_bytes = 8 * 1024 * 1024;
+  static constexpr size_t min_row_group_bytes = 64 * 1024;
+
+private:
+  struct Column {
+    int64_t integer;
+    double floating_point;
+    vector<int64_t> integers; /**< Also used for quantized values. */
+    vector<double> doubles;
+    vector<float> floats;
+  };
+  struct Table {
+    columnar::TableSchema schema;
+    uint32_t id;
+    uint64_t n_rows;
+    uint64_t rows_per_group;
+    vector<Column> columns;
+  };
+
+  int CreateColumn(const columnar::ColumnSchema &schema);
+  Column *GetColumn(const int ntuple, const int column,
+                    const bool floating_point);
+  void Flush(Table &table);
+  void OpenChunk();
+  void ReleaseFile();
+
+  string file_name;
+  ColumnarFileWriter *file;
+  uint32_t writer;
+  vector<Table> tables;
+
+  uint64_t max_events;
+  uint64_t max_bytes;
+  ColumnarFileSeries *series;
+  unsigned int chunk;
+  vector<string> completed_file_names;
+};
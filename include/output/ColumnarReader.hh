@@ -0,0 +1,107 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#include "ColumnarFormat.hh"
+
+/**
+ * \brief Reader for files in the nutr columnar format
+ *
+ * The file is mapped into memory, and only the footer is parsed when it is
+ * opened. Column chunks are decoded on request, so reading a single column
+ * of a large file only touches the pages of that column.
+ * A reader can be used by several threads at the same time.
+ */
+class ColumnarReader {
+public:
+  /**
+   * \throw std::runtime_error if the file cannot be opened or is not a
+   * valid columnar file, e.g. because it was not closed properly.
+   */
+  explicit ColumnarReader(const string &path);
+  ~ColumnarReader();
+  ColumnarReader(const ColumnarReader &) = delete;
+  ColumnarReader &operator=(const ColumnarReader &) = delete;
+
+  const vector<columnar::TableSchema> &GetTables() const {
+    return footer.tables;
+  }
+  /**
+   * \throw std::runtime_error if the table does not exist.
+   */
+  size_t GetTableID(const string &name) const;
+  size_t GetColumnID(const size_t table, const string &name) const;
+  uint64_t GetNumberOfRows(const size_t table) const;
+  /**
+   * \brief Indices of the row groups of a table in the footer
+   */
+  vector<size_t> GetRowGroups(const size_t table) const;
+  const columnar::RowGroupInfo &GetRowGroup(const size_t row_group) const {
+    return footer.row_groups.at(row_group);
+  }
+  /**
+   * \brief Encoded bytes of a column chunk, as stored in the file
+   *
+   * Used to copy chunks to another file without decoding them.
+   */
+  const uint8_t *GetChunkData(const columnar::ChunkInfo &chunk) const {
+    return data + chunk.offset;
+  }
+  const string &GetPath() const { return path; }
+
+  /**
+   * \brief Append the values of a column to values
+   *
+   * The first two overloads read all row groups of the table, the others read
+   * a single row group. Integer values can only be read from integer columns,
+   * while floating-point values can be read from any column. Quantized
+   * columns are converted back to their original units.
+   *
+   * \throw std::runtime_error if the column does not exist, if the column type
+   * does not match, or if the data is corrupt.
+   */
+  void ReadColumn(const size_t table, const size_t column,
+                  vector<int64_t> &values) const;
+  void ReadColumn(const size_t table, const size_t column,
+                  vector<double> &values) const;
+  void ReadColumn(const size_t row_group, const size_t table,
+                  const size_t column, vector<int64_t> &values) const;
+  void ReadColumn(const size_t row_group, const size_t table,
+                  const size_t column, vector<double> &values) const;
+
+private:
+  const columnar::ChunkInfo &GetChunk(const size_t row_group,
+                                      const size_t table,
+                                      const size_t column) const;
+
+  string path;
+  int file_descriptor;
+  const uint8_t *data;
+  size_t size;
+  columnar::Footer footer;
+};
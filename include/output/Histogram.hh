@@ -0,0 +1,147 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * \brief Histogram with one or two axes that accumulates the sum of the
+ * weights and the sum of the squared weights of each bin
+ *
+ * The statistical uncertainty of the content of a bin is the square root of
+ * the sum of the squared weights, which is also correct for weighted events,
+ * for example from a variance reduction technique.
+ *
+ * Each axis has n_bins bins of equal width between min and max, plus an
+ * underflow bin (index 0) and an overflow bin (index n_bins + 1).
+ * Histograms are filled by a single thread. The histograms of several threads
+ * are combined with Add().
+ */
+class Histogram {
+public:
+  struct Axis {
+    string name;
+    size_t n_bins;
+    double min;
+    double max;
+
+    size_t Bin(const double x) const;
+    /**
+     * \brief Lower edge of a bin, -infinity for the underflow bin
+     */
+    double LowEdge(const size_t bin) const;
+    /**
+     * \brief Upper edge of a bin, infinity for the overflow bin
+     */
+    double HighEdge(const size_t bin) const;
+    bool operator==(const Axis &other) const {
+      return name == other.name && n_bins == other.n_bins &&
+             min == other.min && max == other.max;
+    }
+  };
+
+  /**
+   * \throw std::runtime_error if an axis has no bins or an empty range.
+   */
+  Histogram(const string &name, const vector<Axis> &axes);
+
+  void Fill(const double x, const double weight = 1.) {
+    FillCell(axes[0].Bin(x), weight);
+  }
+  void Fill(const double x, const double y, const double weight) {
+    FillCell(axes[0].Bin(x) + (axes[0].n_bins + 2) * axes[1].Bin(y), weight);
+  }
+  /**
+   * \brief Add a weight to a cell directly, for example the sum of a batch
+   * of events in a batch-statistics estimate
+   */
+  void FillCell(const size_t cell, const double weight) {
+    ++entries[cell];
+    sum_weights[cell] += weight;
+    sum_squared_weights[cell] += weight * weight;
+  }
+  /**
+   * \throw std::runtime_error if the histograms have different axes.
+   */
+  void Add(const Histogram &other);
+  /**
+   * \brief Add empty entries to each cell until it has n_entries entries
+   *
+   * For example, a spectrum of a batch-statistics estimate that one thread
+   * did not create is padded with the empty batches of that thread.
+   */
+  void PadEntries(const uint64_t n_entries);
+
+  const string &GetName() const { return name; }
+  const vector<Axis> &GetAxes() const { return axes; }
+  /**
+   * \brief Number of cells, i.e. the product of the numbers of bins of all
+   * axes including underflow and overflow
+   */
+  size_t GetNumberOfCells() const { return sum_weights.size(); }
+  /**
+   * \brief Bin of a cell on an axis
+   */
+  size_t GetBin(const size_t cell, const size_t axis) const;
+  uint64_t GetEntries(const size_t cell) const { return entries[cell]; }
+  double GetSumWeights(const size_t cell) const { return sum_weights[cell]; }
+  double GetSumSquaredWeights(const size_t cell) const {
+    return sum_squared_weights[cell];
+  }
+
+private:
+  string name;
+  vector<Axis> axes;
+  vector<uint64_t> entries;
+  vector<double> sum_weights;
+  vector<double> sum_squared_weights;
+};
+
+/**
+ * \brief Storage of histograms in the native columnar format of nutr
+ *
+ * Each histogram is a table with the name of the histogram and one row per
+ * cell, including underflow and overflow. The row contains the lower and
+ * upper edges of the cell on each axis (columns 'AXIS_low' and 'AXIS_high'),
+ * the number of entries ('entries'), the sum of the weights ('sumw'), and the
+ * sum of the squared weights ('sumw2'). The file can be read with nutr_dump
+ * and ColumnarReader like any other output file.
+ */
+namespace histogram {
+
+constexpr char extension[] = ".hist.nutr";
+
+/**
+ * \brief Name of the histogram file for an output file name, i.e. the file
+ * name with the suffix replaced by '.hist.nutr'
+ */
+string HistogramFileName(const string &output_file_name);
+/**
+ * \throw std::runtime_error if the file cannot be written.
+ */
+void Write(const string &path, const vector<Histogram> &histograms);
+
+} // namespace histogram
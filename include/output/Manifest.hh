@@ -0,0 +1,76 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * \brief Manifest of the output files that belong to one logical dataset
+ *
+ * If the output of the threads is not merged, each thread writes its own file
+ * and the master thread writes a manifest that lists them. The manifest is a
+ * text file with a header line, followed by one line 'file NAME' per output
+ * file. Names are relative to the directory of the manifest, so that a
+ * dataset can be moved as a whole.
+ */
+namespace manifest {
+
+constexpr char header[] = "# nutr output manifest 1";
+constexpr char extension[] = ".manifest";
+
+/**
+ * \brief Name of the manifest for an output file name, i.e. the file name
+ * with the suffix replaced by '.manifest'
+ */
+string ManifestFileName(const string &output_file_name);
+/**
+ * \brief Name of the output file of a thread, i.e. the file name with '_tN'
+ * inserted before the suffix, like in Geant4
+ */
+string ThreadFileName(const string &output_file_name, const int thread_id);
+/**
+ * \brief Name of a file in a sequence of files, i.e. the file name with '_cN'
+ * inserted before the suffix
+ */
+string ChunkFileName(const string &output_file_name, const unsigned int chunk);
+
+/**
+ * \brief Write a manifest
+ *
+ * The manifest is replaced atomically, so it can be updated while other
+ * processes read it.
+ *
+ * \throw std::runtime_error if the manifest cannot be written.
+ */
+void Write(const string &path, const vector<string> &files);
+/**
+ * \brief Read a manifest
+ *
+ * \return Paths of the files, relative to the current working directory.
+ *
+ * \throw std::runtime_error if the manifest cannot be read or is invalid.
+ */
+vector<string> Read(const string &path);
+
+} // namespace manifest
@@ -0,0 +1,125 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::pair;
+using std::string;
+using std::vector;
+
+/**
+ * \brief Precision with which the values of a floating-point column are
+ * stored
+ *
+ * Quantized values are rounded to the nearest multiple of the least
+ * significant bit (lsb), like the channels of an analog-to-digital converter.
+ * The lsb is given in the internal units of Geant4.
+ */
+struct ColumnPrecision {
+  enum Type { float64, float32, quantized };
+
+  Type type = float64;
+  double lsb = 1.;
+};
+
+/**
+ * \brief Interface for writing ntuples to an output file
+ *
+ * The methods are named after their counterparts in G4AnalysisManager, so
+ * that the code which defines and fills the ntuples does not depend on the
+ * output format. Each thread owns its own backend.
+ *
+ * The precision of floating-point columns can be reduced by name with
+ * SetPrecision(). Columns are still filled with FillNtupleDColumn(), and the
+ * backend converts the values.
+ */
+class OutputBackend {
+public:
+  virtual ~OutputBackend() = default;
+
+  virtual void OpenFile(const string &file_name) = 0;
+  virtual int CreateNtuple(const string &name, const string &title) = 0;
+  virtual int CreateNtupleIColumn(const string &name) = 0;
+  /**
+   * \brief Create a column of 64-bit integers
+   *
+   * Geant4 ntuples have no such column type, see G4OutputBackend.
+   */
+  virtual int CreateNtupleLColumn(const string &name) = 0;
+  int CreateNtupleDColumn(const string &name) {
+    return CreateNtupleDColumn(name, GetPrecision(name));
+  }
+  virtual int CreateNtupleDColumn(const string &name,
+                                  const ColumnPrecision precision) = 0;
+  virtual void FinishNtuple() = 0;
+
+  virtual bool FillNtupleIColumn(const int ntuple, const int column,
+                                 const int value) = 0;
+  virtual bool FillNtupleLColumn(const int ntuple, const int column,
+                                 const int64_t value) = 0;
+  virtual bool FillNtupleDColumn(const int ntuple, const int column,
+                                 const double value) = 0;
+  virtual bool AddNtupleRow(const int ntuple = 0) = 0;
+  /**
+   * \brief Called before the first row of each event
+   *
+   * Backends that split the output into several files only do so at event
+   * boundaries.
+   */
+  virtual void NewEvent() {}
+
+  virtual void Write() = 0;
+  virtual void CloseFile() = 0;
+  virtual string GetFileName() const = 0;
+  /**
+   * \brief Names of the files that this backend actually writes, which may
+   * differ from GetFileName() if the output of the threads is not merged
+   */
+  virtual vector<string> GetFileNames() const { return {GetFileName()}; }
+
+  /**
+   * \brief Set the precision of all floating-point columns whose name matches
+   * the pattern
+   *
+   * A pattern that ends with '*' matches all names which start with the rest
+   * of the pattern. If several patterns match a column, the last one that was
+   * set is used. Must be called before the columns are created.
+   */
+  void SetPrecision(const string &pattern, const ColumnPrecision precision) {
+    precisions.push_back({pattern, precision});
+  }
+  ColumnPrecision GetPrecision(const string &column_name) const;
+
+  /**
+   * \brief Channel of a quantized value
+   *
+   * Values beyond max_channel channels are clamped, so that the difference
+   * of two channels cannot overflow either. NaN is mapped to channel 0.
+   */
+  static int64_t Quantize(const double value, const double lsb);
+  static constexpr double max_channel = 4611686018427387904.; /**< 2^62 */
+
+private:
+  vector<pair<string, ColumnPrecision>> precisions;
+};
@@ -0,0 +1,71 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * \brief Directory of simulation results, indexed by the hash of their
+ * configuration (see RunMetadata)
+ *
+ * Each entry is a directory named after the hash, which contains a copy of
+ * the files of a result. The files of an entry are renamed as if the output
+ * file name had been 'result', so that a result can be restored under any
+ * output file name. Manifests are rewritten accordingly.
+ *
+ * An entry is written to a temporary directory and renamed when it is
+ * complete, so several processes can share a cache.
+ */
+class ResultCache {
+public:
+  explicit ResultCache(const string &_directory);
+
+  string GetEntry(const string &hash) const;
+  /**
+   * \brief Copy the files of an entry to the names that belong to an output
+   * file name
+   *
+   * \return Names of the restored files, or an empty list if there is no
+   * entry for the hash.
+   *
+   * \throw std::runtime_error if the files cannot be copied.
+   */
+  vector<string> Restore(const string &hash,
+                         const string &output_file_name) const;
+  /**
+   * \brief Store a copy of the files of a result
+   *
+   * All files must start with the stem of the output file name. If an entry
+   * for the hash already exists, it is kept.
+   *
+   * \throw std::runtime_error if the files cannot be copied.
+   */
+  void Store(const string &hash, const string &output_file_name,
+             const vector<string> &files) const;
+
+  static constexpr char entry_stem[] = "result";
+
+private:
+  string directory;
+};
@@ -0,0 +1,94 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::pair;
+using std::string;
+using std::vector;
+
+/**
+ * \brief Metadata sidecar of a simulation result
+ *
+ * The configuration of a simulation (build options, executable, seed, macro,
+ * ...) is set once at startup as a list of named values. Its hash identifies
+ * simulations that produce the same result, for example in a ResultCache.
+ * At the end of each run, the master thread writes the configuration, its
+ * hash, and the list of output files to the JSON file OUTPUT.meta.json next
+ * to the output.
+ *
+ * The configuration is only set and the sidecar is only written by the main
+ * (master) thread.
+ */
+class RunMetadata {
+public:
+  using Configuration = vector<pair<string, string>>;
+
+  static constexpr char extension[] = ".meta.json";
+
+  /**
+   * \brief 64-bit FNV-1a hash of the names and values of a configuration
+   */
+  static uint64_t Hash(const Configuration &configuration);
+  /**
+   * \brief 64-bit FNV-1a hash of the content of a file
+   *
+   * \throw std::runtime_error if the file cannot be read.
+   */
+  static uint64_t HashFile(const string &path);
+  static string HashToString(const uint64_t hash);
+
+  static void SetConfiguration(const Configuration &_configuration);
+  static bool IsConfigured() { return !configuration.empty(); }
+  static const Configuration &GetConfiguration() { return configuration; }
+  static string GetHash() { return hash; }
+
+  /**
+   * \brief Name of the sidecar of an output file, i.e. the file name with the
+   * suffix replaced by '.meta.json'
+   */
+  static string MetadataFileName(const string &output_file_name);
+  /**
+   * \brief Write the sidecar of an output file
+   *
+   * \param _files Files of the result, which are listed relative to the
+   * sidecar.
+   * \param cache_entry Entry of the ResultCache from which the files were
+   * restored, if any.
+   *
+   * \throw std::runtime_error if the sidecar cannot be written.
+   */
+  static void Write(const string &output_file_name,
+                    const vector<string> &_files,
+                    const string &cache_entry = "");
+  /**
+   * \brief Files listed in the last sidecar that was written
+   */
+  static const vector<string> &GetFiles() { return files; }
+
+private:
+  inline static Configuration configuration;
+  inline static string hash;
+  inline static vector<string> files;
+};
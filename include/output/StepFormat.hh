@@ -0,0 +1,93 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+using std::string;
+
+#include "TrackFormat.hh"
+
+/**
+ * \brief Definitions shared by the writer and the reader of the step-point
+ * format
+ *
+ * The step-point scorer (see /analysis/scorer) records only the steps with an
+ * energy deposition in a sensitive volume, with the minimum information that
+ * is needed to apply a detector response after the simulation: the detector,
+ * the position in the frame of its volume, the depth below the surface of the
+ * volume (see ChargeCollection), the deposited energy, and the time. The
+ * points of each event are stored in a block, with the same framing and the
+ * same integer encodings as the track format (see TrackFormat.hh):
+ *
+ *   size         size of the rest of the block (uint32)
+ *   event_id     global event ID (int64)
+ *   run_id       run ID (int32)
+ *   t0           time of the first point (float64)
+ *   n_points     number of points (varint)
+ *   points       per point, see below
+ *
+ * Each point is stored as:
+ *
+ *   detector     detector ID (varint)
+ *   position     local position in channels of position_lsb (3 x zigzag
+ *                varint)
+ *   depth        depth in channels of position_lsb (varint)
+ *   edep         deposited energy (float32)
+ *   time         time, minus the decoded time of the previous point of the
+ *                event, in channels of time_lsb (zigzag varint)
+ *
+ * For the first point, the previous time is t0. As in the track format, a
+ * difference that does not fit into 64-bit channels, for example across a
+ * radioactive decay with a long lifetime, is escaped (see
+ * track_format::PutTime()).
+ *
+ * With the default position_lsb of 0.1 mm, a point in a crystal of a few
+ * centimeters takes about 14 bytes.
+ *
+ * The file starts with a header of header_size bytes: the magic bytes, the
+ * format version (uint64), and position_lsb and time_lsb (float64) in the
+ * internal units of Geant4. A block of size zero ends the file. All numbers
+ * are stored in little-endian byte order.
+ */
+namespace step_format {
+
+constexpr char magic[8] = {'N', 'U', 'T', 'R', 'S', 'T', 'P', '1'};
+constexpr uint64_t format_version = 1;
+constexpr size_t header_size = 32;
+constexpr char extension[] = ".nutrstp";
+
+constexpr double default_position_lsb = 0.1; /**< 0.1 mm */
+constexpr double default_time_lsb = track_format::default_time_lsb;
+
+/**
+ * \brief Name of the step-point file for an output file name, i.e. the file
+ * name with the suffix replaced by '.nutrstp'
+ */
+inline string StepFileName(const string &output_file_name) {
+  return std::filesystem::path(output_file_name)
+      .replace_extension(extension)
+      .string();
+}
+
+} // namespace step_format
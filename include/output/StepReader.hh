@@ -0,0 +1,88 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using std::ifstream;
+using std::string;
+using std::vector;
+
+/**
+ * \brief Sequential reader of the step-point format (see StepFormat.hh)
+ *
+ * Decodes the blocks of a step-point file event by event. Blocks can also be
+ * skipped without decoding them, so that several readers of the same file
+ * can share its events.
+ */
+class StepReader {
+public:
+  struct Point {
+    uint32_t detector_id;
+    double position[3]; /**< In the frame of the detector volume. */
+    double depth;
+    double edep;
+    double time;
+  };
+  struct Event {
+    int64_t event_id;
+    int32_t run_id;
+    vector<Point> points;
+  };
+
+  /**
+   * \throw std::runtime_error if the file cannot be opened or is not a
+   * step-point file of a supported version.
+   */
+  explicit StepReader(const string &path);
+
+  /**
+   * \brief Decode the next event
+   *
+   * \return false at the end of the file, which may also be a file that is
+   * still being written.
+   *
+   * \throw std::runtime_error if a block is invalid.
+   */
+  bool Next(Event &event);
+  /**
+   * \brief Skip the next event
+   *
+   * \return false at the end of the file.
+   */
+  bool Skip();
+
+  double GetPositionLSB() const { return lsbs[0]; }
+  double GetTimeLSB() const { return lsbs[1]; }
+
+private:
+  /**
+   * \return The size of the next block, or 0 at the end of the file.
+   */
+  uint32_t NextBlockSize();
+
+  string path;
+  ifstream file;
+  double lsbs[2]; /**< Of the position and the time. */
+  string block;
+};
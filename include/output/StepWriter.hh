@@ -0,0 +1,87 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#include "TrackFileWriter.hh"
+
+/**
+ * \brief Writer of the step-point format (see StepFormat.hh) for one thread
+ *
+ * The points of an event are collected and encoded as a block at the end of
+ * the event. As in the TrackOutputBackend, the blocks are written to a
+ * TrackFileWriter, which is shared by all threads with the same path, in
+ * batches of about batch_bytes.
+ */
+class StepWriter {
+public:
+  StepWriter() : file(nullptr), position_lsb(1.), time_lsb(1.){};
+  ~StepWriter();
+
+  /**
+   * \throw std::runtime_error if the file cannot be created, or if another
+   * thread uses different least significant bits.
+   */
+  void Open(const string &path, const double position_lsb,
+            const double time_lsb);
+  bool IsOpen() const { return file != nullptr; }
+  /**
+   * \param position Position in the frame of the detector volume.
+   */
+  void Add(const uint32_t detector_id, const double position[3],
+           const double depth, const double edep, const double time) {
+    points.push_back(Point{detector_id,
+                           {position[0], position[1], position[2]},
+                           depth,
+                           static_cast<float>(edep),
+                           time});
+  }
+  /**
+   * \brief Encode the points of an event, if there are any
+   */
+  void FinishEvent(const int64_t event_id, const int32_t run_id);
+  /**
+   * \brief Write all remaining blocks and release the file
+   */
+  void Close();
+
+  static constexpr size_t batch_bytes = 64 * 1024;
+
+private:
+  struct Point {
+    uint32_t detector_id;
+    double position[3];
+    double depth;
+    float edep;
+    double time;
+  };
+
+  TrackFileWriter *file;
+  double position_lsb;
+  double time_lsb;
+  vector<Point> points; /**< Points of the current event. */
+  string batch;
+};
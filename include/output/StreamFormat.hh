@@ -0,0 +1,64 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ColumnarFormat.hh"
+
+/**
+ * \brief Definitions shared by the writer and the reader of the nutr stream
+ * format
+ *
+ * A stream is a sequence of runs. Each run starts with a header, which
+ * describes the tables in the same way as the footer of a columnar file:
+ *
+ *   magic        8 bytes
+ *   size         size of the schema (uint32)
+ *   schema       see columnar::SerializeFooter (without row groups)
+ *
+ * The header is followed by records. Each record contains the rows of a
+ * single event in one table:
+ *
+ *   size         size of the rest of the record (uint32)
+ *   table        index of the table in the schema (uint32)
+ *   n_rows       number of rows (uint32)
+ *   rows         values of the rows, one row after the other
+ *
+ * The values of a row are stored in the order of the columns, with the sizes
+ * given by columnar::ColumnTypeSize(). Quantized columns contain the channel
+ * as a 64-bit integer. A record of size zero ends the run. All numbers are
+ * stored in little-endian byte order.
+ */
+namespace stream {
+
+constexpr char magic[8] = {'N', 'U', 'T', 'R', 'S', 'T', 'R', '1'};
+constexpr size_t record_header_size = 3 * sizeof(uint32_t);
+
+inline size_t RowSize(const columnar::TableSchema &table) {
+  size_t size = 0;
+  for (const auto &column : table.columns) {
+    size += columnar::ColumnTypeSize(column.type);
+  }
+  return size;
+}
+
+} // namespace stream
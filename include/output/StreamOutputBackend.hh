@@ -0,0 +1,91 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#include "ColumnarFormat.hh"
+#include "OutputBackend.hh"
+#include "StreamWriter.hh"
+
+/**
+ * \brief Output backend that sends the rows of each event as a record to a
+ * StreamWriter, instead of writing them to a file
+ *
+ * The records of a thread are collected in batches of about batch_bytes,
+ * which are submitted at the beginning of the next event. As in
+ * G4AnalysisManager, the value of a column is kept for the next row if it is
+ * not filled again.
+ */
+class StreamOutputBackend : public OutputBackend {
+public:
+  StreamOutputBackend() : stream(nullptr){};
+  ~StreamOutputBackend() override;
+
+  void OpenFile(const string &file_name) override;
+  int CreateNtuple(const string &name, const string &title) override;
+  int CreateNtupleIColumn(const string &name) override;
+  int CreateNtupleLColumn(const string &name) override;
+  using OutputBackend::CreateNtupleDColumn;
+  int CreateNtupleDColumn(const string &name,
+                          const ColumnPrecision precision) override;
+  void FinishNtuple() override;
+
+  bool FillNtupleIColumn(const int ntuple, const int column,
+                         const int value) override;
+  bool FillNtupleLColumn(const int ntuple, const int column,
+                         const int64_t value) override;
+  bool FillNtupleDColumn(const int ntuple, const int column,
+                         const double value) override;
+  bool AddNtupleRow(const int ntuple = 0) override;
+  void NewEvent() override;
+
+  void Write() override;
+  void CloseFile() override;
+  string GetFileName() const override { return file_name; }
+  vector<string> GetFileNames() const override { return {}; }
+
+  static constexpr size_t batch_bytes = 64 * 1024;
+
+private:
+  struct Table {
+    columnar::TableSchema schema;
+    uint32_t id;
+    vector<int64_t> integers;       /**< Current value of each column. */
+    vector<double> floating_points; /**< Current value of each column. */
+    uint32_t n_rows;                /**< Rows of the current event. */
+    string rows;
+  };
+
+  int CreateColumn(const columnar::ColumnSchema &schema);
+  bool CheckColumn(const int ntuple, const int column,
+                   const bool floating_point) const;
+  void FinishRecords();
+
+  string file_name;
+  StreamWriter *stream;
+  vector<Table> tables;
+  string batch;
+};
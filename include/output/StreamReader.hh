@@ -0,0 +1,93 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#include "ColumnarFormat.hh"
+
+/**
+ * \brief Reader for the nutr stream format (see StreamFormat.hh)
+ *
+ * Reads runs and records sequentially from a file descriptor, for example
+ * the standard input, a named pipe, or a socket.
+ */
+class StreamReader {
+public:
+  struct Record {
+    uint32_t table;
+    uint32_t n_rows;
+    string rows;
+  };
+
+  explicit StreamReader(const int file_descriptor);
+
+  /**
+   * \brief Read the header of the next run
+   *
+   * \return false at the end of the stream.
+   *
+   * \throw std::runtime_error if the data is not a nutr stream or if the
+   * stream ends in the middle of a header.
+   */
+  bool NextRun();
+  const vector<columnar::TableSchema> &GetTables() const { return tables; }
+  /**
+   * \brief Read the next record of the current run
+   *
+   * \return false at the end of the run.
+   *
+   * \throw std::runtime_error if the record is invalid or incomplete.
+   */
+  bool NextRecord(Record &record);
+  /**
+   * \brief Value of a column in a row of a record
+   *
+   * Quantized values are converted back to their original units.
+   */
+  double GetValue(const Record &record, const size_t row,
+                  const size_t column) const;
+  /**
+   * \brief Exact value of an integer column in a row of a record
+   */
+  int64_t GetInteger(const Record &record, const size_t row,
+                     const size_t column) const;
+
+private:
+  /**
+   * \return false if the stream ends before the first byte.
+   */
+  bool Read(char *data, const size_t size);
+  uint32_t ReadUInt32();
+
+  int file_descriptor;
+  vector<char> buffer;
+  size_t buffer_begin;
+  size_t buffer_end;
+  vector<columnar::TableSchema> tables;
+  vector<size_t> row_sizes;
+  vector<vector<size_t>> column_offsets;
+};
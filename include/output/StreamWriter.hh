@@ -0,0 +1,128 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::condition_variable;
+using std::deque;
+using std::map;
+using std::mutex;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+#include "ColumnarFormat.hh"
+
+/**
+ * \brief Output stream in the nutr stream format (see StreamFormat.hh) that
+ * is shared by all threads which write to the same destination
+ *
+ * The destination is either '-' for the standard output, 'unix:PATH' for a
+ * Unix domain socket on which a consumer listens, or the path of a named
+ * pipe. Threads submit complete records, which a writer thread sends to the
+ * destination in the order in which they were submitted. At most
+ * max_queued_batches batches are queued, so threads block in Submit() if the
+ * consumer is slower than the simulation.
+ *
+ * The header is sent before the first record, so all tables have to be
+ * defined before any thread submits a record.
+ */
+class StreamWriter {
+public:
+  /**
+   * \throw std::runtime_error if the destination cannot be opened.
+   */
+  static StreamWriter *Acquire(const string &destination);
+  /**
+   * \brief Release the stream, and end the run if this was the last user
+   *
+   * \throw std::runtime_error if writing to the destination failed.
+   */
+  static void Release(StreamWriter *stream);
+
+  /**
+   * \brief Whether an output file name refers to a stream destination
+   */
+  static bool IsStream(const string &destination);
+  /**
+   * \brief Reserve the standard output for the stream, and redirect all
+   * other output to the standard error
+   *
+   * Should be called before anything else is printed, because text on the
+   * standard output would corrupt the stream. Called automatically when the
+   * standard output is opened as a stream for the first time.
+   */
+  static void ReserveStandardOutput();
+
+  ~StreamWriter();
+
+  /**
+   * \brief Register a table and obtain its index in the header
+   *
+   * \throw std::runtime_error if the schemas do not match, or if the header
+   * has already been sent.
+   */
+  uint32_t DefineTable(const columnar::TableSchema &schema);
+  /**
+   * \brief Queue complete records for sending
+   *
+   * Blocks while the queue is full.
+   *
+   * \throw std::runtime_error if writing to the destination failed.
+   */
+  void Submit(string &&records);
+
+  const string &GetDestination() const { return destination; }
+
+  static constexpr size_t max_queued_batches = 64;
+
+private:
+  explicit StreamWriter(const string &destination);
+  void Run();
+  void Queue(string &&data);
+  void QueueHeader();
+
+  static mutex registry_mutex;
+  static map<string, std::pair<unique_ptr<StreamWriter>, unsigned int>>
+      registry;
+  static int standard_output;
+
+  const string destination;
+  int file_descriptor;
+  bool owns_file_descriptor;
+
+  mutex queue_mutex;
+  condition_variable queue_changed;
+  deque<string> queue;
+  vector<columnar::TableSchema> tables;
+  bool header_queued;
+  bool closing;
+  string error;
+  std::thread thread;
+};
@@ -0,0 +1,101 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+using std::atomic;
+using std::map;
+using std::mutex;
+using std::string;
+using std::unique_ptr;
+
+/**
+ * \brief Track file (see TrackFormat.hh) that is shared by all threads which
+ * write to the same path
+ *
+ * Also writes the step-point files (see StepFormat.hh), which consist of
+ * blocks in the same way, only with a different header.
+ *
+ * As for a ColumnarFileWriter, the first thread that acquires a path creates
+ * the file, and the last thread that releases it closes it. Threads append
+ * batches of blocks concurrently: the space for a batch is reserved with an
+ * atomic counter, and the data is written with pwrite() without holding a
+ * lock.
+ */
+class TrackFileWriter {
+public:
+  /**
+   * \throw std::runtime_error if the file cannot be created.
+   */
+  static TrackFileWriter *Acquire(const string &path);
+  static void Release(TrackFileWriter *file);
+
+  ~TrackFileWriter();
+
+  /**
+   * \brief Set the least significant bits of the quantized values and write
+   * the header
+   *
+   * All threads must use the same values.
+   *
+   * \throw std::runtime_error if the values differ from the ones of another
+   * thread, or if the header cannot be written.
+   */
+  void SetQuantization(const double time_lsb, const double edep_lsb,
+                       const double ekin_lsb);
+  /**
+   * \brief Write the header of the file, which must be the same for all
+   * threads
+   *
+   * \throw std::runtime_error if the header differs from the one of another
+   * thread, or if it cannot be written.
+   */
+  void SetHeader(const string &header);
+  /**
+   * \brief Append blocks to the file, which is only allowed after the
+   * header has been set
+   *
+   * \throw std::runtime_error if the data cannot be written.
+   */
+  void WriteBlocks(const string &blocks);
+
+  const string &GetPath() const { return path; }
+
+private:
+  explicit TrackFileWriter(const string &path);
+  void WriteAt(const char *data, const size_t size, uint64_t offset);
+
+  static mutex registry_mutex;
+  static map<string, std::pair<unique_ptr<TrackFileWriter>, unsigned int>>
+      registry;
+
+  const string path;
+  int file_descriptor;
+  atomic<uint64_t> end_of_data;
+  mutex header_mutex;
+  bool has_header;
+  string header;
+};
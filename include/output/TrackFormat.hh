@@ -0,0 +1,189 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+using std::string;
+
+/**
+ * \brief Definitions shared by the writer and the reader of the compact track
+ * format of the tracker sensitive detector
+ *
+ * The tracker sensitive detector writes one row per step, which is dominated
+ * by repeated track information and by positions that only change a little
+ * from one step to the next. The track format stores the steps of each event
+ * in a block, with the tracks of the event in a dictionary:
+ *
+ *   size         size of the rest of the block (uint32)
+ *   event_id     global event ID (int64)
+ *   run_id       run ID (int32)
+ *   t0           time of the first step (float64)
+ *   n_tracks     number of tracks (varint)
+ *   tracks       per track: track ID (varint), PDG code (zigzag varint)
+ *   n_steps      number of steps (varint)
+ *   steps        per step, see below
+ *
+ * Each step is stored as:
+ *
+ *   track        index of the track in the dictionary (varint)
+ *   detector     detector ID (zigzag varint)
+ *   time         time, minus the decoded time of the previous step of the
+ *                same track, in channels of time_lsb (zigzag varint)
+ *   edep         deposited energy in channels of edep_lsb (zigzag varint)
+ *   ekin         kinetic energy in channels of ekin_lsb (zigzag varint)
+ *   position     position, minus the decoded position of the previous step
+ *                of the same track (3 x float32)
+ *   momentum     momentum (3 x float32)
+ *
+ * For the first step of a track, the previous time is t0 and the previous
+ * position is zero. Since the differences refer to the decoded times and
+ * positions, rounding errors do not accumulate along a track. After a
+ * radioactive decay with a long lifetime, a time difference may not fit into
+ * 64-bit channels of time_lsb. It is then replaced by the varint time_escape,
+ * followed by the time itself (float64), see PutTime().
+ *
+ * The file starts with a header of header_size bytes: the magic bytes, the
+ * format version (uint64), and time_lsb, edep_lsb, and ekin_lsb (float64) in
+ * the internal units of Geant4. The blocks follow without an index, so a file
+ * can be read as far as it was written. A block of size zero ends the file.
+ * All numbers are stored in little-endian byte order.
+ */
+namespace track_format {
+
+constexpr char magic[8] = {'N', 'U', 'T', 'R', 'T', 'R', 'K', '1'};
+constexpr uint64_t format_version = 1;
+constexpr size_t header_size = 40;
+constexpr char extension[] = ".nutrtrk";
+
+constexpr double default_time_lsb = 1e-3;   /**< 1 ps */
+constexpr double default_energy_lsb = 1e-6; /**< 1 eV */
+
+// Put() and BlockReader::Get() copy numbers in the byte order of the machine.
+static_assert(std::endian::native == std::endian::little,
+              "Track files are only written on little-endian machines.");
+
+inline uint64_t ZigZag(const int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t UnZigZag(const uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+inline void PutVarint(string &data, uint64_t value) {
+  while (value >= 0x80) {
+    data.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  data.push_back(static_cast<char>(value));
+}
+
+template <typename T> void Put(string &data, const T value) {
+  data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/**
+ * \brief Varint in place of a time difference, which is followed by the
+ * time itself
+ *
+ * Zigzag-encoded differences of at most max_time_channel channels never
+ * reach this value.
+ */
+constexpr uint64_t time_escape = std::numeric_limits<uint64_t>::max();
+constexpr double max_time_channel = 4611686018427387904.; /**< 2^62 */
+
+/**
+ * \brief Append a time as the difference to the previous time in channels of
+ * lsb, or escaped if the difference does not fit
+ *
+ * \param previous Decoded previous time, which is updated to the decoded
+ * time.
+ */
+inline void PutTime(string &data, const double time, double &previous,
+                    const double lsb) {
+  const double channel = (time - previous) / lsb;
+  if (std::abs(channel) < max_time_channel) {
+    const int64_t delta = std::llround(channel);
+    PutVarint(data, ZigZag(delta));
+    previous += static_cast<double>(delta) * lsb;
+  } else {
+    PutVarint(data, time_escape);
+    Put(data, time);
+    previous = time;
+  }
+}
+
+/**
+ * \brief Sequential reader of the content of a block
+ */
+class BlockReader {
+public:
+  BlockReader(const char *_begin, const char *_end)
+      : position(_begin), end(_end) {}
+
+  uint64_t GetVarint() {
+    uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+      if (position == end) {
+        break;
+      }
+      const auto byte = static_cast<unsigned char>(*position++);
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (byte < 0x80) {
+        return value;
+      }
+    }
+    throw std::runtime_error("Invalid integer in block of track file.");
+  }
+  template <typename T> T Get() {
+    if (static_cast<size_t>(end - position) < sizeof(T)) {
+      throw std::runtime_error("Block of track file is too short.");
+    }
+    T value;
+    std::memcpy(&value, position, sizeof(value));
+    position += sizeof(value);
+    return value;
+  }
+  /**
+   * \brief Decode a time that was written with PutTime()
+   */
+  double GetTime(double &previous, const double lsb) {
+    const uint64_t value = GetVarint();
+    previous = value == time_escape
+                   ? Get<double>()
+                   : previous + static_cast<double>(UnZigZag(value)) * lsb;
+    return previous;
+  }
+
+private:
+  const char *position;
+  const char *end;
+};
+
+} // namespace track_format
@@ -0,0 +1,147 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+#include "OutputBackend.hh"
+#include "TrackFileWriter.hh"
+
+/**
+ * \brief Output backend for the compact track format (see TrackFormat.hh)
+ *
+ * Only supports the ntuple of the tracker sensitive detector, whose columns
+ * are identified by their names. The steps of an event are collected and
+ * encoded as a block at the beginning of the next event. Blocks are written to
+ * the shared TrackFileWriter in batches of about batch_bytes.
+ *
+ * The time and the energies are quantized with the least significant bit of
+ * a quantized precision (see SetPrecision()) of the columns 'time', 'edep',
+ * and 'ekin', or with the defaults in TrackFormat.hh otherwise.
+ */
+class TrackOutputBackend : public OutputBackend {
+public:
+  TrackOutputBackend() : file(nullptr), n_ntuples(0){};
+  ~TrackOutputBackend() override;
+
+  void OpenFile(const string &file_name) override;
+  /**
+   * \throw std::runtime_error for any ntuple after the first one.
+   */
+  int CreateNtuple(const string &name, const string &title) override;
+  /**
+   * \throw std::runtime_error if the column is not part of the ntuple of the
+   * tracker sensitive detector.
+   */
+  int CreateNtupleIColumn(const string &name) override;
+  int CreateNtupleLColumn(const string &name) override;
+  using OutputBackend::CreateNtupleDColumn;
+  int CreateNtupleDColumn(const string &name,
+                          const ColumnPrecision precision) override;
+  /**
+   * \throw std::runtime_error if a column of the ntuple of the tracker
+   * sensitive detector is missing.
+   */
+  void FinishNtuple() override;
+
+  bool FillNtupleIColumn(const int ntuple, const int column,
+                         const int value) override;
+  bool FillNtupleLColumn(const int ntuple, const int column,
+                         const int64_t value) override;
+  bool FillNtupleDColumn(const int ntuple, const int column,
+                         const double value) override;
+  bool AddNtupleRow(const int ntuple = 0) override;
+  void NewEvent() override;
+
+  void Write() override;
+  void CloseFile() override;
+  string GetFileName() const override { return file_name; }
+
+  static constexpr size_t batch_bytes = 64 * 1024;
+
+  /**
+   * \brief Columns of the ntuple of the tracker sensitive detector
+   */
+  enum Field {
+    evid,
+    runid,
+    trid,
+    paid,
+    deid,
+    time,
+    edep,
+    ekin,
+    posx,
+    posy,
+    posz,
+    momx,
+    momy,
+    momz,
+    n_fields
+  };
+  static constexpr const char *field_names[n_fields] = {
+      "evid", "runid", "trid", "paid", "deid", "time", "edep",
+      "ekin", "posx",  "posy", "posz", "momx", "momy", "momz"};
+
+private:
+  struct Step {
+    int32_t track_id;
+    int32_t pdg;
+    int32_t detector_id;
+    double time;
+    double edep;
+    double ekin;
+    double position[3];
+    double momentum[3];
+  };
+  struct Track {
+    double time; /**< Decoded time of the previous step. */
+    double position[3];
+  };
+
+  int CreateColumn(const string &name, const bool integer,
+                   const ColumnPrecision precision);
+  bool CheckColumn(const int ntuple, const int column,
+                   const bool integer) const;
+  void FinishEvent();
+
+  string file_name;
+  TrackFileWriter *file;
+  unsigned int n_ntuples;
+  vector<Field> fields; /**< Field of each column. */
+  double lsbs[3];       /**< Of the time, edep, and ekin. */
+
+  int64_t integers[n_fields];
+  double floating_points[n_fields];
+  int64_t event_id;
+  int32_t run_id;
+  vector<Step> steps; /**< Steps of the current event. */
+
+  unordered_map<int32_t, uint32_t> track_indices;
+  vector<Track> tracks;
+  string batch;
+};
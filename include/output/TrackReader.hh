@@ -0,0 +1,82 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using std::ifstream;
+using std::string;
+using std::vector;
+
+/**
+ * \brief Sequential reader of the compact track format (see TrackFormat.hh)
+ *
+ * Decodes the blocks of a track file event by event. The quantized values are
+ * converted back to the internal units of Geant4, with the same arithmetic as
+ * the writer, so decoded positions are exactly the ones that the writer used
+ * as the reference of the next step.
+ */
+class TrackReader {
+public:
+  struct Step {
+    int32_t track_id;
+    int32_t pdg;
+    int32_t detector_id;
+    double time;
+    double edep;
+    double ekin;
+    double position[3];
+    double momentum[3];
+  };
+  struct Event {
+    int64_t event_id;
+    int32_t run_id;
+    vector<Step> steps;
+  };
+
+  /**
+   * \throw std::runtime_error if the file cannot be opened or is not a track
+   * file of a supported version.
+   */
+  explicit TrackReader(const string &path);
+
+  /**
+   * \brief Decode the next event
+   *
+   * \return false at the end of the file, which may also be a file that is
+   * still being written.
+   *
+   * \throw std::runtime_error if a block is invalid.
+   */
+  bool Next(Event &event);
+
+  double GetTimeLSB() const { return lsbs[0]; }
+  double GetEdepLSB() const { return lsbs[1]; }
+  double GetEkinLSB() const { return lsbs[2]; }
+
+private:
+  string path;
+  ifstream file;
+  double lsbs[3]; /**< Of the time, edep, and ekin. */
+  string block;
+};
@@ -22,7 +22,9 @@
 #include <functional>
 #include <memory>
 #include <random>
+#include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 using std::shared_ptr;
@@ -32,6 +34,7 @@ using std::vector;
 
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "PrimaryGeneratorMessenger.hh"
+#include "State.hh"
 
 class PrimaryGeneratorMessenger;
 class G4ParticleGun;
@@ -39,6 +42,28 @@ class SourceVolume;
 class CascadeRejectionSampler;
 class AngularCorrelation;
 
+/**
+ * \brief Parse a cascade given as a list of spin-parity quantum numbers and
+ * multipole mixing ratios, for example "0+ [0.1] 1/2- 3/2+".
+ *
+ * \return States and the mixing ratios of the transitions between them.
+ */
+std::pair<std::vector<State>, std::vector<double>>
+parse_cascade(const std::string &cascade);
+
+std::vector<AngularCorrelation>
+parse_angular_correlation(std::vector<State> states,
+                          std::vector<double> deltas);
+
+/**
+ * \brief Parse a list of energies followed by a unit, for example
+ * "1.0 2.0 MeV".
+ *
+ * \return Energies without the unit applied and the unit.
+ */
+std::pair<std::vector<double>, std::string>
+parse_energies(const std::string &energies);
+
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction {
 public:
   PrimaryGeneratorAction(long seed);
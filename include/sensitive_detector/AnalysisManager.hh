@@ -23,32 +23,298 @@
 
 #pragma once
 
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+using std::map;
 using std::string;
+using std::unique_ptr;
 using std::vector;
 
-#include "G4AnalysisManager.hh"
 #include "G4Event.hh"
 #include "G4VHit.hh"
 #include "globals.hh"
 
+#include "ChargeCollection.hh"
+#include "Digitizer.hh"
+#include "Histogram.hh"
+#include "NextEventEstimator.hh"
+#include "OutputBackend.hh"
+#include "Trigger.hh"
+
 class AnalysisManager {
 public:
   AnalysisManager();
   ~AnalysisManager();
 
-  void Book(string output_file_name);
-  [[maybe_unused]] virtual void
-  CreateNtupleColumns(G4AnalysisManager *analysisManager);
+  /**
+   * \brief Open the output file and define the ntuple
+   *
+   * Files with the suffix '.nutr' are written in the native columnar format
+   * of nutr (see ColumnarFormat.hh). If the name refers to a stream (see
+   * StreamWriter::IsStream), the events are sent in the stream format (see
+   * StreamFormat.hh). For all other suffixes, the G4AnalysisManager
+   * determines the output format.
+   *
+   * If the output of the threads is not merged (see /analysis/merge), each
+   * worker thread writes its own file, and the master thread writes a
+   * manifest of these files in Save().
+   *
+   * If energy spectra are accumulated (see /analysis/spectrum,
+   * /analysis/point_detector and /analysis/scorer), the master thread writes
+   * the spectra of all threads to OUTPUT.hist.nutr in Save().
+   *
+   * If a configuration was set in RunMetadata, the master thread writes the
+   * metadata sidecar of the output in Save().
+   *
+   * \param run_id ID of the run, which is part of the global event IDs.
+   *
+   * \throw std::runtime_error if the run ID does not fit into a global event
+   * ID.
+   */
+  void Book(string output_file_name, const G4int run_id = 0);
+  [[maybe_unused]] virtual void CreateNtupleColumns(OutputBackend *output);
   void FillNtuple(const G4Event *event, vector<G4VHit *> hits);
-  [[maybe_unused]] virtual size_t
-  FillNtupleColumns(G4AnalysisManager *analysisManager, const G4Event *event,
-                    vector<G4VHit *> hits);
+  [[maybe_unused]] virtual size_t FillNtupleColumns(OutputBackend *output,
+                                                    const G4Event *event,
+                                                    vector<G4VHit *> hits);
+  /**
+   * \brief Fill the histograms of the sensitive detector with all hits of an
+   * event, for sensitive detectors that accumulate spectra instead of writing
+   * rows
+   *
+   * Called once per event, also for events without hits.
+   */
+  [[maybe_unused]] virtual void
+  FillHistograms(const vector<G4VHit *> &hits);
+  /**
+   * \brief Complete the histograms of this thread before they are merged at
+   * the end of the run
+   */
+  [[maybe_unused]] virtual void FinishHistograms();
   void Save();
+  OutputBackend *GetOutput() const { return output.get(); }
+  /**
+   * \brief Index of the ntuple of primary particles, or -1 if primaries are
+   * not recorded in the current run (see /analysis/record_primaries)
+   */
+  int GetPrimaryNtuple() const { return primary_ntuple; }
+
+  /**
+   * \brief Unique ID of an event across all runs and jobs of a production
+   *
+   * The event ID occupies the lowest event_id_bits bits, followed by the run
+   * ID and the shard index of the job (see /analysis/shard). The run and the
+   * event of a global ID can be recovered by shifting and masking.
+   */
+  static int64_t GlobalEventID(const unsigned int shard, const G4int run_id,
+                               const G4int event_id) {
+    return static_cast<int64_t>(shard) << (event_id_bits + run_id_bits) |
+           static_cast<int64_t>(run_id) << event_id_bits | event_id;
+  }
+  static constexpr unsigned int event_id_bits = 31;
+  static constexpr unsigned int run_id_bits = 16;
+  static constexpr unsigned int shard_bits = 16;
+
+  bool HasTrigger() const { return trigger != nullptr; }
+  /**
+   * \brief Evaluate the trigger condition of the run for an event
+   *
+   * \param energies Energy of each detector, indexed by the detector ID.
+   *
+   * \return true if the event should be written. Always true if no trigger
+   * was set.
+   */
+  bool IsTriggered(const vector<double> &energies) const {
+    return trigger == nullptr || (*trigger)(energies);
+  }
+
+  /**
+   * \brief Whether the energies of the detectors are digitized in the
+   * current run (see /analysis/calibration)
+   */
+  bool HasDigitizer() const { return digitizer != nullptr; }
+  /**
+   * \brief Whether the deposited energies are written, which is always the
+   * case without a digitizer (see /analysis/keep_edep)
+   */
+  bool WritesEdep() const { return digitizer == nullptr || keep_edep; }
+  /**
+   * \brief Apply the detector response of the run to the energies of an
+   * event (see Digitizer::Digitize)
+   */
+  void Digitize(const vector<double> &energies, vector<double> &digitized) {
+    digitizer->Digitize(energies, digitized);
+  }
+  /**
+   * \brief Number of variants of the charge-collection model of the current
+   * run, or 0 if no model is used (see /analysis/charge_collection)
+   */
+  size_t GetNumberOfVariants() const {
+    return charge_collection == nullptr
+               ? 0
+               : charge_collection->GetNumberOfVariants();
+  }
+  /**
+   * \brief Energy of a deposition that is collected in each variant of the
+   * charge-collection model (see ChargeCollection::Collect)
+   */
+  void CollectCharge(const size_t detector_id, const double depth,
+                     const double energy, double *collected) const {
+    charge_collection->Collect(detector_id, depth, energy, collected);
+  }
+  /**
+   * \brief Set the collected energies of the following rows, indexed by
+   * detector_id * GetNumberOfVariants() + variant
+   *
+   * The energies are not copied, so they have to outlive the rows.
+   */
+  void SetCurrentCollectedEnergies(const vector<double> &energies) {
+    collected_energies = &energies;
+  }
+  /**
+   * \brief Whether the energies of detectors with several crystals are
+   * summed in the current run (see /analysis/addback)
+   */
+  bool HasAddback() const { return addback; }
+  /**
+   * \brief Whether the energies of the crystals of detectors with addback are
+   * written (see /analysis/keep_crystals)
+   */
+  bool WritesCrystals() const { return !addback || keep_crystals; }
+
+  /**
+   * \brief Length of the time windows of the current run, or 0 if all energy
+   * depositions of an event are summed (see /analysis/time_window)
+   */
+  double GetTimeWindow() const { return time_window; }
+  /**
+   * \brief Maximum number of time windows that are written per event (see
+   * /analysis/split_time_windows)
+   */
+  size_t GetMaxTimeWindows() const;
+  /**
+   * \brief Set the index and the start time of the time window of the
+   * following rows
+   */
+  void SetCurrentTimeWindow(const size_t index, const double start_time) {
+    time_window_index = static_cast<int>(index);
+    time_window_start = start_time;
+  }
+
+  /**
+   * \brief Whether the statistical weights of the tracks are written in the
+   * current run (see /analysis/weights)
+   */
+  bool WritesWeights() const { return write_weights; }
+  /**
+   * \brief Whether energy spectra are accumulated in the current run (see
+   * /analysis/spectrum)
+   */
+  bool HasSpectra() const { return spectrum.n_bins > 0; }
+
+  /**
+   * \brief Score a step with the estimators that do not need a sensitive
+   * detector, which are the point detectors of the current run (see
+   * /analysis/point_detector)
+   */
+  void ScoreStep(const G4Step *step) {
+    if (next_event_estimator != nullptr) {
+      next_event_estimator->Score(step);
+    }
+  }
 
 protected:
   string create_default_file_name() const;
+  void CreatePrimaryNtuple(OutputBackend *output);
+  /**
+   * \brief Create the columns 'win' and 't0' of the time window of a row, if
+   * time windows are used
+   */
+  void CreateTimeWindowColumns(OutputBackend *output);
+  size_t FillTimeWindowColumns(OutputBackend *output, size_t col);
+  /**
+   * \brief Name of the variants of the charge-collection model, which are
+   * the suffixes of their columns and spectra
+   */
+  const vector<string> &GetVariants() const {
+    return charge_collection->GetVariants();
+  }
+  /**
+   * \brief Energy of a detector in a variant of the charge-collection model
+   * in the current row, which is zero for detectors without energy
+   */
+  double CollectedEnergy(const size_t detector_id, const size_t variant) const {
+    const size_t index = detector_id * GetNumberOfVariants() + variant;
+    return index < collected_energies->size() ? (*collected_energies)[index]
+                                              : 0.;
+  }
+  /**
+   * \brief Add an energy spectrum with the binning of the run, which is
+   * filled with FillSpectrum() in the order of creation
+   */
+  void CreateSpectrum(const string &name) {
+    histograms.emplace_back(name, vector<Histogram::Axis>{spectrum});
+  }
+  /**
+   * \brief Fill an energy spectrum, unless the energy is zero
+   */
+  void FillSpectrum(const size_t index, const double energy,
+                    const double weight) {
+    if (energy != 0.) {
+      histograms[index].Fill(energy, weight);
+    }
+  }
+  /**
+   * \brief Write one row for each particle of each primary vertex
+   *
+   * The particles are read directly from the event, so no memory is
+   * allocated apart from the buffers of the output backend.
+   */
+  void FillPrimaryNtuple(const G4Event *event, const int64_t global_event_id);
+
   G4bool fFactoryOn;
+  unique_ptr<OutputBackend> output;
+  unique_ptr<Trigger> trigger;
+  unique_ptr<Digitizer> digitizer;
+  unique_ptr<ChargeCollection> charge_collection;
+  const vector<double> *collected_energies; /**< Of the current row. */
+  bool keep_edep;
+  bool addback;
+  bool keep_crystals;
+  double time_window;
+  bool split_time_windows;
+  int time_window_index;
+  double time_window_start;
+  bool write_weights;
+  Histogram::Axis spectrum;
+  vector<Histogram> histograms; /**< Spectra of this thread in this run. */
+  /**
+   * \brief Number of batches of this thread of the batch-statistics spectra,
+   * by the prefix of their names (see FluxSpectra::Finish())
+   */
+  map<string, uint64_t> batches;
+  unique_ptr<NextEventEstimator> next_event_estimator;
+  bool merge;
+  G4int run_id;
+  int64_t global_event_id_offset; /**< Global ID of event 0 of the run. */
+  G4int last_event_id;
+  int primary_ntuple;
+  string manifest_file_name; /**< Only set in the master thread. */
+  string result_file_name;   /**< Output file name, empty for streams. */
+  vector<string> result_files; /**< Only set in the master thread. */
+
+  inline static std::mutex thread_files_mutex;
+  inline static vector<string> thread_files;
+  /**
+   * \brief Sum of the spectra of all threads, which the master thread
+   * writes at the end of the run
+   */
+  inline static std::mutex merged_histograms_mutex;
+  inline static vector<Histogram> merged_histograms;
+  inline static map<string, uint64_t> merged_batches;
 };
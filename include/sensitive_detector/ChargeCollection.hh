@@ -0,0 +1,97 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * \brief Variants of the dead layer and the charge-collection efficiency of
+ * the sensitive detectors, which are applied to the energy depositions at
+ * scoring time
+ *
+ * Instead of building a geometry with a smaller active volume for each
+ * hypothesis of the dead layer (see /nutr/DETECTOR_dead_layer), the full
+ * crystal is made sensitive, and the energy of each deposition is scaled with
+ * the efficiency at its depth below the surface of the crystal, for any
+ * number of variants in the same run. The variants are read from a file,
+ * with one line per variant and detector:
+ *
+ *   # variant   ID   dead layer [mm]   transition [mm]   efficiency
+ *   nominal     *    0.7
+ *   thick       *    1.0               0.3               1
+ *   thick       3    1.5               0.3               0.98
+ *
+ * The efficiency is zero in the dead layer, rises linearly over the optional
+ * transition layer, and is constant in the bulk of the crystal, where it is
+ * 1 by default. The line with the ID '*' applies to all detectors of a
+ * variant that are not listed, which are ideal detectors otherwise. As in
+ * the calibration file of the Digitizer, detector IDs are non-negative G4int
+ * values. The variants are numbered in the order of their first appearance
+ * in the file, and their names may only contain letters, digits and
+ * underscores, since they are part of column names. Text after a '#' is
+ * ignored.
+ *
+ * The depth is the distance to the nearest surface of the sensitive volume,
+ * so the model does not distinguish between the outer contact and a thin
+ * inner contact, like the bore hole of a coaxial detector.
+ */
+class ChargeCollection {
+public:
+  /**
+   * \throw std::runtime_error if the file cannot be read or is invalid.
+   */
+  explicit ChargeCollection(const string &file_name);
+
+  const string &GetFileName() const { return file_name; }
+  const vector<string> &GetVariants() const { return variants; }
+  size_t GetNumberOfVariants() const { return variants.size(); }
+
+  /**
+   * \brief Collected energy of a deposition in each variant
+   *
+   * \param depth Distance of the deposition to the surface of the detector.
+   * \param collected Array of GetNumberOfVariants() energies.
+   */
+  void Collect(const size_t detector_id, const double depth,
+               const double energy, double *collected) const;
+
+private:
+  struct Layer {
+    double dead_layer = 0.;
+    double transition = 0.;
+    double efficiency = 1.;
+
+    double Efficiency(const double depth) const;
+  };
+
+  string file_name;
+  vector<string> variants;
+  vector<Layer> default_layers; /**< Indexed by the variant. */
+  /**
+   * \brief Layers of the listed detectors, indexed by the detector ID and
+   * the variant, with the default layers for the other detectors
+   */
+  vector<vector<Layer>> layers;
+};
@@ -0,0 +1,101 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#include "Randomize.hh"
+
+/**
+ * \brief Response of the sensitive detectors to the energy deposited in an
+ * event
+ *
+ * The response of each detector is read from a calibration file, with one
+ * line per detector:
+ *
+ *   # ID   a [keV^2]   b [keV]   c   threshold [keV]   gain
+ *   0      1.2         1.5e-3    0   20                1
+ *   1      dead
+ *   *      1.0         1.0e-3    0   10
+ *
+ * The deposited energy E of a detector is smeared with a normal distribution
+ * whose full width at half maximum is FWHM(E) = sqrt(a + b E + c E^2).
+ * Smeared energies below the threshold are discarded, and the remaining ones
+ * are multiplied by the gain, which is optional and 1 by default. A detector
+ * that is marked as 'dead' never responds. The line with the ID '*' applies
+ * to all detectors that are not listed, which are ideal detectors without a
+ * threshold otherwise. Detector IDs are non-negative G4int values. All
+ * energies in the file are in keV, and text after a '#' is ignored.
+ *
+ * Detectors without deposited energy never respond. The normal random
+ * numbers for all detectors of an event are drawn at once from the random
+ * engine of the thread or a given engine, and the response is computed in a
+ * single loop over per-detector arrays of the parameters, which the compiler
+ * can vectorize.
+ */
+class Digitizer {
+public:
+  /**
+   * \throw std::runtime_error if the file cannot be read or is invalid.
+   */
+  explicit Digitizer(const string &calibration_file);
+
+  /**
+   * \param energies Deposited energy of each detector, indexed by the
+   * detector ID.
+   * \param digitized Response of each detector, with the same size as
+   * energies. Zero if a detector does not respond.
+   * \param engine Random engine to use instead of G4Random::getTheEngine(),
+   * for programs that run their own threads outside of the Geant4 run
+   * manager.
+   */
+  void Digitize(const vector<double> &energies, vector<double> &digitized,
+                CLHEP::HepRandomEngine *engine = nullptr);
+
+  const string &GetCalibrationFile() const { return calibration_file; }
+
+private:
+  struct Channel {
+    double a = 0.;
+    double b = 0.;
+    double c = 0.;
+    double threshold = 0.;
+    double gain = 1.;
+  };
+
+  /**
+   * \brief Extend the parameter arrays with the default channel
+   */
+  void Resize(const size_t n_detectors);
+  /**
+   * \brief Fill normals with at least n standard normal random numbers
+   */
+  void DrawNormals(const size_t n, CLHEP::HepRandomEngine &engine);
+
+  string calibration_file;
+  Channel default_channel;
+  vector<double> a, b, c, thresholds, gains;
+  vector<double> uniforms;
+  vector<double> normals;
+};
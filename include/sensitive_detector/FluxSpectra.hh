@@ -0,0 +1,118 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::map;
+using std::pair;
+using std::string;
+using std::vector;
+
+#include "G4StepPoint.hh"
+
+#include "Histogram.hh"
+
+/**
+ * \brief Flux spectra of the particles that reach the detectors, by detector
+ * and particle type
+ *
+ * In the default mode, each particle that enters a detector is counted in a
+ * spectrum of its kinetic energy and its angle of incidence. For the
+ * track-length estimator, the lengths of the steps of the particles in a
+ * detector, multiplied by their weight, are summed by kinetic energy
+ * instead. Since the steps of an event are correlated, the sums are
+ * accumulated in batches of events, and each bin is filled once per batch
+ * with the sum of the batch. The spread of the batches then estimates the
+ * statistical uncertainty.
+ *
+ * The spectra are named PREFIXN_PARTICLE, where N is the detector ID, and
+ * are created when the first particle of a type arrives at a detector.
+ */
+class FluxSpectra {
+public:
+  FluxSpectra();
+
+  /**
+   * \brief Discard all spectra and set the binning of the next run
+   *
+   * \param track_length Whether the track-length estimator is used, in which
+   * case the angle axis is ignored.
+   */
+  void Reset(const string &prefix, const Histogram::Axis &energy_axis,
+             const Histogram::Axis &angle_axis, const bool track_length,
+             const size_t batch_size);
+
+  bool IsTrackLength() const { return track_length; }
+  void FillEntry(const int detector_id, const int particle_id,
+                 const double energy, const double angle,
+                 const double weight);
+  void FillStep(const int detector_id, const int particle_id,
+                const double energy, const double length,
+                const double weight);
+  /**
+   * \brief Count an event for the batches of the track-length estimator
+   */
+  void EndOfEvent();
+  /**
+   * \brief Complete the last batch and move all spectra to a list of
+   * histograms
+   *
+   * \param batches Number of batches of the track-length estimator, which is
+   * added to the entry of the prefix. Spectra are only created when a
+   * particle arrives, so after the spectra of all threads have been added,
+   * they have to be padded to the batches of all threads (see
+   * Histogram::PadEntries).
+   */
+  void Finish(vector<Histogram> &output, map<string, uint64_t> &batches);
+
+  /**
+   * \brief Angle between the direction of a particle and the inward normal
+   * of the surface of the volume at a step point on the surface
+   */
+  static double IncidenceAngle(const G4StepPoint *point);
+
+private:
+  size_t SpectrumIndex(const int detector_id, const int particle_id);
+  /**
+   * \brief Fill each bin of the track-length spectra with its sum over the
+   * current batch of events
+   */
+  void FinishBatch();
+
+  string prefix;
+  Histogram::Axis energy_axis;
+  Histogram::Axis angle_axis;
+  bool track_length;
+  size_t batch_size;
+  size_t batch_events; /**< Number of events in the current batch. */
+  size_t n_batches;    /**< Number of completed batches in this run. */
+  vector<Histogram> histograms;
+  /**
+   * \brief Index of the spectrum of each pair of detector ID and PDG code
+   */
+  map<pair<int, int>, size_t> spectrum_indices;
+  vector<vector<double>> batch_sums; /**< Indexed like the histograms. */
+};
@@ -0,0 +1,86 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#include "G4AnalysisManager.hh"
+
+#include "OutputBackend.hh"
+
+/**
+ * \brief Output backend that forwards to the G4AnalysisManager of the thread
+ *
+ * The output format is determined by the suffix of the file name, as usual in
+ * Geant4. Since Geant4 ntuples have no fixed-point column type, quantized
+ * columns are stored as float columns that contain the quantized values.
+ * Likewise, 64-bit integer columns are stored as double columns, which are
+ * only exact for absolute values up to 2^53.
+ *
+ * If merge_threads is false, each worker thread writes its own file, named
+ * by Geant4 with the suffix '_tN' of the thread.
+ */
+class G4OutputBackend : public OutputBackend {
+public:
+  explicit G4OutputBackend(const bool _merge_threads = true)
+      : analysisManager(G4AnalysisManager::Instance()),
+        merge_threads(_merge_threads){};
+
+  void OpenFile(const string &file_name) override;
+  int CreateNtuple(const string &name, const string &title) override;
+  int CreateNtupleIColumn(const string &name) override;
+  int CreateNtupleLColumn(const string &name) override;
+  using OutputBackend::CreateNtupleDColumn;
+  int CreateNtupleDColumn(const string &name,
+                          const ColumnPrecision precision) override;
+  void FinishNtuple() override { analysisManager->FinishNtuple(); }
+
+  bool FillNtupleIColumn(const int ntuple, const int column,
+                         const int value) override {
+    return analysisManager->FillNtupleIColumn(ntuple, column, value);
+  }
+  bool FillNtupleLColumn(const int ntuple, const int column,
+                         const int64_t value) override {
+    return analysisManager->FillNtupleDColumn(ntuple, column,
+                                              static_cast<double>(value));
+  }
+  bool FillNtupleDColumn(const int ntuple, const int column,
+                         const double value) override;
+  bool AddNtupleRow(const int ntuple = 0) override {
+    return analysisManager->AddNtupleRow(ntuple);
+  }
+
+  void Write() override { analysisManager->Write(); }
+  void CloseFile() override { analysisManager->CloseFile(); }
+  string GetFileName() const override {
+    return analysisManager->GetFileName();
+  }
+  vector<string> GetFileNames() const override;
+
+private:
+  G4AnalysisManager *analysisManager;
+  const bool merge_threads;
+  vector<string> ntuple_names;
+  vector<vector<ColumnPrecision>> precisions; /**< Per ntuple and column. */
+};
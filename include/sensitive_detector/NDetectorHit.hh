@@ -42,8 +42,19 @@ public:
 
   int GetDetectorID() const { return fDetectorID; };
 
+  /// \brief Weight of the track that caused the hit (1 for analog
+  /// simulations, different for biased ones).
+  void SetWeight(const double weight) { fWeight = weight; };
+
+  double GetWeight() const { return fWeight; };
+
+  /// \brief Deposited energy, which the trigger sums per detector by default
+  /// (see NEventAction::DetectorEnergy()).
+  virtual double GetEdep() const { return 0.; };
+
 protected:
   int fDetectorID;
+  double fWeight;
 };
 
 extern G4ThreadLocal G4Allocator<NDetectorHit> *NDetectorHitAllocator;
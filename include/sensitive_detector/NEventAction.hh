@@ -19,6 +19,10 @@
 
 #pragma once
 
+#include <vector>
+
+using std::vector;
+
 #include "G4Event.hh"
 #include "G4UserEventAction.hh"
 #include "globals.hh"
@@ -36,6 +40,27 @@ public:
   virtual void EndOfEventAction(const G4Event *) = 0;
 
 protected:
+  /**
+   * \brief Evaluate the trigger condition of the AnalysisManager
+   *
+   * The energy of each detector is obtained by summing DetectorEnergy() over
+   * all hits collections that belong to the detector.
+   */
+  bool IsTriggered(const G4Event *event);
+  /**
+   * \brief Evaluate the trigger condition of the AnalysisManager for given
+   * energies of the detectors, for example of a time window
+   */
+  bool IsTriggered(const vector<double> &energies) const;
+  /**
+   * \brief Energy of a detector for the trigger, by default the sum of the
+   * deposited energies of the hits of a hits collection
+   */
+  virtual double DetectorEnergy(G4VHitsCollection *hc) const;
+
   AnalysisManager *analysis_manager;
   const int update_frequency;
+
+private:
+  vector<double> detector_energies;
 };
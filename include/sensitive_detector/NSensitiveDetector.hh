@@ -25,6 +25,7 @@ using std::string;
 
 #include "G4HCofThisEvent.hh"
 #include "G4Step.hh"
+#include "G4ThreeVector.hh"
 #include "G4VSensitiveDetector.hh"
 
 #include "NDetectorHit.hh"
@@ -41,6 +42,19 @@ public:
 
   void SetDetectorID(const unsigned int id) { fDetectorID = id; };
 
+  /**
+   * \brief Center of a step in the frame of the volume in which it occurred
+   */
+  static G4ThreeVector LocalPosition(const G4Step *step);
+  /**
+   * \brief Distance of the center of a step to the surface of the volume in
+   * which it occurred, for the charge-collection model (see
+   * ChargeCollection)
+   */
+  static double Depth(const G4Step *step);
+
 protected:
+
   unsigned int fDetectorID;
+  int fHitsCollectionID;
 };
\ No newline at end of file
@@ -0,0 +1,41 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include "G4Step.hh"
+#include "G4UserSteppingAction.hh"
+
+#include "AnalysisManager.hh"
+
+/**
+ * \brief Stepping action that passes every step to the estimators of the
+ * AnalysisManager that score steps outside of the sensitive detectors (see
+ * AnalysisManager::ScoreStep)
+ */
+class NSteppingAction : public G4UserSteppingAction {
+public:
+  NSteppingAction(AnalysisManager *ana_man)
+      : G4UserSteppingAction(), analysis_manager(ana_man){};
+
+  void UserSteppingAction(const G4Step *step) override final;
+
+private:
+  AnalysisManager *analysis_manager;
+};
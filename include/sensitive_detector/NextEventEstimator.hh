@@ -0,0 +1,151 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::map;
+using std::pair;
+using std::set;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+#include "G4LogicalVolume.hh"
+#include "G4Navigator.hh"
+#include "G4Step.hh"
+#include "G4ThreeVector.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VTouchable.hh"
+
+#include "Histogram.hh"
+
+/**
+ * \brief Point in space at which the photon flux is estimated (see
+ * NextEventEstimator)
+ */
+struct PointDetector {
+  string name;
+  G4ThreeVector position;
+};
+
+/**
+ * \brief Next-event estimator of the photon flux at point detectors
+ *
+ * Detectors far away from the target, like a beam-flux monitor several
+ * meters downstream, are reached by very few photons, so that counting them
+ * needs huge runs. Instead, the next-event estimator adds the expected
+ * contribution of every Compton scattering in the selected volumes to each
+ * point detector: the probability per solid angle to scatter towards the
+ * detector (Klein-Nishina formula for free electrons), the attenuation of
+ * the scattered photon on the way, and the solid angle of a unit area at the
+ * detector, 1/R^2. The contribution is filled into the spectrum
+ * 'nee_NAME' of the detector at the energy of the scattered photon, so that
+ * the sum over all events, divided by the number of events, is the fluence
+ * per event in units of 1/mm^2.
+ *
+ * The attenuation is calculated along fixed rays from the origin of each
+ * placed volume in which photons scatter to each detector. A ray is traced
+ * through the geometry when it is first needed, and stored as the path
+ * lengths in each material. The total attenuation coefficients of the
+ * materials are tabulated on a logarithmic energy grid when they are first
+ * needed. This neglects the difference between the paths from different
+ * points of the same volume, which is small for detectors that are far away
+ * compared to the size of the volume, and for volumes that are thin compared
+ * to the mean free path of the photons. For a large or thick volume, like
+ * the world or a lead shielding, the attenuation from its origin may be
+ * wrong by orders of magnitude, so the volumes have to be selected
+ * explicitly.
+ *
+ * Each thread has its own estimator, so no synchronization is needed.
+ */
+class NextEventEstimator {
+public:
+  /**
+   * \param volume_names Names of the logical volumes in which scatterings
+   * contribute.
+   * \param energy_axis Binning of the spectra of the point detectors.
+   *
+   * \throw std::runtime_error if no volume is given or a volume does not
+   * exist.
+   */
+  NextEventEstimator(const vector<PointDetector> &detectors,
+                     const vector<string> &volume_names,
+                     const Histogram::Axis &energy_axis);
+  ~NextEventEstimator();
+
+  /**
+   * \brief Add the contributions of a step to the point detectors, if the
+   * step ends with a Compton scattering in one of the volumes
+   */
+  void Score(const G4Step *step);
+
+  vector<Histogram> &GetHistograms() { return histograms; }
+
+  /**
+   * \brief Energy of a photon after Compton scattering by an angle theta
+   */
+  static double ComptonEnergy(const double energy, const double cos_theta);
+  /**
+   * \brief Probability per solid angle of Compton scattering by an angle
+   * theta, i.e. the Klein-Nishina cross section, normalized to the total
+   * cross section
+   */
+  static double ComptonProbability(const double energy,
+                                   const double cos_theta);
+
+private:
+  struct Segment {
+    size_t material_index;
+    double length;
+  };
+
+  const vector<Segment> &Ray(const G4VTouchable *touchable,
+                             const size_t detector);
+  vector<Segment> TraceRay(const G4ThreeVector &start,
+                           const G4ThreeVector &end);
+  double Attenuation(const vector<Segment> &ray, const double energy);
+  /**
+   * \brief Total attenuation coefficient of a material for photons,
+   * interpolated logarithmically in a table
+   */
+  double AttenuationCoefficient(const size_t material_index,
+                                const double energy);
+
+  vector<PointDetector> detectors;
+  set<const G4LogicalVolume *> volumes;
+  vector<Histogram> histograms;
+  unique_ptr<G4Navigator> navigator;
+  /**
+   * \brief Rays from each placed volume (physical volume and copy number)
+   * to each detector
+   */
+  map<pair<const G4VPhysicalVolume *, int>, vector<vector<Segment>>> rays;
+  /**
+   * \brief Logarithm of the attenuation coefficient of each material on the
+   * energy grid, empty if not needed yet
+   */
+  vector<vector<double>> log_attenuation_coefficients;
+};
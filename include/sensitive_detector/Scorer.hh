@@ -0,0 +1,157 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+using std::map;
+using std::string;
+using std::vector;
+
+#include "G4HCofThisEvent.hh"
+#include "G4Step.hh"
+#include "G4VSensitiveDetector.hh"
+
+#include "FluxSpectra.hh"
+#include "Histogram.hh"
+#include "StepWriter.hh"
+
+/**
+ * \brief Sensitive detector that accumulates a spectrum of each sensitive
+ * volume instead of producing hits
+ *
+ * The output format of nutr is selected at compile time (see the CMake option
+ * SENSITIVE_DETECTOR_DIR), so a single simulation can only write the rows of
+ * one sensitive detector. Scorers can be attached to all sensitive volumes in
+ * addition to it at runtime (see /analysis/scorer), so that, for example, the
+ * flux through the detectors is scored in the same pass as their energy
+ * depositions. Geant4 combines several sensitive detectors of a logical
+ * volume in a G4MultiSensitiveDetector.
+ *
+ * All scorers of a thread fill the spectra of the ScorerSet of that thread,
+ * with the binning of /analysis/spectrum, which are written to
+ * OUTPUT.hist.nutr at the end of the run like the other spectra. The
+ * step-point scorer instead records the energy depositions in the file
+ * OUTPUT.nutrstp (see StepFormat.hh), so that a detector response can be
+ * applied after the simulation.
+ */
+class Scorer : public G4VSensitiveDetector {
+public:
+  enum Kind {
+    energy,      /**< Energy deposition per event, 'energy_detN'. */
+    flux,        /**< Particles entering the volume, 'flux_detN_PARTICLE'. */
+    /** Track-length estimator, 'track_length_detN_PARTICLE'. */
+    track_length,
+    step_points   /**< Energy depositions, written to OUTPUT.nutrstp. */
+  };
+
+  Scorer(const string &volume_name, const Kind kind,
+         const unsigned int detector_id);
+
+  void Initialize(G4HCofThisEvent *hce) override;
+  G4bool ProcessHits(G4Step *step, G4TouchableHistory *history) override;
+  void EndOfEvent(G4HCofThisEvent *hce) override;
+
+  /**
+   * \brief Names of the kinds of scorers, as accepted by /analysis/scorer
+   */
+  static const vector<string> &KindNames();
+  /**
+   * \throw std::runtime_error if the name is not one of KindNames().
+   */
+  static Kind KindFromName(const string &name);
+
+private:
+  const Kind kind;
+  const unsigned int detector_id;
+  double event_energy;          /**< Energy deposited in the current event. */
+  double event_weighted_energy; /**< Same, multiplied by the track weights. */
+};
+
+/**
+ * \brief Spectra of all scorers of a thread in the current run
+ */
+class ScorerSet {
+public:
+  static ScorerSet &ForThread();
+
+  /**
+   * \brief Discard all spectra and set the binning of the next run
+   *
+   * The scorers of spectra are inactive in runs without a binning of the
+   * energy.
+   */
+  void BeginOfRun(const Histogram::Axis &energy_axis, const size_t angle_bins,
+                  const size_t batch_size);
+  /**
+   * \brief Open the step-point file of the run, which is shared by all
+   * threads
+   *
+   * \param global_event_id_offset Global ID of event 0 of the run (see
+   * AnalysisManager::GlobalEventID).
+   */
+  void OpenStepFile(const string &path, const int32_t run_id,
+                    const int64_t global_event_id_offset);
+  bool HasSpectra() const { return energy_axis.n_bins > 0; }
+  bool RecordsSteps() const { return steps.IsOpen(); }
+  void FillEnergy(const unsigned int detector_id, const double energy,
+                  const double weight);
+  FluxSpectra &GetFlux() { return flux; }
+  FluxSpectra &GetTrackLength() { return track_length; }
+  StepWriter &GetSteps() { return steps; }
+  /**
+   * \brief Name of the step-point file of the current or the last run, or an
+   * empty string if no steps were recorded
+   */
+  const string &GetStepFileName() const { return step_file_name; }
+  /**
+   * \brief Count an event for the batches of the track-length estimator,
+   * and write its step points
+   *
+   * Every scorer calls this at the end of an event, but only the first call
+   * per event is counted.
+   */
+  void EndOfEvent(const int event_id);
+  /**
+   * \brief Move all spectra of the run to a list of histograms, and close
+   * the step-point file
+   *
+   * \param batches See FluxSpectra::Finish().
+   */
+  void EndOfRun(vector<Histogram> &output, map<string, uint64_t> &batches);
+
+private:
+  ScorerSet();
+
+  Histogram::Axis energy_axis;
+  map<unsigned int, size_t> energy_indices; /**< By detector ID. */
+  vector<Histogram> energy_histograms;
+  FluxSpectra flux;
+  FluxSpectra track_length;
+  StepWriter steps;
+  string step_file_name;
+  int32_t run_id;
+  int64_t global_event_id_offset;
+  int last_event_id;
+};
@@ -0,0 +1,125 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+/**
+ * \brief Grouping of the energy depositions of an event into time windows
+ *
+ * The first window starts with the earliest deposition of the event and
+ * contains all depositions within the window length after it. The next
+ * window starts with the earliest deposition that is not part of a previous
+ * window, and so on. Depositions that occur in the same window are summed,
+ * like the pile-up of signals in a detector with a finite integration time.
+ *
+ * Optionally, each deposition carries the energy that is collected in each
+ * variant of the charge-collection model (see ChargeCollection), which are
+ * summed in the same way.
+ *
+ * All buffers are reused from event to event, so that no memory is allocated
+ * once they have reached their maximum size.
+ */
+class TimeWindows {
+public:
+  TimeWindows() : n_windows(0), n_variants(0){};
+
+  /**
+   * \brief Remove all depositions, and set the number of collected energies
+   * per deposition of the next event
+   */
+  void Clear(const size_t _n_variants = 0) {
+    deposits.clear();
+    deposit_collected.clear();
+    n_variants = _n_variants;
+  }
+  /**
+   * \param collected Energy collected in each variant, which must be given
+   * if the number of variants is not zero.
+   */
+  void Add(const double time, const size_t detector_id, const double energy,
+           const double weight = 1., const double *collected = nullptr) {
+    deposits.push_back(Deposit{time, detector_id, energy, weight,
+                               deposit_collected.size()});
+    deposit_collected.insert(deposit_collected.end(), collected,
+                             collected + n_variants);
+  }
+  /**
+   * \brief Group the depositions into windows and sum their energies
+   *
+   * \param length Length of a window. If zero, all depositions are in a
+   * single window that starts at the earliest one.
+   * \param max_windows Maximum number of windows. Depositions after the last
+   * window are discarded.
+   */
+  void Group(const double length, const size_t max_windows);
+
+  size_t GetNumberOfWindows() const { return n_windows; }
+  /**
+   * \brief Time of the earliest deposition in a window
+   */
+  double GetStartTime(const size_t window) const {
+    return start_times[window];
+  }
+  /**
+   * \brief Energy of each detector in a window, indexed by the detector ID
+   */
+  const vector<double> &GetEnergies(const size_t window) const {
+    return energies[window];
+  }
+  /**
+   * \brief Weight of each detector in a window, indexed by the detector ID
+   *
+   * The weight is the mean of the track weights of the depositions, weighted
+   * by their energy. Detectors without energy have a weight of 1.
+   */
+  const vector<double> &GetWeights(const size_t window) const {
+    return weights[window];
+  }
+  size_t GetNumberOfVariants() const { return n_variants; }
+  /**
+   * \brief Energy collected in each variant of each detector in a window,
+   * at the index detector_id * GetNumberOfVariants() + variant
+   */
+  const vector<double> &GetCollectedEnergies(const size_t window) const {
+    return collected_energies[window];
+  }
+
+private:
+  struct Deposit {
+    double time;
+    size_t detector_id;
+    double energy;
+    double weight;
+    size_t collected; /**< Index of the first collected energy. */
+  };
+
+  vector<Deposit> deposits;
+  vector<double> deposit_collected;
+  size_t n_windows;
+  size_t n_variants;
+  vector<double> start_times;
+  vector<vector<double>> energies;
+  vector<vector<double>> weights;
+  vector<vector<double>> collected_energies;
+};
@@ -0,0 +1,75 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using std::function;
+using std::string;
+using std::vector;
+
+/**
+ * \brief Trigger condition on the energies of the sensitive detectors in an
+ * event
+ *
+ * The condition is given as an expression, for example
+ *
+ *   mult >= 2
+ *   (det0 > 0 || det1 > 0) && det8 > 100 keV
+ *   sum(det0:3) > 1 MeV
+ *
+ * 'detN' is the energy of the detector with the ID N. The functions 'sum',
+ * 'mult', and 'max' return the sum of the energies, the number of detectors
+ * with a non-zero energy, and the maximum energy of a list of detectors,
+ * where 'detN:M' denotes the detectors N to M. Without an argument list, they
+ * use all detectors. Energies may be given with the units eV, keV, MeV, or
+ * GeV, otherwise the internal unit of Geant4 (MeV) is assumed. The
+ * expressions support the arithmetic operators '+', '-', '*', and '/', the
+ * comparisons '<', '<=', '>', '>=', '==', and '!=', and the logical operators
+ * '!', '&&', and '||'. Logical values are 1 and 0 in arithmetic, so that, for
+ * example, '(det0 > 50 keV) + (det1 > 50 keV) >= 2' is a multiplicity
+ * condition with a threshold.
+ *
+ * The expression is compiled into a tree of closures when the Trigger is
+ * constructed, with constant subexpressions folded, so that the evaluation
+ * per event does not parse any text.
+ */
+class Trigger {
+public:
+  /**
+   * \throw std::runtime_error if the expression is invalid.
+   */
+  explicit Trigger(const string &expression);
+
+  /**
+   * \param energies Energy of each detector, indexed by the detector ID.
+   * Detectors with a higher ID than the size of the vector have zero energy.
+   */
+  bool operator()(const vector<double> &energies) const {
+    return condition(energies) != 0.;
+  }
+  const string &GetExpression() const { return expression; }
+
+private:
+  string expression;
+  function<double(const vector<double> &)> condition;
+};
@@ -37,11 +37,27 @@ public:
   inline void operator delete(void *);
 
   void SetEdep(const double de) { fEdep = de; };
-
-  double GetEdep() const { return fEdep; };
+  void SetGlobalTime(const double time) { fGlobalTime = time; };
+  /**
+   * \brief Set the response of the detector (see Digitizer)
+   */
+  void SetDigitizedEnergy(const double e) { fDigitizedEnergy = e; };
+  /**
+   * \brief Set the depth of the deposition below the surface of the
+   * detector (see ChargeCollection), which is stored with single precision
+   */
+  void SetDepth(const double depth) { fDepth = static_cast<float>(depth); };
+
+  double GetEdep() const final { return fEdep; };
+  double GetGlobalTime() const { return fGlobalTime; };
+  double GetDigitizedEnergy() const { return fDigitizedEnergy; };
+  double GetDepth() const { return fDepth; };
 
 private:
   double fEdep;
+  double fGlobalTime;
+  double fDigitizedEnergy;
+  float fDepth;
 };
 
 extern G4ThreadLocal G4Allocator<DetectorHit> *DetectorHitAllocator;
@@ -19,14 +19,32 @@
 
 #pragma once
 
+#include <vector>
+
+using std::vector;
+
 #include "globals.hh"
 
 #include "AnalysisManager.hh"
 #include "NEventAction.hh"
+#include "TimeWindows.hh"
 
 class EventAction : public NEventAction {
 public:
   EventAction(AnalysisManager *ana_man);
 
   void EndOfEventAction(const G4Event *) override final;
+
+private:
+  TimeWindows time_windows;
+  /**
+   * \brief Response of each detector, indexed by the detector ID, which is
+   * reused to avoid an allocation per event
+   */
+  vector<double> digitized_energies;
+  /**
+   * \brief Energy of a deposition that is collected in each variant of the
+   * charge-collection model
+   */
+  vector<double> collected_energies;
 };
@@ -23,11 +23,13 @@
 
 class TupleManager : public AnalysisManager {
 public:
-  TupleManager() : AnalysisManager(){};
+  TupleManager() : AnalysisManager(), spectra_per_detector(0){};
 
-  void CreateNtupleColumns(G4AnalysisManager *analysisManager) override;
+  void CreateNtupleColumns(OutputBackend *output) override;
 
-  size_t FillNtupleColumns(G4AnalysisManager *analysisManager,
-                           const G4Event *event,
+  size_t FillNtupleColumns(OutputBackend *output, const G4Event *event,
                            vector<G4VHit *> hits) override;
+
+private:
+  size_t spectra_per_detector; /**< Spectra are indexed by detector ID. */
 };
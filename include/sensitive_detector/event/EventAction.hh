@@ -19,14 +19,39 @@
 
 #pragma once
 
+#include <vector>
+
+using std::vector;
+
 #include "globals.hh"
 
 #include "AnalysisManager.hh"
 #include "NEventAction.hh"
+#include "TimeWindows.hh"
 
 class EventAction : public NEventAction {
 public:
   EventAction(AnalysisManager *ana_man);
 
   void EndOfEventAction(const G4Event *) override final;
+
+private:
+  /**
+   * \brief Write the row of a time window, if any detector has an energy
+   */
+  void FillTimeWindow(const G4Event *event,
+                      const vector<double> &window_energies,
+                      const vector<double> &window_weights);
+
+  TimeWindows time_windows;
+  /**
+   * \brief Energy and response of each detector, indexed by the detector ID,
+   * which are reused to avoid an allocation per event
+   */
+  vector<double> energies, digitized_energies;
+  /**
+   * \brief Energy of a deposition that is collected in each variant of the
+   * charge-collection model
+   */
+  vector<double> collected_energies;
 };
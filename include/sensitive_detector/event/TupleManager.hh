@@ -19,18 +19,41 @@
 
 #pragma once
 
+#include <vector>
+
+using std::vector;
+
 #include "AnalysisManager.hh"
 
 class TupleManager : public AnalysisManager {
 public:
   TupleManager() : AnalysisManager(), n_sensitive_detectors(0){};
 
-  void CreateNtupleColumns(G4AnalysisManager *analysisManager) override;
+  void CreateNtupleColumns(OutputBackend *output) override;
 
-  size_t FillNtupleColumns(G4AnalysisManager *analysisManager,
-                           const G4Event *event,
+  size_t FillNtupleColumns(OutputBackend *output, const G4Event *event,
                            vector<G4VHit *> hits) override;
 
 private:
+  /**
+   * \brief Energy of a detector for the addback, which is the digitized
+   * energy if a digitizer is used
+   */
+  double AddbackEnergy(const vector<G4VHit *> &hits,
+                       const size_t detector_id) const;
+  /**
+   * \brief Statistical weight of the energy of a detector
+   */
+  double Weight(const vector<G4VHit *> &hits, const size_t detector_id) const;
+
   size_t n_sensitive_detectors;
+  /**
+   * \brief Whether the columns of each detector are written, which is not
+   * the case for crystals that are replaced by their addback
+   */
+  vector<bool> written_detectors;
+  /**
+   * \brief Detector IDs of the crystals of each detector with addback
+   */
+  vector<vector<size_t>> addback_groups;
 };
@@ -43,6 +43,8 @@ public:
   void SetEkin(const double de) { fEkin = de; };
   void SetPos(const G4ThreeVector xyz) { fPos = xyz; };
   void SetMom(const G4ThreeVector pxpypz) { fMom = pxpypz; };
+  void SetIncidenceAngle(const double angle) { fIncidenceAngle = angle; };
+  void SetTrackLength(const double length) { fTrackLength = length; };
 
   int GetParticleID() const { return fParticleID; };
   int GetParentID() const { return fParentID; };
@@ -50,6 +52,17 @@ public:
   double GetEkin() const { return fEkin; };
   G4ThreeVector GetPos() const { return fPos; };
   G4ThreeVector GetMom() const { return fMom; };
+  /**
+   * \brief Angle between the momentum and the inward surface normal at the
+   * point where the particle entered the detector, only set for flux
+   * spectra (see /analysis/spectrum)
+   */
+  double GetIncidenceAngle() const { return fIncidenceAngle; };
+  /**
+   * \brief Length of the step, only set for the track-length estimator (see
+   * /analysis/track_length)
+   */
+  double GetTrackLength() const { return fTrackLength; };
 
 private:
   int fParticleID;
@@ -58,6 +71,8 @@ private:
   double fEkin;
   G4ThreeVector fPos;
   G4ThreeVector fMom;
+  double fIncidenceAngle;
+  double fTrackLength;
 };
 
 extern G4ThreadLocal G4Allocator<DetectorHit> *DetectorHitAllocator;
@@ -19,6 +19,10 @@
 
 #pragma once
 
+#include <vector>
+
+using std::vector;
+
 #include "globals.hh"
 
 #include "AnalysisManager.hh"
@@ -29,4 +33,10 @@ public:
   EventAction(AnalysisManager *ana_man);
 
   void EndOfEventAction(const G4Event *) override final;
+
+protected:
+  double DetectorEnergy(G4VHitsCollection *hc) const override;
+
+private:
+  vector<G4VHit *> spectrum_hits; /**< Reused to avoid an allocation. */
 };
@@ -20,14 +20,28 @@
 #pragma once
 
 #include "AnalysisManager.hh"
+#include "FluxSpectra.hh"
 
 class TupleManager : public AnalysisManager {
 public:
   TupleManager() : AnalysisManager(){};
 
-  void CreateNtupleColumns(G4AnalysisManager *analysisManager) override;
+  void CreateNtupleColumns(OutputBackend *output) override;
 
-  size_t FillNtupleColumns(G4AnalysisManager *analysisManager,
-                           const G4Event *event,
+  size_t FillNtupleColumns(OutputBackend *output, const G4Event *event,
                            vector<G4VHit *> hits) override;
+  /**
+   * \brief Count the particles that entered a detector in a spectrum of their
+   * kinetic energy and their angle of incidence, or sum the lengths of their
+   * steps by kinetic energy for the track-length estimator
+   *
+   * Each combination of detector and particle type has its own spectrum
+   * 'detN_PARTICLE' or 'tlN_PARTICLE', which is created when the first such
+   * particle arrives (see FluxSpectra).
+   */
+  void FillHistograms(const vector<G4VHit *> &hits) override;
+  void FinishHistograms() override;
+
+private:
+  FluxSpectra flux_spectra;
 };
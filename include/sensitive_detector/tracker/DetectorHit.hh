@@ -48,7 +48,7 @@ public:
   int GetTrackID() const { return fTrackID; };
   int GetParticleID() const { return fParticleID; };
   double GetGlobalTime() const { return fGlobalTime; };
-  double GetEdep() const { return fEdep; };
+  double GetEdep() const final { return fEdep; };
   double GetEkin() const { return fEkin; };
   G4ThreeVector GetPos() const { return fPos; };
   G4ThreeVector GetMom() const { return fMom; };
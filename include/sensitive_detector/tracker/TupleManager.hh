@@ -25,9 +25,8 @@ class TupleManager : public AnalysisManager {
 public:
   TupleManager() : AnalysisManager(){};
 
-  void CreateNtupleColumns(G4AnalysisManager *analysisManager) override;
+  void CreateNtupleColumns(OutputBackend *output) override;
 
-  size_t FillNtupleColumns(G4AnalysisManager *analysisManager,
-                           const G4Event *event,
+  size_t FillNtupleColumns(OutputBackend *output, const G4Event *event,
                            vector<G4VHit *> hits) override;
 };
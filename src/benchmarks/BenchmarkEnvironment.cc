@@ -0,0 +1,177 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <filesystem>
+#include <memory>
+
+using std::make_shared;
+using std::make_unique;
+
+#include "G4Box.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Gamma.hh"
+#include "G4LogicalVolume.hh"
+#include "G4NistManager.hh"
+#include "G4PVPlacement.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SDManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Tubs.hh"
+
+#include "BenchmarkEnvironment.hh"
+#include "SourceVolumeTubs.hh"
+
+BenchmarkDetectorConstruction::BenchmarkDetectorConstruction(
+    const size_t _n_detectors)
+    : NDetectorConstruction(), n_detectors(_n_detectors) {}
+
+G4VPhysicalVolume *BenchmarkDetectorConstruction::Construct() {
+  ConstructBoxWorld(1. * m, 1. * m, 1. * m);
+
+  G4NistManager *nist_manager = G4NistManager::Instance();
+
+  auto detector_solid = new G4Box("detector_solid", 1. * cm, 1. * cm, 1. * cm);
+  for (size_t i = 0; i < n_detectors; ++i) {
+    auto detector_logical = new G4LogicalVolume(
+        detector_solid, nist_manager->FindOrBuildMaterial("G4_Ge"),
+        "detector_" + to_string(i));
+    new G4PVPlacement(
+        nullptr,
+        G4ThreeVector((static_cast<double>(i) - 0.5 * n_detectors) * 5. * cm,
+                      0., 50. * cm),
+        detector_logical, "detector_" + to_string(i), world_logical, false, 0);
+    RegisterSensitiveLogicalVolumes({detector_logical});
+  }
+
+  // Rotated source volume, so that SourceVolumeTubs::operator() has to apply
+  // both a rotation and a translation.
+  auto source_rotation = new G4RotationMatrix();
+  source_rotation->rotateX(90. * deg);
+  auto source_solid =
+      new G4Tubs("source_solid", 1. * mm, 10. * mm, 1. * mm, 0., twopi);
+  auto source_logical = new G4LogicalVolume(
+      source_solid, nist_manager->FindOrBuildMaterial("G4_Mo"),
+      "source_logical");
+  auto source_physical =
+      new G4PVPlacement(source_rotation, G4ThreeVector(0., 0., 1. * cm),
+                        source_logical, "source", world_logical, false, 0);
+  source_volumes.push_back(
+      make_shared<SourceVolumeTubs>(source_solid, source_physical, 1.));
+
+  return world_phys;
+}
+
+BenchmarkEnvironment &BenchmarkEnvironment::Instance() {
+  if (instance == nullptr) {
+    instance = new BenchmarkEnvironment();
+  }
+  return *instance;
+}
+
+void BenchmarkEnvironment::Shutdown() {
+  delete instance;
+  instance = nullptr;
+}
+
+BenchmarkEnvironment::BenchmarkEnvironment()
+    : run_manager(make_unique<G4RunManager>()),
+      detector_construction(new BenchmarkDetectorConstruction(n_detectors)) {
+  // The particle gun of the primary generators looks up photons in the
+  // particle table, which is usually filled by the physics list.
+  G4Gamma::Definition();
+
+  run_manager->SetUserInitialization(detector_construction);
+  detector_construction->Construct();
+  detector_construction->ConstructSDandField();
+
+  for (size_t i = 0; i < n_detectors; ++i) {
+    sensitive_detectors.push_back(static_cast<SensitiveDetector *>(
+        G4SDManager::GetSDMpointer()->FindSensitiveDetector(
+            "detector_" + to_string(i))));
+  }
+}
+
+BenchmarkEnvironment::~BenchmarkEnvironment() {
+  if (tuple_manager != nullptr) {
+    tuple_manager->Save();
+    std::filesystem::remove(output_file_name);
+  }
+}
+
+TupleManager *BenchmarkEnvironment::GetTupleManager() {
+  if (tuple_manager == nullptr) {
+    output_file_name =
+        (std::filesystem::temp_directory_path() / "nutr_benchmarks.root")
+            .string();
+    tuple_manager = make_unique<TupleManager>();
+    tuple_manager->Book(output_file_name);
+  }
+  return tuple_manager.get();
+}
+
+vector<SyntheticStep>
+BenchmarkEnvironment::CreateSteps(const size_t n_steps,
+                                  const unsigned int seed) const {
+  std::mt19937 random_engine(seed);
+  std::uniform_real_distribution<double> uniform_random;
+
+  vector<SyntheticStep> steps(n_steps);
+  for (size_t i = 0; i < n_steps; ++i) {
+    const double kinetic_energy = 2. * MeV * uniform_random(random_engine);
+    const G4ThreeVector direction =
+        G4ThreeVector(0., 0., 1.)
+            .rotateX(uniform_random(random_engine) * pi)
+            .rotateZ(uniform_random(random_engine) * twopi);
+    const G4ThreeVector position(uniform_random(random_engine) * cm,
+                                 uniform_random(random_engine) * cm,
+                                 50. * cm);
+
+    steps[i].detector = i % n_detectors;
+
+    steps[i].track = make_unique<G4Track>(
+        new G4DynamicParticle(G4Gamma::Definition(), direction,
+                              kinetic_energy),
+        0., position);
+    steps[i].track->SetTrackID(1 + static_cast<int>(i / 4));
+    steps[i].track->SetParentID(0);
+
+    steps[i].step = make_unique<G4Step>();
+    steps[i].step->SetTrack(steps[i].track.get());
+    steps[i].step->SetTotalEnergyDeposit(
+        i % 10 == 9 ? 0. : kinetic_energy * uniform_random(random_engine));
+    for (auto step_point :
+         {steps[i].step->GetPreStepPoint(), steps[i].step->GetPostStepPoint()}) {
+      step_point->SetPosition(position);
+      step_point->SetGlobalTime(1. * ns);
+      step_point->SetKineticEnergy(kinetic_energy);
+      step_point->SetMomentumDirection(direction);
+    }
+  }
+
+  return steps;
+}
+
+G4HCofThisEvent *BenchmarkEnvironment::CreateHitsCollections() const {
+  auto hits_collections = new G4HCofThisEvent(
+      G4SDManager::GetSDMpointer()->GetCollectionCapacity());
+  for (auto sensitive_detector : sensitive_detectors) {
+    sensitive_detector->Initialize(hits_collections);
+  }
+  return hits_collections;
+}
@@ -0,0 +1,112 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+// Microbenchmarks of the primary generators: sampling of source positions,
+// parsing of the angcorr macro commands, and sampling of cascades.
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::array;
+using std::string;
+using std::vector;
+
+#include <benchmark/benchmark.h>
+
+#include "G4Event.hh"
+#include "G4ParticleGun.hh"
+
+#include "AngularCorrelation.hh"
+#include "BenchmarkEnvironment.hh"
+#include "CascadeRejectionSampler.hh"
+#include "PrimaryGeneratorAction.hh"
+#include "SourceVolume.hh"
+
+namespace {
+
+const vector<string> cascades{"0+ 1+ 0+", "0+ 1- [0.3] 2 0",
+                              "1/2+ 3/2- [0.1] 5/2+ 3/2+ 1/2-"};
+const vector<string> energies{"1000. keV", "5000. 130. keV",
+                              "4000. 2000. 1000. keV"};
+
+void BM_SourceVolumeTubs_operator(benchmark::State &state) {
+  auto source_volume = BenchmarkEnvironment::Instance()
+                           .GetDetectorConstruction()
+                           ->GetSourceVolumes()[0];
+  source_volume->initialize(0);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(source_volume->operator()());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SourceVolumeTubs_operator);
+
+void BM_parse_cascade(benchmark::State &state) {
+  const string &cascade = cascades[state.range(0)];
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(parse_cascade(cascade));
+  }
+}
+BENCHMARK(BM_parse_cascade)->DenseRange(0, 2);
+
+void BM_parse_energies(benchmark::State &state) {
+  const string &energy = energies[state.range(0)];
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(parse_energies(energy));
+  }
+}
+BENCHMARK(BM_parse_energies)->DenseRange(0, 2);
+
+void BM_CascadeRejectionSampler_operator(benchmark::State &state) {
+  auto [states, deltas] = parse_cascade(cascades[state.range(0)]);
+  CascadeRejectionSampler sampler(parse_angular_correlation(states, deltas), 0,
+                                  {0., 0., 0.}, false);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sampler());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CascadeRejectionSampler_operator)->DenseRange(0, 2);
+
+void BM_angcorr_GeneratePrimaries(benchmark::State &state) {
+  BenchmarkEnvironment::Instance();
+  PrimaryGeneratorAction primary_generator_action(0);
+  primary_generator_action.set_cascade(cascades[state.range(0)]);
+  primary_generator_action.set_energies(energies[state.range(0)]);
+
+  // A new event is needed for each call, because GeneratePrimaries() adds
+  // vertices to it. The construction and destruction of the event is part of
+  // the measurement.
+  int event_id = 0;
+  for (auto _ : state) {
+    G4Event event(event_id++);
+    primary_generator_action.GeneratePrimaries(&event);
+    benchmark::DoNotOptimize(event.GetNumberOfPrimaryVertex());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_angcorr_GeneratePrimaries)->DenseRange(0, 2);
+
+} // namespace
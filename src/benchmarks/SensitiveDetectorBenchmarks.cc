@@ -0,0 +1,109 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+// Microbenchmarks of the sensitive detector that was selected with
+// SENSITIVE_DETECTOR_DIR: creation of hits, processing of the hits
+// collections at the end of an event, and filling of the ntuple.
+
+#include <memory>
+#include <vector>
+
+using std::unique_ptr;
+using std::vector;
+
+#include <benchmark/benchmark.h>
+
+#include "G4Event.hh"
+
+#include "BenchmarkEnvironment.hh"
+#include "EventAction.hh"
+
+namespace {
+
+/**
+ * \brief Create an event whose hits collections contain the hits of n_steps
+ * synthetic steps
+ */
+unique_ptr<G4Event> create_event(const size_t n_steps) {
+  auto &environment = BenchmarkEnvironment::Instance();
+
+  auto event = std::make_unique<G4Event>(0);
+  event->SetHCofThisEvent(environment.CreateHitsCollections());
+  for (auto &step : environment.CreateSteps(n_steps, 0)) {
+    environment.GetSensitiveDetector(step.detector)
+        ->ProcessHits(step.step.get(), nullptr);
+  }
+  return event;
+}
+
+void BM_SensitiveDetector_ProcessHits(benchmark::State &state) {
+  auto &environment = BenchmarkEnvironment::Instance();
+  const auto steps = environment.CreateSteps(state.range(0), 0);
+
+  // Each iteration corresponds to one event: hits collections are created,
+  // filled, and deleted together with their hits.
+  for (auto _ : state) {
+    unique_ptr<G4HCofThisEvent> hits_collections(
+        environment.CreateHitsCollections());
+    for (auto &step : steps) {
+      environment.GetSensitiveDetector(step.detector)
+          ->ProcessHits(step.step.get(), nullptr);
+    }
+    benchmark::DoNotOptimize(hits_collections.get());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SensitiveDetector_ProcessHits)->RangeMultiplier(4)->Range(1, 1024);
+
+void BM_EventAction_EndOfEventAction(benchmark::State &state) {
+  EventAction event_action(BenchmarkEnvironment::Instance().GetTupleManager());
+  const auto event = create_event(state.range(0));
+
+  // EndOfEventAction() does not modify the hits collections, so the same
+  // event can be processed repeatedly. Each call adds rows to the ntuple.
+  for (auto _ : state) {
+    event_action.EndOfEventAction(event.get());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EventAction_EndOfEventAction)->RangeMultiplier(4)->Range(1, 1024);
+
+void BM_TupleManager_FillNtupleColumns(benchmark::State &state) {
+  TupleManager *tuple_manager =
+      BenchmarkEnvironment::Instance().GetTupleManager();
+  const auto event = create_event(4 * BenchmarkEnvironment::n_detectors);
+
+  // One hit per detector, which is the input for the 'edep' and 'event'
+  // sensitive detectors. The others only use the first hit. With four steps
+  // per detector, every detector has at least one hit.
+  vector<G4VHit *> hits;
+  for (size_t i = 0; i < BenchmarkEnvironment::n_detectors; ++i) {
+    hits.push_back(event->GetHCofThisEvent()->GetHC(i)->GetHit(0));
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        tuple_manager->FillNtupleColumns(tuple_manager->GetOutput(),
+                                         event.get(), hits));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TupleManager_FillNtupleColumns);
+
+} // namespace
@@ -129,7 +129,13 @@ G4ThreeVector Detector::unit_vector_phi([[maybe_unused]] const double _theta,
 void Detector::rotate(const double _theta, const double _phi,
                       const double alpha) {
 
-  rotation_matrix = new G4RotationMatrix();
+  // The rotation matrix is allocated only once per detector, because it is
+  // owned by the detector and shared by all of its placements.
+  if (rotation_matrix == nullptr) {
+    rotation_matrix = new G4RotationMatrix();
+  } else {
+    *rotation_matrix = G4RotationMatrix();
+  }
 
   rotation_matrix->rotateZ(-_phi);
   rotation_matrix->rotateY(-_theta);
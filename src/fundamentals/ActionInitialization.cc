@@ -20,6 +20,7 @@
 #include "ActionInitialization.hh"
 #include "EventAction.hh"
 #include "NRunAction.hh"
+#include "NSteppingAction.hh"
 #include "PrimaryGeneratorAction.hh"
 #include "TupleManager.hh"
 
@@ -42,4 +43,5 @@ void ActionInitialization::Build() const {
   SetUserAction(new PrimaryGeneratorAction(random_number_seed));
   SetUserAction(new NRunAction(output_file_name, tuple));
   SetUserAction(new EventAction(tuple));
+  SetUserAction(new NSteppingAction(tuple));
 }
\ No newline at end of file
@@ -17,18 +17,489 @@
     Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
 */
 
+#include <algorithm>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+
+#include "G4UIparameter.hh"
+
 #include <NutrMessenger.hh>
+#include "ChargeCollection.hh"
+#include "Digitizer.hh"
+#include "Scorer.hh"
+#include "Trigger.hh"
 
 NutrMessenger::NutrMessenger()
-    : dir("/analysis/"), cmd_filename("/analysis/filename", this) {
+    : dir("/analysis/"), cmd_filename("/analysis/filename", this),
+      cmd_precision("/analysis/precision", this, false),
+      cmd_trigger("/analysis/trigger", this),
+      cmd_merge("/analysis/merge", this),
+      cmd_rotate_events("/analysis/rotate_events", this),
+      cmd_rotate_size("/analysis/rotate_size", this, false),
+      cmd_shard("/analysis/shard", this),
+      cmd_record_primaries("/analysis/record_primaries", this),
+      cmd_calibration("/analysis/calibration", this),
+      cmd_charge_collection("/analysis/charge_collection", this),
+      cmd_keep_edep("/analysis/keep_edep", this),
+      cmd_addback("/analysis/addback", this),
+      cmd_keep_crystals("/analysis/keep_crystals", this),
+      cmd_time_window("/analysis/time_window", this),
+      cmd_split_time_windows("/analysis/split_time_windows", this),
+      cmd_weights("/analysis/weights", this),
+      cmd_spectrum("/analysis/spectrum", this, false),
+      cmd_angle_bins("/analysis/angle_bins", this),
+      cmd_track_length("/analysis/track_length", this),
+      cmd_batch_size("/analysis/batch_size", this),
+      cmd_point_detector("/analysis/point_detector", this, false),
+      cmd_point_detector_volume("/analysis/point_detector_volume", this),
+      cmd_clear_point_detectors("/analysis/clear_point_detectors", this),
+      cmd_scorer("/analysis/scorer", this) {
   dir.SetGuidance("Controls for general simulation settings.");
 
   cmd_filename.SetGuidance("Set filename of simulation output.");
   cmd_filename.SetParameterName("filename", false);
+
+  cmd_precision.SetGuidance(
+      "Set the precision with which floating-point output columns are "
+      "stored: 'double' (default), 'float' (single precision), or "
+      "'quantized' (integer multiples of a least significant bit, like the "
+      "channels of an ADC). A column name that ends with '*' applies to all "
+      "columns that start with the given prefix, for example 'det*'. If "
+      "several settings match a column, the last one is used. Must be set "
+      "before the run in which it should be applied.");
+  auto *column = new G4UIparameter("column", 's', false);
+  column->SetGuidance("Name of the column, or a prefix followed by '*'.");
+  cmd_precision.SetParameter(column);
+  auto *precision = new G4UIparameter("precision", 's', false);
+  precision->SetParameterCandidates("double float quantized");
+  cmd_precision.SetParameter(precision);
+  auto *lsb = new G4UIparameter("lsb", 'd', true);
+  lsb->SetGuidance("Least significant bit of a quantized column.");
+  lsb->SetParameterRange("lsb > 0.");
+  lsb->SetDefaultValue(1.);
+  cmd_precision.SetParameter(lsb);
+  auto *unit = new G4UIparameter("unit", 's', true);
+  unit->SetGuidance("Unit of the least significant bit, for example keV, "
+                    "ns, or mm.");
+  unit->SetDefaultValue("keV");
+  cmd_precision.SetParameter(unit);
+  cmd_precision.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_precision.SetToBeBroadcasted(false);
+
+  cmd_trigger.SetGuidance(
+      "Only write events that fulfil a trigger condition on the energies "
+      "of the sensitive detectors, for example 'mult >= 2' or "
+      "'sum(det0:3) > 100 keV && det8 > 0'. See Trigger.hh for the syntax. "
+      "In the 'flux' sensitive detector, the energy of a detector is the "
+      "kinetic energy of the particles that entered it. An empty string "
+      "disables the trigger (default).");
+  cmd_trigger.SetParameterName("expression", true);
+  cmd_trigger.SetDefaultValue("");
+  cmd_trigger.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_trigger.SetToBeBroadcasted(false);
+
+  cmd_merge.SetGuidance(
+      "Merge the output of all threads into a single file (default). If "
+      "false, each worker thread writes its own file with the suffix '_tN', "
+      "and the master thread writes a manifest with the suffix '.manifest' "
+      "that lists them. The files can be read as a single dataset via the "
+      "manifest, or merged later with nutr_merge (native format) or hadd "
+      "(ROOT).");
+  cmd_merge.SetParameterName("merge", true);
+  cmd_merge.SetDefaultValue(true);
+  cmd_merge.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_merge.SetToBeBroadcasted(false);
+
+  cmd_rotate_events.SetGuidance(
+      "Start a new output file, named with the suffix '_cN', after the given "
+      "number of events, and list the complete files in the index "
+      "OUTPUT.manifest. Only supported for the native columnar format "
+      "('.nutr'). 0 disables the rotation (default).");
+  cmd_rotate_events.SetParameterName("n_events", false);
+  cmd_rotate_events.SetRange("n_events >= 0");
+  cmd_rotate_events.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_rotate_events.SetToBeBroadcasted(false);
+
+  cmd_rotate_size.SetGuidance(
+      "Start a new output file, named with the suffix '_cN', when the "
+      "current one has reached the given size (approximately), and list the "
+      "complete files in the index OUTPUT.manifest. Only supported for the "
+      "native columnar format ('.nutr'). 0 disables the rotation (default).");
+  auto *size = new G4UIparameter("size", 'd', false);
+  size->SetParameterRange("size >= 0.");
+  cmd_rotate_size.SetParameter(size);
+  auto *size_unit = new G4UIparameter("unit", 's', true);
+  size_unit->SetParameterCandidates("B kB MB GB");
+  size_unit->SetDefaultValue("MB");
+  cmd_rotate_size.SetParameter(size_unit);
+  cmd_rotate_size.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_rotate_size.SetToBeBroadcasted(false);
+
+  cmd_shard.SetGuidance(
+      "Set the index of this job in a production that is distributed over "
+      "several jobs (default: 0). The shard, the run ID and the event ID "
+      "are combined into the 64-bit global event ID in the column 'evid', "
+      "which is unique across all jobs as long as each job has its own "
+      "shard index. The Geant4 output formats only support shards below "
+      "64.");
+  cmd_shard.SetParameterName("shard", false);
+  cmd_shard.SetRange("shard >= 0 && shard <= 65535");
+  cmd_shard.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_shard.SetToBeBroadcasted(false);
+
+  cmd_record_primaries.SetGuidance(
+      "Record all primary particles of all primary vertices of each written "
+      "event in the additional ntuple 'primaries', with one row per "
+      "particle: the global event ID, the index of the vertex, the PDG code, "
+      "the kinetic energy, the momentum direction, and the polarization "
+      "(default: false).");
+  cmd_record_primaries.SetParameterName("record", true);
+  cmd_record_primaries.SetDefaultValue(true);
+  cmd_record_primaries.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_record_primaries.SetToBeBroadcasted(false);
+
+  cmd_calibration.SetGuidance(
+      "Digitize the energies of the sensitive detectors with the energy "
+      "resolution, thresholds, gains, and dead channels of a calibration "
+      "file, and write them in additional columns. See Digitizer.hh for the "
+      "format of the file. Only supported by the 'edep' and 'event' "
+      "sensitive detectors. The trigger always uses the deposited energies. "
+      "An empty string disables the digitization (default).");
+  cmd_calibration.SetParameterName("file", true);
+  cmd_calibration.SetDefaultValue("");
+  cmd_calibration.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_calibration.SetToBeBroadcasted(false);
+
+  cmd_charge_collection.SetGuidance(
+      "Scale the energy of each deposition with the charge-collection "
+      "efficiency at its depth below the surface of the detector, for each "
+      "variant of the dead layer in the given file, and write the collected "
+      "energies in additional columns. See ChargeCollection.hh for the "
+      "format of the file. Only supported by the 'edep' and 'event' "
+      "sensitive detectors. The trigger, the digitization and the addback "
+      "use the deposited energies. An empty string disables the model "
+      "(default).");
+  cmd_charge_collection.SetParameterName("file", true);
+  cmd_charge_collection.SetDefaultValue("");
+  cmd_charge_collection.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_charge_collection.SetToBeBroadcasted(false);
+
+  cmd_keep_edep.SetGuidance(
+      "Write the deposited energies in addition to the digitized ones "
+      "(default: true). If false, only the digitized energies are written, "
+      "and detectors or events without a response are omitted. Has no "
+      "effect without a calibration file.");
+  cmd_keep_edep.SetParameterName("keep", true);
+  cmd_keep_edep.SetDefaultValue(true);
+  cmd_keep_edep.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_keep_edep.SetToBeBroadcasted(false);
+
+  cmd_addback.SetGuidance(
+      "For each detector with several sensitive volumes, like the four "
+      "crystals of a clover, write the sum of the energies of its crystals "
+      "(addback), the number of crystals with a non-zero energy (fold), and "
+      "a bit pattern of these crystals, in the columns 'addbN', 'foldN', and "
+      "'patN', where N is the ID of the first crystal. The digitized "
+      "energies are used if a calibration file is given. Only supported by "
+      "the 'event' sensitive detector (default: false).");
+  cmd_addback.SetParameterName("addback", true);
+  cmd_addback.SetDefaultValue(true);
+  cmd_addback.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_addback.SetToBeBroadcasted(false);
+
+  cmd_keep_crystals.SetGuidance(
+      "Write the energies of the individual crystals in addition to the "
+      "addback energies (default: true). If false, the columns of detectors "
+      "with several crystals are replaced by their addback columns. Has no "
+      "effect without /analysis/addback.");
+  cmd_keep_crystals.SetParameterName("keep", true);
+  cmd_keep_crystals.SetDefaultValue(true);
+  cmd_keep_crystals.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_keep_crystals.SetToBeBroadcasted(false);
+
+  cmd_time_window.SetGuidance(
+      "Only sum the energy depositions of an event that occur within the "
+      "given time after its earliest deposition, like a detector with a "
+      "finite integration time, and discard later ones, for example from "
+      "the decay of long-lived daughter nuclei. The start of the window is "
+      "written in the column 't0'. Only supported by the 'edep' and 'event' "
+      "sensitive detectors. 0 sums all depositions (default).");
+  cmd_time_window.SetParameterName("length", false);
+  cmd_time_window.SetRange("length >= 0.");
+  cmd_time_window.SetUnitCategory("Time");
+  cmd_time_window.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_time_window.SetToBeBroadcasted(false);
+
+  cmd_split_time_windows.SetGuidance(
+      "Instead of discarding the energy depositions after the time window, "
+      "start a new window with the earliest of them, and write each window "
+      "as a separate pseudo-event, with its index in the column 'win' "
+      "(default: false). Has no effect without /analysis/time_window.");
+  cmd_split_time_windows.SetParameterName("split", true);
+  cmd_split_time_windows.SetDefaultValue(true);
+  cmd_split_time_windows.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_split_time_windows.SetToBeBroadcasted(false);
+
+  cmd_weights.SetGuidance(
+      "Write the statistical weight of the tracks in the column 'weight' "
+      "(default: false). The weight is 1 unless a variance reduction "
+      "technique is used. The 'edep' and 'event' sensitive detectors write "
+      "the mean weight of the energy depositions, weighted by their energy. "
+      "Not supported by track files ('.nutrtrk').");
+  cmd_weights.SetParameterName("write", true);
+  cmd_weights.SetDefaultValue(true);
+  cmd_weights.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_weights.SetToBeBroadcasted(false);
+
+  cmd_spectrum.SetGuidance(
+      "Accumulate the weighted energy spectrum of each detector during the "
+      "run, with the sum of the weights and the sum of the squared weights "
+      "of each bin, and write the spectra to OUTPUT.hist.nutr at the end of "
+      "the run. The 'flux' sensitive detector counts each particle that "
+      "enters a detector in a spectrum of its kinetic energy and its angle of "
+      "incidence (see /analysis/angle_bins) per detector and particle type, "
+      "and writes no rows. 0 bins disable the spectra (default).");
+  auto *n_bins = new G4UIparameter("n_bins", 'i', false);
+  n_bins->SetParameterRange("n_bins >= 0");
+  cmd_spectrum.SetParameter(n_bins);
+  auto *spectrum_min = new G4UIparameter("min", 'd', false);
+  cmd_spectrum.SetParameter(spectrum_min);
+  auto *spectrum_max = new G4UIparameter("max", 'd', false);
+  cmd_spectrum.SetParameter(spectrum_max);
+  auto *spectrum_unit = new G4UIparameter("unit", 's', true);
+  spectrum_unit->SetDefaultValue("keV");
+  cmd_spectrum.SetParameter(spectrum_unit);
+  cmd_spectrum.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_spectrum.SetToBeBroadcasted(false);
+
+  cmd_angle_bins.SetGuidance(
+      "Set the number of bins of the angle of incidence between 0 and 90 "
+      "degrees in the spectra of the 'flux' sensitive detector (default: "
+      "9). Has no effect without /analysis/spectrum.");
+  cmd_angle_bins.SetParameterName("n_bins", false);
+  cmd_angle_bins.SetRange("n_bins > 0");
+  cmd_angle_bins.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_angle_bins.SetToBeBroadcasted(false);
+
+  cmd_track_length.SetGuidance(
+      "Estimate the flux in the 'flux' sensitive detector with the summed "
+      "length of the steps in each detector, multiplied by their weight, "
+      "instead of counting the particles that enter it (default: false). "
+      "This has a much smaller variance for thin detectors. The spectra "
+      "'tlN_PARTICLE' of the step length by kinetic energy are written "
+      "with batch statistics (see /analysis/batch_size). Has no effect "
+      "without /analysis/spectrum.");
+  cmd_track_length.SetParameterName("estimate", true);
+  cmd_track_length.SetDefaultValue(true);
+  cmd_track_length.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_track_length.SetToBeBroadcasted(false);
+
+  cmd_batch_size.SetGuidance(
+      "Set the number of events per batch of the track-length estimator "
+      "(default: 1000). Each bin of a spectrum is filled once per batch with "
+      "the sum of the batch, so that the spread of the batches estimates the "
+      "statistical uncertainty, even if the steps of an event are "
+      "correlated.");
+  cmd_batch_size.SetParameterName("n_events", false);
+  cmd_batch_size.SetRange("n_events > 0");
+  cmd_batch_size.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_batch_size.SetToBeBroadcasted(false);
+
+  cmd_point_detector.SetGuidance(
+      "Add a point detector, at which the photon flux is estimated with the "
+      "next-event estimator: every Compton scattering adds its expected "
+      "contribution to the flux at the point, so that even detectors far "
+      "away from the target get a spectrum with small uncertainties. The "
+      "spectrum 'nee_NAME' is written to OUTPUT.hist.nutr with the binning "
+      "of /analysis/spectrum, so the name of each point detector must be "
+      "unique. See NextEventEstimator.hh for details.");
+  auto *detector_name = new G4UIparameter("name", 's', false);
+  cmd_point_detector.SetParameter(detector_name);
+  for (const char *coordinate : {"x", "y", "z"}) {
+    cmd_point_detector.SetParameter(new G4UIparameter(coordinate, 'd', false));
+  }
+  auto *position_unit = new G4UIparameter("unit", 's', true);
+  position_unit->SetDefaultValue("m");
+  cmd_point_detector.SetParameter(position_unit);
+  cmd_point_detector.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_point_detector.SetToBeBroadcasted(false);
+
+  cmd_point_detector_volume.SetGuidance(
+      "Count the Compton scatterings in the logical volume with the given "
+      "name for the point detectors, for example the target. Can be given "
+      "several times, and at least one volume is needed. The attenuation is "
+      "calculated along a ray from the origin of the volume, so the volumes "
+      "should be small compared to the mean free path of the photons. "
+      "Scatterings in thick shielding or in the world volume would get a "
+      "wrong attenuation.");
+  cmd_point_detector_volume.SetParameterName("volume", false);
+  cmd_point_detector_volume.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_point_detector_volume.SetToBeBroadcasted(false);
+
+  cmd_clear_point_detectors.SetGuidance(
+      "Remove all point detectors and their volumes.");
+  cmd_clear_point_detectors.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_clear_point_detectors.SetToBeBroadcasted(false);
+
+  cmd_scorer.SetGuidance(
+      "Attach a scorer of the given kind to all sensitive volumes, in "
+      "addition to the sensitive detector that writes the rows, and write its "
+      "spectra with the binning of /analysis/spectrum to OUTPUT.hist.nutr: "
+      "'energy' scores the energy deposition per event ('energy_detN'), "
+      "'flux' the particles that enter a volume by kinetic energy and angle "
+      "of incidence ('flux_detN_PARTICLE'), and 'track_length' the "
+      "track-length estimator ('track_length_detN_PARTICLE'). "
+      "'step_points' writes the energy depositions to OUTPUT.nutrstp "
+      "instead (see nutr_reprocess). Can be given several times, but only "
+      "before /run/initialize.");
+  cmd_scorer.SetParameterName("kind", false);
+  std::string scorer_candidates;
+  for (const auto &kind : Scorer::KindNames()) {
+    scorer_candidates += (scorer_candidates.empty() ? "" : " ") + kind;
+  }
+  cmd_scorer.SetCandidates(scorer_candidates.c_str());
+  cmd_scorer.AvailableForStates(G4State_PreInit);
+  cmd_scorer.SetToBeBroadcasted(false);
 }
 
 void NutrMessenger::SetNewValue(G4UIcommand *command, G4String str) {
+  // Geant4 does not catch exceptions of messengers, so an invalid value
+  // would end an interactive session.
+  try {
+    ApplyNewValue(command, str);
+  } catch (const std::exception &error) {
+    G4Exception("NutrMessenger::SetNewValue", "InvalidValue", JustWarning,
+                (std::string(error.what()) + " The command '" +
+                 command->GetCommandPath() + " " + str + "' is ignored.")
+                    .c_str());
+  }
+}
+
+void NutrMessenger::ApplyNewValue(G4UIcommand *command, const G4String &str) {
   if (command == &cmd_filename) {
     filename = str;
+  } else if (command == &cmd_precision) {
+    std::istringstream parameters(str);
+    std::string column, type, unit;
+    double lsb;
+    parameters >> column >> type >> lsb >> unit;
+
+    ColumnPrecision precision;
+    if (type == "float") {
+      precision.type = ColumnPrecision::float32;
+    } else if (type == "quantized") {
+      // ValueOf() returns 0 for an unknown unit.
+      const double unit_value = G4UIcommand::ValueOf(unit.c_str());
+      if (!(unit_value > 0.)) {
+        throw std::runtime_error("Unknown unit '" + unit + "'.");
+      }
+      precision.type = ColumnPrecision::quantized;
+      precision.lsb = lsb * unit_value;
+    }
+    precisions.push_back({column, precision});
+  } else if (command == &cmd_trigger) {
+    // Compile the expression once here, so that syntax errors are reported
+    // when the command is given, and not only at the beginning of a run.
+    if (!str.empty()) {
+      Trigger validated(str);
+    }
+    trigger = str;
+  } else if (command == &cmd_merge) {
+    merge = G4UIcmdWithABool::GetNewBoolValue(str);
+  } else if (command == &cmd_rotate_events) {
+    rotate_events = cmd_rotate_events.GetNewIntValue(str);
+  } else if (command == &cmd_rotate_size) {
+    std::istringstream parameters(str);
+    double size;
+    std::string unit;
+    parameters >> size >> unit;
+
+    const double bytes_per_unit = unit == "GB"   ? 1e9
+                                  : unit == "MB" ? 1e6
+                                  : unit == "kB" ? 1e3
+                                                 : 1.;
+    rotate_bytes = static_cast<uint64_t>(size * bytes_per_unit);
+  } else if (command == &cmd_shard) {
+    shard = cmd_shard.GetNewIntValue(str);
+  } else if (command == &cmd_record_primaries) {
+    record_primaries = G4UIcmdWithABool::GetNewBoolValue(str);
+  } else if (command == &cmd_calibration) {
+    // As for the trigger, an invalid file is reported immediately.
+    if (!str.empty()) {
+      Digitizer validated(str);
+    }
+    calibration = str;
+  } else if (command == &cmd_charge_collection) {
+    // As for the trigger, an invalid file is reported immediately.
+    if (!str.empty()) {
+      ChargeCollection validated(str);
+    }
+    charge_collection = str;
+  } else if (command == &cmd_keep_edep) {
+    keep_edep = G4UIcmdWithABool::GetNewBoolValue(str);
+  } else if (command == &cmd_addback) {
+    addback = G4UIcmdWithABool::GetNewBoolValue(str);
+  } else if (command == &cmd_keep_crystals) {
+    keep_crystals = G4UIcmdWithABool::GetNewBoolValue(str);
+  } else if (command == &cmd_time_window) {
+    time_window = cmd_time_window.GetNewDoubleValue(str);
+  } else if (command == &cmd_split_time_windows) {
+    split_time_windows = G4UIcmdWithABool::GetNewBoolValue(str);
+  } else if (command == &cmd_weights) {
+    write_weights = G4UIcmdWithABool::GetNewBoolValue(str);
+  } else if (command == &cmd_spectrum) {
+    std::istringstream parameters(str);
+    Histogram::Axis axis{"energy", 0, 0., 0.};
+    std::string unit;
+    parameters >> axis.n_bins >> axis.min >> axis.max >> unit;
+    // Otherwise, an unknown unit would be reported as an empty range.
+    const double unit_value = G4UIcommand::ValueOf(unit.c_str());
+    if (!(unit_value > 0.)) {
+      throw std::runtime_error("Unknown unit '" + unit + "'.");
+    }
+    axis.min *= unit_value;
+    axis.max *= unit_value;
+    // As for the trigger, an invalid binning is reported immediately.
+    if (axis.n_bins > 0) {
+      Histogram validated("spectrum", {axis});
+    }
+    spectrum = axis;
+  } else if (command == &cmd_angle_bins) {
+    angle_bins = cmd_angle_bins.GetNewIntValue(str);
+  } else if (command == &cmd_track_length) {
+    track_length = G4UIcmdWithABool::GetNewBoolValue(str);
+  } else if (command == &cmd_batch_size) {
+    batch_size = cmd_batch_size.GetNewIntValue(str);
+  } else if (command == &cmd_point_detector) {
+    std::istringstream parameters(str);
+    PointDetector detector;
+    double x, y, z;
+    std::string unit;
+    parameters >> detector.name >> x >> y >> z >> unit;
+    // An unknown unit would put the detector at the origin.
+    const double unit_value = G4UIcommand::ValueOf(unit.c_str());
+    if (!(unit_value > 0.)) {
+      throw std::runtime_error("Unknown unit '" + unit + "'.");
+    }
+    // The spectra of detectors with the same name would be added up.
+    for (const auto &existing : point_detectors) {
+      if (existing.name == detector.name) {
+        throw std::runtime_error("A point detector named '" + detector.name +
+                                 "' already exists.");
+      }
+    }
+    detector.position = G4ThreeVector(x, y, z) * unit_value;
+    point_detectors.push_back(detector);
+  } else if (command == &cmd_point_detector_volume) {
+    point_detector_volumes.push_back(str);
+  } else if (command == &cmd_clear_point_detectors) {
+    point_detectors.clear();
+    point_detector_volumes.clear();
+  } else if (command == &cmd_scorer) {
+    // A volume only gets one scorer of each kind.
+    if (std::find(scorers.begin(), scorers.end(), str) == scorers.end()) {
+      scorers.push_back(str);
+    }
   }
 }
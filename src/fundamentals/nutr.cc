@@ -17,9 +17,17 @@
     Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
 */
 
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
 #include <string>
 
+using std::make_unique;
 using std::string;
+using std::to_string;
+using std::unique_ptr;
+namespace fs = std::filesystem;
 
 #include <boost/program_options.hpp>
 
@@ -34,8 +42,81 @@ namespace po = boost::program_options;
 
 #include "ActionInitialization.hh"
 #include "DetectorConstruction.hh"
+#include "InstrumentationMessenger.hh"
+#include "MetricsServer.hh"
+#include "NutrBuildOptions.hh"
 #include "NutrMessenger.hh"
 #include "Physics.hh"
+#include "ResultCache.hh"
+#include "RunMetadata.hh"
+#include "StreamWriter.hh"
+
+namespace {
+
+string ReadFile(const string &file_name) {
+  std::ifstream file(file_name);
+  std::ostringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+/**
+ * \brief Hash of the content of the running executable
+ *
+ * The git commit is only determined when CMake is run, so it stays the same
+ * if the code is changed and rebuilt. The libraries of nutr are linked
+ * statically, so the executable changes with every change of the code.
+ *
+ * \return An empty string if the executable cannot be read.
+ */
+string ExecutableHash(const char *argv0) {
+  for (const string &path : {string("/proc/self/exe"), string(argv0)}) {
+    try {
+      return RunMetadata::HashToString(RunMetadata::HashFile(path));
+    } catch (const std::exception &) {
+    }
+  }
+  return "";
+}
+
+/**
+ * \brief Reason why the result of a simulation cannot be taken from a cache
+ *
+ * The configuration only contains the main macro. Therefore, macros which
+ * execute other files, or which change the name of the output file, are
+ * excluded.
+ *
+ * \return An empty string if the result can be cached.
+ */
+string UncacheableReason(const po::variables_map &vm, const string &macro,
+                         const string &executable_hash) {
+  const string output_file_name = vm["output"].as<string>();
+  if (output_file_name.empty()) {
+    return "no output file name was given";
+  }
+  if (StreamWriter::IsStream(output_file_name)) {
+    return "the output is a stream";
+  }
+  if (!vm.count("macro")) {
+    return "no macro file was given";
+  }
+  if (executable_hash.empty()) {
+    return "the executable could not be read";
+  }
+  // The content of other files that a macro reads is not part of the
+  // configuration.
+  for (const string command :
+       {"/control/execute", "/control/loop", "/control/foreach",
+        "/control/shell", "/analysis/filename", "/analysis/calibration",
+        "/analysis/charge_collection"}) {
+    if (macro.find(command) != string::npos) {
+      return "the macro uses the command " + command;
+    }
+  }
+  return "";
+}
+
+} // namespace
 
 int main(int argc, char **argv) {
   po::options_description desc("nutr: new utr - program options");
@@ -47,9 +128,23 @@ int main(int argc, char **argv) {
       "output", po::value<string>()->default_value(""),
       "Output file name. Please note that, in Geant4, the suffix of the output "
       "file determines the output format. If no output file name is specified, "
-      "a time stamp is used. Default: \"\", i.e. use time stamp.")(
+      "a time stamp is used. '-', 'unix:PATH', or the path of a named pipe "
+      "stream the events to the standard output, a Unix domain socket, or the "
+      "pipe. Default: \"\", i.e. use time stamp.")(
       "seed", po::value<long>()->default_value(1),
-      "Set random-number seed. Default: 1.");
+      "Set random-number seed. Default: 1.")(
+      "metrics-port", po::value<int>(),
+      "Serve live metrics of the simulation (processed events, event rate, "
+      "estimated time of arrival, memory, and output size) in the Prometheus "
+      "text format on http://localhost:PORT/metrics.")(
+      "metrics-socket", po::value<string>(),
+      "Serve the live metrics via HTTP on a Unix domain socket at the given "
+      "path instead of a TCP port.")(
+      "cache-dir", po::value<string>(),
+      "Keep a copy of the output in the given directory, indexed by the hash "
+      "of the configuration (build options, seed, and macro). If a result "
+      "with the same configuration exists there, it is copied to the output "
+      "file name instead of running the simulation.");
   po::variables_map vm;
   po::store(po::parse_command_line(argc, argv, desc), vm);
   po::notify(vm);
@@ -59,6 +154,62 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  // Keep the standard output free of any text if the events are streamed to
+  // it. Everything else is printed to the standard error instead.
+  if (vm["output"].as<string>() == "-") {
+    StreamWriter::ReserveStandardOutput();
+  }
+
+  // Everything that determines the result of the simulation, apart from the
+  // version of the Geant4 data sets.
+  const string output_file_name = vm["output"].as<string>();
+  const string macro = vm.count("macro") ? ReadFile(vm["macro"].as<string>())
+                                         : string();
+  const string executable_hash = ExecutableHash(argv[0]);
+  RunMetadata::SetConfiguration({
+      {"nutr_version", nutr_build_options.version},
+      {"git_commit", nutr_build_options.git_commit},
+      {"geant4_version", nutr_build_options.geant4_version},
+      {"executable", fs::path(argv[0]).filename().string()},
+      {"executable_hash", executable_hash},
+      {"sensitive_detector", nutr_build_options.sensitive_detector},
+      {"build_configuration", nutr_build_options.build_configuration},
+      {"seed", to_string(vm["seed"].as<long>())},
+      {"output_format", StreamWriter::IsStream(output_file_name)
+                            ? string("stream")
+                            : fs::path(output_file_name).extension().string()},
+      {"macro", macro},
+  });
+
+  unique_ptr<ResultCache> cache;
+  if (vm.count("cache-dir")) {
+    const string reason = UncacheableReason(vm, macro, executable_hash);
+    if (reason.empty()) {
+      cache = make_unique<ResultCache>(vm["cache-dir"].as<string>());
+    } else {
+      G4cout << "Warning: the result cache is not used, because " << reason
+             << "." << G4endl;
+    }
+  }
+  if (cache != nullptr) {
+    // A cached result that cannot be restored is simulated again.
+    try {
+      const string entry = cache->GetEntry(RunMetadata::GetHash());
+      const auto files =
+          cache->Restore(RunMetadata::GetHash(), output_file_name);
+      if (!files.empty()) {
+        RunMetadata::Write(output_file_name, files, entry);
+        G4cout << "Restored the result of configuration "
+               << RunMetadata::GetHash() << " from the cache '" << entry
+               << "' instead of running the simulation." << G4endl;
+        return 0;
+      }
+    } catch (const std::exception &error) {
+      G4cout << "Warning: the cached result is not used. " << error.what()
+             << G4endl;
+    }
+  }
+
   G4UIExecutive *ui = nullptr;
   if (!vm.count("macro") && isatty(fileno(stdin))) {
     ui = new G4UIExecutive(argc, argv);
@@ -79,6 +230,22 @@ int main(int argc, char **argv) {
       vm["output"].as<string>(), vm["seed"].as<long>()));
 
   NutrMessenger analysisMessenger;
+  InstrumentationMessenger instrumentationMessenger;
+
+  // The simulation does not depend on the metrics, so it also runs if the
+  // server cannot be started, for example because the port is in use.
+  unique_ptr<MetricsServer> metricsServer;
+  try {
+    if (vm.count("metrics-socket")) {
+      metricsServer =
+          make_unique<MetricsServer>(vm["metrics-socket"].as<string>());
+    } else if (vm.count("metrics-port")) {
+      metricsServer = make_unique<MetricsServer>(vm["metrics-port"].as<int>());
+    }
+  } catch (const std::exception &error) {
+    G4cout << "Warning: live metrics are disabled. " << error.what()
+           << G4endl;
+  }
 
   G4VisManager *visManager = new G4VisExecutive();
   visManager->Initialize();
@@ -100,4 +267,16 @@ int main(int argc, char **argv) {
     ui->SessionStart();
     delete ui;
   }
+
+  if (cache != nullptr && !RunMetadata::GetFiles().empty()) {
+    try {
+      cache->Store(RunMetadata::GetHash(), output_file_name,
+                   RunMetadata::GetFiles());
+      G4cout << "Stored the result of configuration " << RunMetadata::GetHash()
+             << " in the cache '" << cache->GetEntry(RunMetadata::GetHash())
+             << "'." << G4endl;
+    } catch (const std::exception &error) {
+      G4cout << "Warning: " << error.what() << G4endl;
+    }
+  }
 }
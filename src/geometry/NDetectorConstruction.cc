@@ -29,6 +29,8 @@ using std::runtime_error;
 #include "G4VisAttributes.hh"
 
 #include "NDetectorConstruction.hh"
+#include "NutrMessenger.hh"
+#include "Scorer.hh"
 #include "SensitiveDetector.hh"
 
 NDetectorConstruction::NDetectorConstruction()
@@ -43,7 +45,10 @@ void NDetectorConstruction::RegisterSensitiveLogicalVolumes(
         "NDetectorConstruction::RegisterSensitiveLogicalVolumes() called with "
         "an empty list.");
   }
+  sensitive_detector_groups.emplace_back();
   for (auto log_vol : logical_volumes) {
+    sensitive_detector_groups.back().push_back(
+        sensitive_logical_volumes.size());
     sensitive_logical_volumes.push_back(log_vol);
   }
 }
@@ -74,5 +79,15 @@ void NDetectorConstruction::ConstructSDandField() {
     G4SDManager::GetSDMpointer()->AddNewDetector(sen_det);
     SetSensitiveDetector(sensitive_logical_volumes[i]->GetName(), sen_det,
                          true);
+
+    // Additional sensitive detectors of the same volume are combined with
+    // the first one in a G4MultiSensitiveDetector.
+    for (const auto &kind : NutrMessenger::GetScorers()) {
+      auto *scorer = new Scorer(sensitive_logical_volumes[i]->GetName(),
+                                Scorer::KindFromName(kind), i);
+      G4SDManager::GetSDMpointer()->AddNewDetector(scorer);
+      SetSensitiveDetector(sensitive_logical_volumes[i]->GetName(), scorer,
+                           true);
+    }
   }
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include "InstrumentationMessenger.hh"
+#include "MemoryMonitor.hh"
+#include "PerfCounters.hh"
+#include "Tracer.hh"
+
+InstrumentationMessenger::InstrumentationMessenger()
+    : dir("/instrumentation/", false),
+      cmd_trace("/instrumentation/trace", this),
+      cmd_trace_buffer_size("/instrumentation/trace_buffer_size", this),
+      cmd_memory_report("/instrumentation/memory_report", this),
+      cmd_memory_report_each_run("/instrumentation/memory_report_each_run",
+                                 this),
+      cmd_perf_counters("/instrumentation/perf_counters", this) {
+  dir.SetGuidance("Controls for the performance instrumentation of nutr.");
+
+  cmd_trace.SetGuidance(
+      "Record a timeline of the phases of each run on all threads and write "
+      "it to the given file in the Chrome trace event format (JSON) at the "
+      "end of the run. The file can be viewed with chrome://tracing or "
+      "https://ui.perfetto.dev. An empty string disables tracing (default).");
+  cmd_trace.SetParameterName("filename", false);
+  cmd_trace.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_trace.SetToBeBroadcasted(false);
+
+  cmd_trace_buffer_size.SetGuidance(
+      "Maximum number of trace events that are recorded per thread and run "
+      "(default: 262144). Must be set before the first run.");
+  cmd_trace_buffer_size.SetParameterName("n_events", false);
+  cmd_trace_buffer_size.SetRange("n_events > 0");
+  cmd_trace_buffer_size.AvailableForStates(G4State_PreInit, G4State_Idle);
+  cmd_trace_buffer_size.SetToBeBroadcasted(false);
+
+  cmd_memory_report.SetGuidance(
+      "Print the memory footprint of nutr: resident set size, G4Allocator "
+      "pools, peak size of hits collections and ntuple size per thread, "
+      "output file sizes, and the number of geometry objects and materials. "
+      "Thread statistics are updated at the end of each run and whenever "
+      "the progress of a run is printed.");
+  cmd_memory_report.SetToBeBroadcasted(false);
+
+  cmd_memory_report_each_run.SetGuidance(
+      "Print a memory report at the beginning and the end of each run "
+      "(default: false).");
+  cmd_memory_report_each_run.SetParameterName("report", true);
+  cmd_memory_report_each_run.SetDefaultValue(true);
+  cmd_memory_report_each_run.SetToBeBroadcasted(false);
+
+  cmd_perf_counters.SetGuidance(
+      "Count CPU cycles, instructions, last-level cache misses, and branch "
+      "misses on each thread, attributed to primary generation, tracking, "
+      "ProcessHits, and end-of-event output, and print them at the end of "
+      "each run (default: false). Requires that nutr was built with the "
+      "CMake option WITH_PERF_COUNTERS.");
+  cmd_perf_counters.SetParameterName("count", true);
+  cmd_perf_counters.SetDefaultValue(true);
+  cmd_perf_counters.SetToBeBroadcasted(false);
+}
+
+void InstrumentationMessenger::SetNewValue(G4UIcommand *command,
+                                           G4String str) {
+  if (command == &cmd_trace) {
+    Tracer::Enable(str);
+  } else if (command == &cmd_trace_buffer_size) {
+    Tracer::SetBufferSize(cmd_trace_buffer_size.GetNewIntValue(str));
+  } else if (command == &cmd_memory_report) {
+    MemoryMonitor::Report("on demand");
+  } else if (command == &cmd_memory_report_each_run) {
+    MemoryMonitor::SetReportAtRunBoundaries(
+        cmd_memory_report_each_run.GetNewBoolValue(str));
+  } else if (command == &cmd_perf_counters) {
+    PerfCounters::SetEnabled(cmd_perf_counters.GetNewBoolValue(str));
+  }
+}
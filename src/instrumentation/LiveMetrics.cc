@@ -0,0 +1,213 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <filesystem>
+#include <sstream>
+
+#include "G4Threading.hh"
+
+#include "LiveMetrics.hh"
+#include "MemoryMonitor.hh"
+
+namespace {
+
+void write_metric(std::ostringstream &out, const string &name,
+                  const string &type, const string &help, const double value) {
+  out << "# HELP " << name << " " << help << "\n"
+      << "# TYPE " << name << " " << type << "\n"
+      << name << " " << value << "\n";
+}
+
+string thread_label(const int thread_id) {
+  return "{thread=\"" +
+         (thread_id < 0 ? string("master") : std::to_string(thread_id)) +
+         "\"}";
+}
+
+} // namespace
+
+void LiveMetrics::record_event() {
+  static G4ThreadLocal ThreadSlot *slot = nullptr;
+  if (slot == nullptr) {
+    slot = register_thread();
+  }
+
+  // Only the owning thread writes to its slot, so a plain load and store is
+  // sufficient and cheaper than an atomic read-modify-write.
+  slot->events.store(slot->events.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+  slot->last_event_time.store(now(), std::memory_order_relaxed);
+}
+
+LiveMetrics::ThreadSlot *LiveMetrics::register_thread() {
+  auto slot = std::make_unique<ThreadSlot>();
+  slot->thread_id = G4Threading::G4GetThreadId();
+
+  std::lock_guard<std::mutex> lock(slots_mutex);
+  slots.push_back(std::move(slot));
+  return slots.back().get();
+}
+
+uint64_t LiveMetrics::total_events() {
+  std::lock_guard<std::mutex> lock(slots_mutex);
+  uint64_t events = 0;
+  for (const auto &slot : slots) {
+    events += slot->events.load(std::memory_order_relaxed);
+  }
+  return events;
+}
+
+void LiveMetrics::BeginOfRun(const int _run_id, const long n_events) {
+  if (!IsEnabled()) {
+    return;
+  }
+  run_events_offset.store(total_events(), std::memory_order_relaxed);
+  run_events_requested.store(n_events, std::memory_order_relaxed);
+  run_start_time.store(now(), std::memory_order_relaxed);
+  run_id.store(_run_id, std::memory_order_relaxed);
+  run_active.store(true, std::memory_order_relaxed);
+}
+
+void LiveMetrics::EndOfRun() {
+  if (!IsEnabled()) {
+    return;
+  }
+  run_end_time.store(now(), std::memory_order_relaxed);
+  run_active.store(false, std::memory_order_relaxed);
+}
+
+void LiveMetrics::SetOutputFile(const string &file_name) {
+  std::lock_guard<std::mutex> lock(output_file_mutex);
+  output_file = file_name;
+}
+
+size_t LiveMetrics::output_bytes() {
+  std::filesystem::path path;
+  {
+    std::lock_guard<std::mutex> lock(output_file_mutex);
+    path = output_file;
+  }
+  if (path.empty()) {
+    return 0;
+  }
+
+  // Depending on the output format, Geant4 writes a single merged file or one
+  // file per thread and ntuple, whose names are derived from the output file
+  // name: STEM_tN.EXT or STEM_nt_NAME_tN.EXT. Rotated files are named
+  // STEM_cN.EXT.
+  const string stem = path.stem().string();
+  const auto directory =
+      path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+
+  size_t bytes = 0;
+  std::error_code error;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(directory, error)) {
+    const string name = entry.path().filename().string();
+    if (name == path.filename().string() || name.rfind(stem + "_t", 0) == 0 ||
+        name.rfind(stem + "_c", 0) == 0 || name.rfind(stem + "_nt_", 0) == 0) {
+      const auto size = entry.file_size(error);
+      if (!error) {
+        bytes += size;
+      }
+    }
+  }
+  return bytes;
+}
+
+string LiveMetrics::Expose() {
+  const int64_t time = now();
+  const uint64_t events = total_events();
+
+  std::ostringstream out;
+  // Large enough to print all event counts exactly.
+  out.precision(15);
+  write_metric(out, "nutr_uptime_seconds", "gauge",
+               "Time since the start of nutr.", 1e-9 * time);
+  write_metric(out, "nutr_events_processed_total", "counter",
+               "Number of events processed by all threads in all runs.",
+               static_cast<double>(events));
+
+  const bool active = run_active.load(std::memory_order_relaxed);
+  const uint64_t run_events =
+      events - run_events_offset.load(std::memory_order_relaxed);
+  const long requested = run_events_requested.load(std::memory_order_relaxed);
+  const double elapsed =
+      1e-9 * ((active ? time : run_end_time.load(std::memory_order_relaxed)) -
+              run_start_time.load(std::memory_order_relaxed));
+  const double rate = elapsed > 0. ? run_events / elapsed : 0.;
+
+  write_metric(out, "nutr_run_id", "gauge", "ID of the current or last run.",
+               run_id.load(std::memory_order_relaxed));
+  write_metric(out, "nutr_run_active", "gauge",
+               "1 if a run is in progress, 0 otherwise.", active ? 1. : 0.);
+  write_metric(out, "nutr_run_events_requested", "gauge",
+               "Number of events to be processed in the current run.",
+               static_cast<double>(requested));
+  write_metric(out, "nutr_run_events_processed", "gauge",
+               "Number of events processed in the current run.",
+               static_cast<double>(run_events));
+  write_metric(out, "nutr_run_elapsed_seconds", "gauge",
+               "Time since the start of the current run.", elapsed);
+  write_metric(out, "nutr_run_event_rate", "gauge",
+               "Average number of events per second in the current run.",
+               rate);
+  write_metric(
+      out, "nutr_run_eta_seconds", "gauge",
+      "Estimated time until the current run is finished, based on the "
+      "average event rate.",
+      active && rate > 0. && requested > static_cast<long>(run_events)
+          ? (requested - static_cast<long>(run_events)) / rate
+          : 0.);
+
+  out << "# HELP nutr_thread_events_processed_total Number of events "
+         "processed by a thread in all runs.\n"
+      << "# TYPE nutr_thread_events_processed_total counter\n";
+  {
+    std::lock_guard<std::mutex> lock(slots_mutex);
+    for (const auto &slot : slots) {
+      out << "nutr_thread_events_processed_total"
+          << thread_label(slot->thread_id) << " "
+          << slot->events.load(std::memory_order_relaxed) << "\n";
+    }
+    out << "# HELP nutr_thread_seconds_since_last_event Time since a thread "
+           "finished its last event. A value that keeps growing during a run "
+           "indicates a stalled thread.\n"
+        << "# TYPE nutr_thread_seconds_since_last_event gauge\n";
+    for (const auto &slot : slots) {
+      out << "nutr_thread_seconds_since_last_event"
+          << thread_label(slot->thread_id) << " "
+          << 1e-9 * (time - slot->last_event_time.load(
+                                std::memory_order_relaxed))
+          << "\n";
+    }
+  }
+
+  write_metric(out, "nutr_resident_memory_bytes", "gauge",
+               "Resident set size of the process.",
+               static_cast<double>(MemoryMonitor::ResidentSetSize()));
+  write_metric(out, "nutr_resident_memory_peak_bytes", "gauge",
+               "Peak resident set size of the process.",
+               static_cast<double>(MemoryMonitor::PeakResidentSetSize()));
+  write_metric(out, "nutr_output_bytes", "gauge",
+               "Size of the output files of the current run on disk.",
+               static_cast<double>(output_bytes()));
+
+  return out.str();
+}
@@ -0,0 +1,190 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using std::ifstream;
+using std::setw;
+
+#include "G4LogicalVolumeStore.hh"
+#include "G4Material.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4SolidStore.hh"
+#include "G4Threading.hh"
+#include "G4ios.hh"
+
+#include "MemoryMonitor.hh"
+
+namespace {
+
+/**
+ * \brief Read a memory entry (in kB) from /proc/self/status
+ *
+ * Returns zero on systems without a /proc file system.
+ */
+size_t proc_status_kB(const string &key) {
+  ifstream status("/proc/self/status");
+  string line;
+  while (std::getline(status, line)) {
+    if (line.rfind(key + ":", 0) == 0) {
+      std::istringstream value(line.substr(key.size() + 1));
+      size_t kB = 0;
+      value >> kB;
+      return kB;
+    }
+  }
+  return 0;
+}
+
+string format_bytes(const size_t bytes) {
+  std::ostringstream s;
+  s << std::fixed << std::setprecision(1);
+  if (bytes >= (size_t(1) << 30)) {
+    s << bytes / double(size_t(1) << 30) << " GiB";
+  } else if (bytes >= (size_t(1) << 20)) {
+    s << bytes / double(size_t(1) << 20) << " MiB";
+  } else if (bytes >= (size_t(1) << 10)) {
+    s << bytes / double(size_t(1) << 10) << " kiB";
+  } else {
+    s << bytes << " B";
+  }
+  return s.str();
+}
+
+} // namespace
+
+vector<std::pair<string, std::function<size_t()>>> &
+MemoryMonitor::allocators() {
+  // Function-local static to be independent of the order of static
+  // initialization, since the hit classes register their allocators during
+  // static initialization.
+  static vector<std::pair<string, std::function<size_t()>>> registered;
+  return registered;
+}
+
+bool MemoryMonitor::RegisterAllocator(const string &name,
+                                      std::function<size_t()> allocated_size) {
+  allocators().emplace_back(name, allocated_size);
+  return true;
+}
+
+MemoryMonitor::ThreadRecord *MemoryMonitor::thread_record() {
+  static G4ThreadLocal ThreadRecord *record = nullptr;
+  if (record == nullptr) {
+    auto new_record = std::make_unique<ThreadRecord>();
+    new_record->thread_id = G4Threading::G4GetThreadId();
+    new_record->allocator_bytes =
+        vector<std::atomic<size_t>>(allocators().size());
+
+    std::lock_guard<std::mutex> lock(records_mutex);
+    records.push_back(std::move(new_record));
+    record = records.back().get();
+  }
+  return record;
+}
+
+void MemoryMonitor::RecordHitsCollectionSize(const size_t size) {
+  auto &peak = thread_record()->hits_collection_peak_size;
+  if (size > peak.load(std::memory_order_relaxed)) {
+    peak.store(size, std::memory_order_relaxed);
+  }
+}
+
+void MemoryMonitor::RecordNtupleRow(const size_t n_columns) {
+  auto record = thread_record();
+  record->ntuple_columns.store(n_columns, std::memory_order_relaxed);
+  record->ntuple_rows.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MemoryMonitor::RecordOutputFile(const string &file_name) {
+  std::lock_guard<std::mutex> lock(output_files_mutex);
+  output_files.push_back(file_name);
+}
+
+size_t MemoryMonitor::ResidentSetSize() {
+  return proc_status_kB("VmRSS") * 1024;
+}
+
+size_t MemoryMonitor::PeakResidentSetSize() {
+  return proc_status_kB("VmHWM") * 1024;
+}
+
+void MemoryMonitor::UpdateThread() {
+  auto record = thread_record();
+  for (size_t i = 0; i < allocators().size(); ++i) {
+    record->allocator_bytes[i].store(allocators()[i].second(),
+                                     std::memory_order_relaxed);
+  }
+}
+
+void MemoryMonitor::Report(const string &title) {
+  std::ostringstream report;
+  report << "Memory report (" << title << ")\n";
+  report << "  Process:  RSS " << format_bytes(ResidentSetSize())
+         << ", peak RSS " << format_bytes(PeakResidentSetSize())
+         << ", virtual " << format_bytes(proc_status_kB("VmSize") * 1024)
+         << "\n";
+  report << "  Geometry: " << G4SolidStore::GetInstance()->size()
+         << " solids, " << G4LogicalVolumeStore::GetInstance()->size()
+         << " logical volumes, " << G4PhysicalVolumeStore::GetInstance()->size()
+         << " physical volumes, " << G4Material::GetNumberOfMaterials()
+         << " materials\n";
+
+  {
+    std::lock_guard<std::mutex> lock(records_mutex);
+    size_t total_allocator_bytes = 0;
+    for (const auto &record : records) {
+      report << "  Thread " << setw(3) << record->thread_id << ":";
+      for (size_t i = 0; i < record->allocator_bytes.size(); ++i) {
+        const size_t bytes =
+            record->allocator_bytes[i].load(std::memory_order_relaxed);
+        total_allocator_bytes += bytes;
+        report << " " << allocators()[i].first << " pool "
+               << format_bytes(bytes) << ",";
+      }
+      report << " hits collection peak "
+             << record->hits_collection_peak_size.load(
+                    std::memory_order_relaxed)
+             << " hits, ntuple "
+             << record->ntuple_rows.load(std::memory_order_relaxed)
+             << " rows x "
+             << record->ntuple_columns.load(std::memory_order_relaxed)
+             << " columns\n";
+    }
+    report << "  Allocator pools of all threads: "
+           << format_bytes(total_allocator_bytes) << "\n";
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(output_files_mutex);
+    for (const auto &file_name : output_files) {
+      std::error_code error;
+      const auto file_size = std::filesystem::file_size(file_name, error);
+      if (!error) {
+        report << "  Output file '" << file_name
+               << "': " << format_bytes(file_size) << "\n";
+      }
+    }
+  }
+
+  G4cout << report.str() << G4endl;
+}
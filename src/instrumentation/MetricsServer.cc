@@ -0,0 +1,193 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+using std::runtime_error;
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "G4ios.hh"
+
+#include "LiveMetrics.hh"
+#include "MetricsServer.hh"
+
+MetricsServer::MetricsServer(const int port) : unix_socket_path("") {
+  listen_socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_socket < 0) {
+    throw runtime_error("MetricsServer: socket() failed: " +
+                        string(std::strerror(errno)));
+  }
+  const int reuse = 1;
+  setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  if (bind(listen_socket, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) < 0) {
+    close(listen_socket);
+    throw runtime_error("MetricsServer: cannot bind to localhost:" +
+                        std::to_string(port) + ": " +
+                        string(std::strerror(errno)));
+  }
+
+  start();
+  G4cout << "Serving live metrics on http://localhost:" << port << "/metrics"
+         << G4endl;
+}
+
+MetricsServer::MetricsServer(const string &socket_path)
+    : unix_socket_path(socket_path) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    throw runtime_error("MetricsServer: socket path '" + socket_path +
+                        "' is too long.");
+  }
+  std::strncpy(address.sun_path, socket_path.c_str(),
+               sizeof(address.sun_path) - 1);
+
+  // Remove a stale socket of a previous run, but never any other file.
+  struct stat status;
+  if (lstat(socket_path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+    unlink(socket_path.c_str());
+  }
+
+  listen_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_socket < 0) {
+    throw runtime_error("MetricsServer: socket() failed: " +
+                        string(std::strerror(errno)));
+  }
+  if (bind(listen_socket, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) < 0) {
+    close(listen_socket);
+    throw runtime_error("MetricsServer: cannot bind to '" + socket_path +
+                        "': " + string(std::strerror(errno)));
+  }
+
+  start();
+  G4cout << "Serving live metrics on the Unix domain socket '" << socket_path
+         << "'" << G4endl;
+}
+
+void MetricsServer::start() {
+  if (listen(listen_socket, 8) < 0 || pipe2(stop_pipe, O_CLOEXEC) < 0) {
+    close(listen_socket);
+    throw runtime_error("MetricsServer: cannot listen: " +
+                        string(std::strerror(errno)));
+  }
+
+  LiveMetrics::Enable();
+  thread = std::thread(&MetricsServer::serve, this);
+}
+
+MetricsServer::~MetricsServer() {
+  // Wake up the server thread, which may be blocked in poll().
+  const char stop = 0;
+  [[maybe_unused]] const auto n_written = write(stop_pipe[1], &stop, 1);
+  thread.join();
+
+  close(stop_pipe[0]);
+  close(stop_pipe[1]);
+  close(listen_socket);
+  if (!unix_socket_path.empty()) {
+    unlink(unix_socket_path.c_str());
+  }
+}
+
+void MetricsServer::serve() {
+  while (true) {
+    pollfd descriptors[2] = {{listen_socket, POLLIN, 0},
+                             {stop_pipe[0], POLLIN, 0}};
+    if (poll(descriptors, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    if (descriptors[1].revents != 0) {
+      return;
+    }
+    if (descriptors[0].revents & POLLIN) {
+      const int client = accept4(listen_socket, nullptr, nullptr, SOCK_CLOEXEC);
+      if (client >= 0) {
+        respond(client);
+        close(client);
+      }
+    }
+  }
+}
+
+void MetricsServer::respond(const int client) {
+  // Do not let a slow or silent client block the server for long.
+  timeval timeout{1, 0};
+  setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  // Only the request line is needed. Read until the end of the header or
+  // until the buffer is full.
+  string request;
+  char buffer[1024];
+  while (request.find("\r\n\r\n") == string::npos && request.size() < 8192) {
+    const ssize_t n_read = recv(client, buffer, sizeof(buffer), 0);
+    if (n_read <= 0) {
+      break;
+    }
+    request.append(buffer, static_cast<size_t>(n_read));
+  }
+
+  string status = "200 OK";
+  string body;
+  if (request.rfind("GET /metrics", 0) == 0 || request.rfind("GET / ", 0) == 0) {
+    body = LiveMetrics::Expose();
+  } else if (request.rfind("GET ", 0) == 0) {
+    status = "404 Not Found";
+    body = "Metrics are served at /metrics.\n";
+  } else {
+    status = "405 Method Not Allowed";
+  }
+
+  const string response = "HTTP/1.0 " + status +
+                          "\r\nContent-Type: text/plain; version=0.0.4"
+                          "\r\nContent-Length: " +
+                          std::to_string(body.size()) +
+                          "\r\nConnection: close\r\n\r\n" + body;
+  size_t n_sent = 0;
+  while (n_sent < response.size()) {
+    const ssize_t n = send(client, response.data() + n_sent,
+                           response.size() - n_sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      break;
+    }
+    n_sent += static_cast<size_t>(n);
+  }
+}
@@ -0,0 +1,289 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <iomanip>
+#include <string>
+
+using std::setw;
+using std::string;
+
+#include "G4Threading.hh"
+#include "G4ios.hh"
+
+#include "PerfCounters.hh"
+
+#if WITH_PERF_COUNTERS
+#include <cerrno>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr array<const char *, PerfCounters::n_phases> phase_names{
+    "other", "generation", "tracking", "ProcessHits", "output"};
+
+void print_row(const string &thread, const char *phase,
+               const array<uint64_t, PerfCounters::n_counters> &counts,
+               const uint64_t total_cycles) {
+  const double kilo_instructions =
+      counts[PerfCounters::instructions] > 0
+          ? 1e-3 * static_cast<double>(counts[PerfCounters::instructions])
+          : 1.;
+  G4cout << std::left << setw(8) << thread << setw(13) << phase << std::right
+         << setw(16) << counts[PerfCounters::cycles] << setw(7) << std::fixed
+         << std::setprecision(1)
+         << (total_cycles > 0 ? 100. * counts[PerfCounters::cycles] /
+                                    static_cast<double>(total_cycles)
+                              : 0.)
+         << setw(16) << counts[PerfCounters::instructions] << setw(7)
+         << std::setprecision(2)
+         << (counts[PerfCounters::cycles] > 0
+                 ? counts[PerfCounters::instructions] /
+                       static_cast<double>(counts[PerfCounters::cycles])
+                 : 0.)
+         << setw(14) << counts[PerfCounters::cache_misses] << setw(9)
+         << counts[PerfCounters::cache_misses] / kilo_instructions << setw(14)
+         << counts[PerfCounters::branch_misses] << setw(9)
+         << counts[PerfCounters::branch_misses] / kilo_instructions << G4endl;
+}
+
+} // namespace
+
+PerfCounters::ThreadCounters::~ThreadCounters() {
+#if WITH_PERF_COUNTERS
+  for (auto file_descriptor : file_descriptors) {
+    if (file_descriptor >= 0) {
+      close(file_descriptor);
+    }
+  }
+#endif
+}
+
+void PerfCounters::SetEnabled(const bool enable) {
+  if (enable && !instrumentation_build_options.with_perf_counters) {
+    G4cout << "Warning: nutr was built without the CMake option "
+              "WITH_PERF_COUNTERS. Hardware performance counters are not "
+              "available."
+           << G4endl;
+    return;
+  }
+  enabled.store(enable, std::memory_order_relaxed);
+}
+
+void PerfCounters::transition(const Phase phase, const bool begin) {
+  static G4ThreadLocal ThreadCounters *counters = nullptr;
+  if (counters == nullptr) {
+    counters = register_thread();
+  }
+  if (!counters->valid) {
+    return;
+  }
+
+  array<uint64_t, n_counters> values;
+  uint64_t time_enabled, time_running;
+  if (!read_counters(*counters, values, time_enabled, time_running)) {
+    return;
+  }
+
+  const Phase current =
+      counters->depth == 0
+          ? other
+          : counters->stack[std::min(counters->depth, max_depth) - 1];
+  for (size_t i = 0; i < n_counters; ++i) {
+    counters->totals[current][i] += values[i] - counters->last_values[i];
+  }
+  counters->time_enabled += time_enabled - counters->last_time_enabled;
+  counters->time_running += time_running - counters->last_time_running;
+  counters->last_values = values;
+  counters->last_time_enabled = time_enabled;
+  counters->last_time_running = time_running;
+
+  if (begin) {
+    if (counters->depth < max_depth) {
+      counters->stack[counters->depth] = phase;
+    }
+    ++counters->depth;
+  } else if (counters->depth > 0 &&
+             (counters->depth > max_depth ||
+              counters->stack[counters->depth - 1] == phase)) {
+    --counters->depth;
+  }
+}
+
+PerfCounters::ThreadCounters *PerfCounters::register_thread() {
+  auto counters = std::make_unique<ThreadCounters>();
+  counters->thread_id = G4Threading::G4GetThreadId();
+  counters->file_descriptors.fill(-1);
+  counters->depth = 0;
+  counters->totals = {};
+  counters->time_enabled = 0;
+  counters->time_running = 0;
+  counters->valid = open_counters(*counters) &&
+                    read_counters(*counters, counters->last_values,
+                                  counters->last_time_enabled,
+                                  counters->last_time_running);
+
+  std::lock_guard<std::mutex> lock(threads_mutex);
+  threads.push_back(std::move(counters));
+  return threads.back().get();
+}
+
+bool PerfCounters::open_counters([[maybe_unused]] ThreadCounters &counters) {
+#if WITH_PERF_COUNTERS
+  constexpr array<uint64_t, n_counters> configs{
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+  // All counters form a group with the cycle counter as the leader. They are
+  // scheduled on the PMU together and can be read with a single system call.
+  for (size_t i = 0; i < n_counters; ++i) {
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = configs[i];
+    attributes.disabled = i == 0 ? 1 : 0;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                             PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // pid = 0 and cpu = -1: count the calling thread on any CPU.
+    const int file_descriptor = static_cast<int>(
+        syscall(SYS_perf_event_open, &attributes, 0, -1,
+                i == 0 ? -1 : counters.file_descriptors[0], 0));
+    if (file_descriptor < 0) {
+      G4cout << "Warning: perf_event_open failed on thread "
+             << counters.thread_id << " (" << std::strerror(errno)
+             << "). Hardware performance counters are disabled for this "
+                "thread. Check /proc/sys/kernel/perf_event_paranoid."
+             << G4endl;
+      return false;
+    }
+    counters.file_descriptors[i] = file_descriptor;
+  }
+
+  ioctl(counters.file_descriptors[0], PERF_EVENT_IOC_RESET,
+        PERF_IOC_FLAG_GROUP);
+  ioctl(counters.file_descriptors[0], PERF_EVENT_IOC_ENABLE,
+        PERF_IOC_FLAG_GROUP);
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool PerfCounters::read_counters(
+    [[maybe_unused]] ThreadCounters &counters,
+    [[maybe_unused]] array<uint64_t, n_counters> &values,
+    [[maybe_unused]] uint64_t &time_enabled,
+    [[maybe_unused]] uint64_t &time_running) {
+#if WITH_PERF_COUNTERS
+  // Layout for PERF_FORMAT_GROUP with the total enabled and running times,
+  // see perf_event_open(2).
+  struct {
+    uint64_t n_values;
+    uint64_t time_enabled;
+    uint64_t time_running;
+    uint64_t values[n_counters];
+  } data;
+
+  if (::read(counters.file_descriptors[0], &data, sizeof(data)) !=
+      static_cast<ssize_t>(sizeof(data))) {
+    return false;
+  }
+  for (size_t i = 0; i < n_counters; ++i) {
+    values[i] = data.values[i];
+  }
+  time_enabled = data.time_enabled;
+  time_running = data.time_running;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void PerfCounters::Report(const int run_id) {
+  if (!IsEnabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(threads_mutex);
+
+  array<array<uint64_t, n_counters>, n_phases> all_threads{};
+  bool multiplexed = false;
+
+  G4cout << "Hardware performance counters of run " << run_id
+         << " (exclusive per phase, user space only)\n"
+         << std::left << setw(8) << "thread" << setw(13) << "phase"
+         << std::right << setw(16) << "cycles" << setw(7) << "%" << setw(16)
+         << "instructions" << setw(7) << "IPC" << setw(14) << "LLC misses"
+         << setw(9) << "/kinstr" << setw(14) << "branch misses" << setw(9)
+         << "/kinstr" << G4endl;
+
+  for (auto &counters : threads) {
+    if (!counters->valid) {
+      continue;
+    }
+    uint64_t total_cycles = 0;
+    for (size_t phase = 0; phase < n_phases; ++phase) {
+      total_cycles += counters->totals[phase][cycles];
+    }
+    if (total_cycles == 0) {
+      continue;
+    }
+
+    const string thread = counters->thread_id < 0
+                              ? string("master")
+                              : std::to_string(counters->thread_id);
+    for (size_t phase = 0; phase < n_phases; ++phase) {
+      print_row(thread, phase_names[phase], counters->totals[phase],
+                total_cycles);
+      for (size_t i = 0; i < n_counters; ++i) {
+        all_threads[phase][i] += counters->totals[phase][i];
+      }
+    }
+    multiplexed = multiplexed || counters->time_running < counters->time_enabled;
+
+    counters->totals = {};
+    counters->time_enabled = 0;
+    counters->time_running = 0;
+  }
+
+  uint64_t total_cycles = 0;
+  for (size_t phase = 0; phase < n_phases; ++phase) {
+    total_cycles += all_threads[phase][cycles];
+  }
+  for (size_t phase = 0; phase < n_phases; ++phase) {
+    print_row("all", phase_names[phase], all_threads[phase], total_cycles);
+  }
+
+  if (multiplexed) {
+    G4cout << "Warning: the counters had to share the PMU with other events. "
+              "Absolute counts are underestimated, but ratios are still "
+              "valid."
+           << G4endl;
+  }
+}
@@ -0,0 +1,121 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+
+using std::ofstream;
+
+#include "G4Threading.hh"
+#include "G4ios.hh"
+
+#include "Tracer.hh"
+
+void Tracer::Enable(const string &file_name) {
+  trace_file_name = file_name;
+  enabled.store(!file_name.empty(), std::memory_order_relaxed);
+}
+
+void Tracer::record(const char *name, const char phase) {
+  static G4ThreadLocal TraceBuffer *buffer = nullptr;
+  if (buffer == nullptr) {
+    buffer = register_thread();
+  }
+
+  if (buffer->n_events == buffer->events.size()) [[unlikely]] {
+    ++buffer->n_dropped;
+    return;
+  }
+  buffer->events[buffer->n_events++] = {
+      name, (std::chrono::steady_clock::now() - epoch).count(), phase};
+}
+
+Tracer::TraceBuffer *Tracer::register_thread() {
+  auto buffer = std::make_unique<TraceBuffer>();
+  buffer->thread_id = G4Threading::G4GetThreadId();
+  buffer->events.resize(buffer_size);
+  buffer->n_events = 0;
+  buffer->n_dropped = 0;
+
+  std::lock_guard<std::mutex> lock(buffers_mutex);
+  buffers.push_back(std::move(buffer));
+  return buffers.back().get();
+}
+
+void Tracer::Dump(const int run_id) {
+  if (!IsEnabled()) {
+    return;
+  }
+
+  std::filesystem::path file_name(trace_file_name);
+  if (run_id > 0) {
+    file_name.replace_filename(file_name.stem().string() + "_run" +
+                               std::to_string(run_id) +
+                               file_name.extension().string());
+  }
+
+  std::lock_guard<std::mutex> lock(buffers_mutex);
+
+  ofstream file(file_name);
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  // Chrome trace timestamps are given in microseconds.
+  constexpr double to_microseconds =
+      1e6 * std::chrono::steady_clock::period::num /
+      std::chrono::steady_clock::period::den;
+
+  bool first_event = true;
+  size_t n_dropped = 0;
+  for (auto &buffer : buffers) {
+    // The master thread has the ID -1, shift all IDs by one to obtain
+    // non-negative track numbers.
+    const int tid = buffer->thread_id + 1;
+    file << (first_event ? "" : ",") << "\n{\"name\":\"thread_name\","
+         << "\"ph\":\"M\",\"pid\":0,\"tid\":" << tid
+         << ",\"args\":{\"name\":\""
+         << (buffer->thread_id < 0
+                 ? string("master")
+                 : "worker " + std::to_string(buffer->thread_id))
+         << "\"}}";
+    first_event = false;
+
+    for (size_t i = 0; i < buffer->n_events; ++i) {
+      const auto &event = buffer->events[i];
+      file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase
+           << "\",\"pid\":0,\"tid\":" << tid << ",\"ts\":" << std::fixed
+           << std::setprecision(3) << event.time_stamp * to_microseconds
+           << "}";
+    }
+
+    n_dropped += buffer->n_dropped;
+    buffer->n_events = 0;
+    buffer->n_dropped = 0;
+  }
+  file << "\n]}\n";
+
+  G4cout << "Wrote timeline trace to '" << file_name.string() << "'." << G4endl;
+  if (n_dropped > 0) {
+    G4cout << "Warning: " << n_dropped
+           << " trace events were dropped because the trace buffers were "
+              "full. Increase the buffer size with "
+              "/instrumentation/trace_buffer_size."
+           << G4endl;
+  }
+}
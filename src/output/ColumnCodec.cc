@@ -0,0 +1,483 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+using std::numeric_limits;
+using std::runtime_error;
+
+#include "ColumnCodec.hh"
+#include "OutputBuildOptions.hh"
+
+#if OUTPUT_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace columnar {
+
+namespace {
+
+// A low compression level is sufficient, because the bulk of the size
+// reduction is achieved by the column encodings. Higher levels would make the
+// compression slower than writing the uncompressed data to disk.
+constexpr int zstd_level = 1;
+
+// Plain and packed columns are copied as they are in memory.
+static_assert(std::endian::native == std::endian::little,
+              "Column chunks are little-endian.");
+
+template <typename T> void append(string &bytes, const T value) {
+  bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> T read(const uint8_t *data) {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+size_t n_words(const size_t n_values, const unsigned int bits) {
+  return (n_values * bits + 63) / 64;
+}
+
+size_t bitmap_size(const size_t n_values) { return (n_values + 7) / 8; }
+
+void corrupt_chunk() { throw runtime_error("Corrupt column chunk."); }
+
+/**
+ * \brief Append values with the given number of bits to a byte string
+ */
+class BitPacker {
+public:
+  BitPacker(string &_bytes, const unsigned int _bits)
+      : bytes(_bytes), bits(_bits), word(0), used(0) {}
+
+  void push(const uint64_t value) {
+    if (bits == 0) {
+      return;
+    }
+    word |= value << used;
+    used += bits;
+    if (used >= 64) {
+      append(bytes, word);
+      used -= 64;
+      word = used > 0 ? value >> (bits - used) : 0;
+    }
+  }
+  void finish() {
+    if (used > 0) {
+      append(bytes, word);
+    }
+  }
+
+private:
+  string &bytes;
+  const unsigned int bits;
+  uint64_t word;
+  unsigned int used;
+};
+
+template <typename Store>
+void unpack(const uint8_t *data, const size_t size, const size_t n_values,
+            const unsigned int bits, Store store) {
+  if (bits > 64 || size < n_words(n_values, bits) * sizeof(uint64_t)) {
+    corrupt_chunk();
+  }
+  if (bits == 0) {
+    for (size_t i = 0; i < n_values; ++i) {
+      store(i, 0);
+    }
+    return;
+  }
+
+  const uint64_t mask =
+      bits == 64 ? numeric_limits<uint64_t>::max() : (uint64_t(1) << bits) - 1;
+  size_t bit = 0;
+  for (size_t i = 0; i < n_values; ++i, bit += bits) {
+    const size_t word = bit / 64;
+    const unsigned int offset = bit % 64;
+    uint64_t value = read<uint64_t>(data + word * sizeof(uint64_t)) >> offset;
+    if (offset + bits > 64) {
+      value |= read<uint64_t>(data + (word + 1) * sizeof(uint64_t))
+               << (64 - offset);
+    }
+    store(i, value & mask);
+  }
+}
+
+void compress([[maybe_unused]] EncodedChunk &chunk) {
+#if OUTPUT_WITH_ZSTD
+  string compressed(ZSTD_compressBound(chunk.bytes.size()), '\0');
+  const size_t compressed_size =
+      ZSTD_compress(compressed.data(), compressed.size(), chunk.bytes.data(),
+                    chunk.bytes.size(), zstd_level);
+  // Only keep the compressed chunk if it is at least 10% smaller, because
+  // decompression is not free either.
+  if (!ZSTD_isError(compressed_size) &&
+      compressed_size * 10 < chunk.bytes.size() * 9) {
+    compressed.resize(compressed_size);
+    chunk.bytes = std::move(compressed);
+    chunk.codec |= compressed_flag;
+  }
+#endif
+}
+
+const uint8_t *decompress(const uint8_t *data, size_t &size,
+                          const uint64_t encoded_size, const uint8_t codec,
+                          [[maybe_unused]] string &buffer) {
+  if (!(codec & compressed_flag)) {
+    if (size != encoded_size) {
+      corrupt_chunk();
+    }
+    return data;
+  }
+#if OUTPUT_WITH_ZSTD
+  buffer.resize(encoded_size);
+  const size_t decompressed_size =
+      ZSTD_decompress(buffer.data(), buffer.size(), data, size);
+  if (ZSTD_isError(decompressed_size) || decompressed_size != encoded_size) {
+    throw runtime_error("Corrupt compressed column chunk.");
+  }
+  size = encoded_size;
+  return reinterpret_cast<const uint8_t *>(buffer.data());
+#else
+  throw runtime_error("Column chunk is compressed with zstd, but nutr was "
+                      "built without zstd support.");
+#endif
+}
+
+template <typename T>
+EncodedChunk encode_floating_point(const vector<T> &values) {
+  using Bits = std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t>;
+
+  EncodedChunk chunk{"", 0, plain};
+  const size_t n_values = values.size();
+
+  // Only positive zero is treated as a zero, so that the bit pattern of each
+  // value is restored exactly.
+  size_t n_non_zero = 0;
+  for (const auto value : values) {
+    n_non_zero += std::bit_cast<Bits>(value) != 0;
+  }
+
+  const size_t plain_size = n_values * sizeof(T);
+  const size_t sparse_size = bitmap_size(n_values) + n_non_zero * sizeof(T);
+
+  if (sparse_size < plain_size) {
+    chunk.codec = sparse;
+    chunk.bytes.resize(bitmap_size(n_values));
+    chunk.bytes.reserve(sparse_size);
+    for (size_t i = 0; i < n_values; ++i) {
+      if (std::bit_cast<Bits>(values[i]) != 0) {
+        chunk.bytes[i / 8] = static_cast<char>(
+            static_cast<uint8_t>(chunk.bytes[i / 8]) | (1 << (i % 8)));
+        append(chunk.bytes, values[i]);
+      }
+    }
+  } else {
+    chunk.bytes.assign(reinterpret_cast<const char *>(values.data()),
+                       plain_size);
+  }
+
+  chunk.encoded_size = chunk.bytes.size();
+  compress(chunk);
+  return chunk;
+}
+
+template <typename T>
+void decode_floating_point(const uint8_t *data, size_t size,
+                           const uint64_t encoded_size, const uint8_t codec,
+                           const size_t n_rows, vector<T> &values) {
+  string buffer;
+  data = decompress(data, size, encoded_size, codec, buffer);
+
+  const size_t first = values.size();
+  values.resize(first + n_rows);
+  T *destination = values.data() + first;
+
+  switch (codec & ~compressed_flag) {
+  case plain:
+    if (size != n_rows * sizeof(T)) {
+      corrupt_chunk();
+    }
+    std::memcpy(destination, data, size);
+    return;
+  case sparse: {
+    if (size < bitmap_size(n_rows) ||
+        (size - bitmap_size(n_rows)) % sizeof(T) != 0) {
+      corrupt_chunk();
+    }
+    const uint8_t *non_zero = data + bitmap_size(n_rows);
+    const uint8_t *end = data + size;
+    for (size_t i = 0; i < n_rows; ++i) {
+      if (data[i / 8] & (1 << (i % 8))) {
+        if (non_zero == end) {
+          corrupt_chunk();
+        }
+        destination[i] = read<T>(non_zero);
+        non_zero += sizeof(T);
+      } else {
+        destination[i] = 0.;
+      }
+    }
+    return;
+  }
+  default:
+    throw runtime_error("Unknown codec '" + CodecName(codec) +
+                        "' of floating-point column chunk.");
+  }
+}
+
+} // namespace
+
+EncodedChunk EncodeIntegers(const vector<int64_t> &values) {
+  EncodedChunk chunk{"", 0, plain};
+  const size_t n_values = values.size();
+
+  if (n_values > 0) {
+    // Differences are calculated with unsigned integers, since they may
+    // overflow the signed type. The wrap-around cancels out when decoding.
+    int64_t min = values[0], max = values[0];
+    int64_t min_delta = 0, max_delta = 0;
+    int64_t min_non_zero = 0, max_non_zero = 0;
+    size_t n_non_zero = 0;
+    for (size_t i = 0; i < n_values; ++i) {
+      min = std::min(min, values[i]);
+      max = std::max(max, values[i]);
+      if (i > 0) {
+        const auto delta = static_cast<int64_t>(
+            static_cast<uint64_t>(values[i]) -
+            static_cast<uint64_t>(values[i - 1]));
+        min_delta = i == 1 ? delta : std::min(min_delta, delta);
+        max_delta = i == 1 ? delta : std::max(max_delta, delta);
+      }
+      if (values[i] != 0) {
+        min_non_zero =
+            n_non_zero == 0 ? values[i] : std::min(min_non_zero, values[i]);
+        max_non_zero =
+            n_non_zero == 0 ? values[i] : std::max(max_non_zero, values[i]);
+        ++n_non_zero;
+      }
+    }
+
+    const unsigned int bits = std::bit_width(static_cast<uint64_t>(max) -
+                                             static_cast<uint64_t>(min));
+    const unsigned int delta_bits =
+        std::bit_width(static_cast<uint64_t>(max_delta) -
+                       static_cast<uint64_t>(min_delta));
+    const unsigned int non_zero_bits =
+        std::bit_width(static_cast<uint64_t>(max_non_zero) -
+                       static_cast<uint64_t>(min_non_zero));
+
+    const size_t sizes[] = {
+        n_values * sizeof(int64_t),
+        sizeof(int64_t) + sizeof(uint8_t) +
+            n_words(n_values, bits) * sizeof(uint64_t),
+        2 * sizeof(int64_t) + sizeof(uint8_t) +
+            n_words(n_values - 1, delta_bits) * sizeof(uint64_t),
+        bitmap_size(n_values) + sizeof(int64_t) + sizeof(uint8_t) +
+            n_words(n_non_zero, non_zero_bits) * sizeof(uint64_t)};
+    chunk.codec = static_cast<uint8_t>(
+        std::min_element(std::begin(sizes), std::end(sizes)) - sizes);
+    chunk.bytes.reserve(sizes[chunk.codec]);
+
+    switch (chunk.codec) {
+    case plain:
+      chunk.bytes.assign(reinterpret_cast<const char *>(values.data()),
+                         sizes[plain]);
+      break;
+    case frame_of_reference: {
+      append(chunk.bytes, min);
+      append(chunk.bytes, static_cast<uint8_t>(bits));
+      BitPacker packer(chunk.bytes, bits);
+      for (const auto value : values) {
+        packer.push(static_cast<uint64_t>(value) - static_cast<uint64_t>(min));
+      }
+      packer.finish();
+      break;
+    }
+    case delta: {
+      append(chunk.bytes, values[0]);
+      append(chunk.bytes, min_delta);
+      append(chunk.bytes, static_cast<uint8_t>(delta_bits));
+      BitPacker packer(chunk.bytes, delta_bits);
+      for (size_t i = 1; i < n_values; ++i) {
+        packer.push(static_cast<uint64_t>(values[i]) -
+                    static_cast<uint64_t>(values[i - 1]) -
+                    static_cast<uint64_t>(min_delta));
+      }
+      packer.finish();
+      break;
+    }
+    case sparse: {
+      chunk.bytes.resize(bitmap_size(n_values));
+      for (size_t i = 0; i < n_values; ++i) {
+        if (values[i] != 0) {
+          chunk.bytes[i / 8] = static_cast<char>(
+              static_cast<uint8_t>(chunk.bytes[i / 8]) | (1 << (i % 8)));
+        }
+      }
+      append(chunk.bytes, min_non_zero);
+      append(chunk.bytes, static_cast<uint8_t>(non_zero_bits));
+      BitPacker packer(chunk.bytes, non_zero_bits);
+      for (const auto value : values) {
+        if (value != 0) {
+          packer.push(static_cast<uint64_t>(value) -
+                      static_cast<uint64_t>(min_non_zero));
+        }
+      }
+      packer.finish();
+      break;
+    }
+    }
+  }
+
+  chunk.encoded_size = chunk.bytes.size();
+  compress(chunk);
+  return chunk;
+}
+
+EncodedChunk EncodeFloats(const vector<double> &values) {
+  return encode_floating_point(values);
+}
+
+EncodedChunk EncodeFloats(const vector<float> &values) {
+  return encode_floating_point(values);
+}
+
+void DecodeIntegers(const uint8_t *data, size_t size,
+                    const uint64_t encoded_size, const uint8_t codec,
+                    const size_t n_rows, vector<int64_t> &values) {
+  string buffer;
+  data = decompress(data, size, encoded_size, codec, buffer);
+
+  const size_t first = values.size();
+  values.resize(first + n_rows);
+  int64_t *destination = values.data() + first;
+
+  if (n_rows == 0) {
+    return;
+  }
+
+  switch (codec & ~compressed_flag) {
+  case plain:
+    if (size != n_rows * sizeof(int64_t)) {
+      corrupt_chunk();
+    }
+    std::memcpy(destination, data, size);
+    return;
+  case frame_of_reference: {
+    constexpr size_t offset = sizeof(int64_t) + sizeof(uint8_t);
+    if (size < offset) {
+      corrupt_chunk();
+    }
+    const auto min = read<uint64_t>(data);
+    unpack(data + offset, size - offset, n_rows, data[sizeof(int64_t)],
+           [&](size_t i, uint64_t remainder) {
+             destination[i] = static_cast<int64_t>(min + remainder);
+           });
+    return;
+  }
+  case delta: {
+    constexpr size_t offset = 2 * sizeof(int64_t) + sizeof(uint8_t);
+    if (size < offset) {
+      corrupt_chunk();
+    }
+    auto value = read<uint64_t>(data);
+    const auto min_delta = read<uint64_t>(data + sizeof(int64_t));
+    destination[0] = static_cast<int64_t>(value);
+    unpack(data + offset, size - offset, n_rows - 1,
+           data[2 * sizeof(int64_t)], [&](size_t i, uint64_t remainder) {
+             value += min_delta + remainder;
+             destination[i + 1] = static_cast<int64_t>(value);
+           });
+    return;
+  }
+  case sparse: {
+    const size_t offset =
+        bitmap_size(n_rows) + sizeof(int64_t) + sizeof(uint8_t);
+    if (size < offset) {
+      corrupt_chunk();
+    }
+    size_t n_non_zero = 0;
+    for (size_t i = 0; i < bitmap_size(n_rows); ++i) {
+      n_non_zero += std::popcount(data[i]);
+    }
+    const auto min = read<uint64_t>(data + bitmap_size(n_rows));
+    // Unpack the non-zero values to the front of the destination first, and
+    // then move them to their rows from the back to the front.
+    unpack(data + offset, size - offset, n_non_zero,
+           data[offset - sizeof(uint8_t)], [&](size_t i, uint64_t remainder) {
+             destination[i] = static_cast<int64_t>(min + remainder);
+           });
+    size_t next = n_non_zero;
+    for (size_t i = n_rows; i-- > 0;) {
+      destination[i] =
+          (data[i / 8] & (1 << (i % 8))) ? destination[--next] : 0;
+    }
+    return;
+  }
+  default:
+    throw runtime_error("Unknown codec '" + CodecName(codec) +
+                        "' of integer column chunk.");
+  }
+}
+
+void DecodeFloats(const uint8_t *data, const size_t size,
+                  const uint64_t encoded_size, const uint8_t codec,
+                  const size_t n_rows, vector<double> &values) {
+  decode_floating_point(data, size, encoded_size, codec, n_rows, values);
+}
+
+void DecodeFloats(const uint8_t *data, const size_t size,
+                  const uint64_t encoded_size, const uint8_t codec,
+                  const size_t n_rows, vector<float> &values) {
+  decode_floating_point(data, size, encoded_size, codec, n_rows, values);
+}
+
+string CodecName(const uint8_t codec) {
+  string name;
+  switch (codec & ~compressed_flag) {
+  case plain:
+    name = "plain";
+    break;
+  case frame_of_reference:
+    name = "frame_of_reference";
+    break;
+  case delta:
+    name = "delta";
+    break;
+  case sparse:
+    name = "sparse";
+    break;
+  default:
+    name = "unknown(" + std::to_string(codec & ~compressed_flag) + ")";
+  }
+  if (codec & compressed_flag) {
+    name += "+zstd";
+  }
+  return name;
+}
+
+} // namespace columnar
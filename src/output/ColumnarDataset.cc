@@ -0,0 +1,148 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <filesystem>
+#include <stdexcept>
+
+using std::make_unique;
+using std::runtime_error;
+
+#include "ColumnarDataset.hh"
+#include "Manifest.hh"
+
+ColumnarDataset::ColumnarDataset(const string &path)
+    : ColumnarDataset(vector<string>{path}) {}
+
+ColumnarDataset::ColumnarDataset(const vector<string> &paths) {
+  vector<string> file_paths;
+  for (const auto &path : paths) {
+    if (std::filesystem::path(path).extension() == manifest::extension) {
+      const auto manifest_files = manifest::Read(path);
+      file_paths.insert(file_paths.end(), manifest_files.begin(),
+                        manifest_files.end());
+    } else {
+      file_paths.push_back(path);
+    }
+  }
+
+  for (const auto &file_path : file_paths) {
+    files.push_back(make_unique<ColumnarReader>(file_path));
+    const auto &file_tables = files.back()->GetTables();
+
+    vector<size_t> ids(tables.size(), missing);
+    for (size_t i = 0; i < file_tables.size(); ++i) {
+      size_t table = 0;
+      while (table < tables.size() &&
+             tables[table].name != file_tables[i].name) {
+        ++table;
+      }
+      if (table == tables.size()) {
+        tables.push_back(file_tables[i]);
+        ids.push_back(i);
+        for (auto &previous_ids : table_ids) {
+          previous_ids.push_back(missing);
+        }
+      } else if (tables[table].columns != file_tables[i].columns) {
+        throw runtime_error("The columns of table '" + file_tables[i].name +
+                            "' in '" + file_path +
+                            "' do not match the other files of the dataset.");
+      } else {
+        ids[table] = i;
+      }
+    }
+    table_ids.push_back(ids);
+  }
+}
+
+size_t ColumnarDataset::GetTableID(const string &name) const {
+  for (size_t i = 0; i < tables.size(); ++i) {
+    if (tables[i].name == name) {
+      return i;
+    }
+  }
+  throw runtime_error("No table '" + name + "' in the dataset.");
+}
+
+size_t ColumnarDataset::GetColumnID(const size_t table,
+                                    const string &name) const {
+  const auto &columns = tables.at(table).columns;
+  for (size_t i = 0; i < columns.size(); ++i) {
+    if (columns[i].name == name) {
+      return i;
+    }
+  }
+  throw runtime_error("No column '" + name + "' in table '" +
+                      tables[table].name + "' of the dataset.");
+}
+
+uint64_t ColumnarDataset::GetNumberOfRows(const size_t table) const {
+  uint64_t n_rows = 0;
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (GetFileTableID(i, table) != missing) {
+      n_rows += files[i]->GetNumberOfRows(GetFileTableID(i, table));
+    }
+  }
+  return n_rows;
+}
+
+vector<ColumnarDataset::RowGroup>
+ColumnarDataset::GetRowGroups(const size_t table) const {
+  vector<RowGroup> row_groups;
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (GetFileTableID(i, table) != missing) {
+      for (const auto row_group :
+           files[i]->GetRowGroups(GetFileTableID(i, table))) {
+        row_groups.push_back({i, row_group});
+      }
+    }
+  }
+  return row_groups;
+}
+
+void ColumnarDataset::ReadColumn(const RowGroup &row_group, const size_t table,
+                                 const size_t column,
+                                 vector<int64_t> &values) const {
+  files.at(row_group.file)
+      ->ReadColumn(row_group.row_group, GetFileTableID(row_group.file, table),
+                   column, values);
+}
+
+void ColumnarDataset::ReadColumn(const RowGroup &row_group, const size_t table,
+                                 const size_t column,
+                                 vector<double> &values) const {
+  files.at(row_group.file)
+      ->ReadColumn(row_group.row_group, GetFileTableID(row_group.file, table),
+                   column, values);
+}
+
+void ColumnarDataset::ReadColumn(const size_t table, const size_t column,
+                                 vector<int64_t> &values) const {
+  values.reserve(values.size() + GetNumberOfRows(table));
+  for (const auto &row_group : GetRowGroups(table)) {
+    ReadColumn(row_group, table, column, values);
+  }
+}
+
+void ColumnarDataset::ReadColumn(const size_t table, const size_t column,
+                                 vector<double> &values) const {
+  values.reserve(values.size() + GetNumberOfRows(table));
+  for (const auto &row_group : GetRowGroups(table)) {
+    ReadColumn(row_group, table, column, values);
+  }
+}
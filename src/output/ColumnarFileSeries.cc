@@ -0,0 +1,119 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include "ColumnarFileSeries.hh"
+#include "Manifest.hh"
+
+using std::lock_guard;
+
+mutex ColumnarFileSeries::registry_mutex;
+map<string, std::pair<unique_ptr<ColumnarFileSeries>, unsigned int>>
+    ColumnarFileSeries::registry;
+
+ColumnarFileSeries *ColumnarFileSeries::Acquire(const string &path,
+                                                const uint64_t max_events,
+                                                const uint64_t max_bytes) {
+  lock_guard<mutex> lock(registry_mutex);
+
+  auto &entry = registry[path];
+  if (entry.first == nullptr) {
+    entry.first.reset(new ColumnarFileSeries(path, max_events, max_bytes));
+  }
+  ++entry.second;
+  return entry.first.get();
+}
+
+void ColumnarFileSeries::Release(ColumnarFileSeries *series) {
+  lock_guard<mutex> lock(registry_mutex);
+
+  auto entry = registry.find(series->path);
+  if (entry != registry.end() && entry->second.first.get() == series &&
+      --entry->second.second == 0) {
+    registry.erase(entry);
+  }
+}
+
+ColumnarFileSeries::ColumnarFileSeries(const string &_path,
+                                       const uint64_t _max_events,
+                                       const uint64_t _max_bytes)
+    : path(_path), max_events(_max_events), max_bytes(_max_bytes),
+      latest_chunk(0), n_events(0) {
+  // Start with an empty index, so that no chunks of a previous run with the
+  // same file name are listed.
+  manifest::Write(manifest::ManifestFileName(path), {});
+}
+
+unsigned int ColumnarFileSeries::AddEvent(const unsigned int current_chunk,
+                                          const uint64_t bytes) {
+  unsigned int latest = latest_chunk;
+  if (latest != current_chunk) {
+    return latest;
+  }
+  const uint64_t events = ++n_events;
+  if ((max_events > 0 && events > max_events) ||
+      (max_bytes > 0 && bytes >= max_bytes)) {
+    // Only one thread starts the next chunk. The others see the new chunk in
+    // their next call.
+    if (latest_chunk.compare_exchange_strong(latest, current_chunk + 1)) {
+      n_events = 1;
+      return current_chunk + 1;
+    }
+  }
+  return latest;
+}
+
+ColumnarFileWriter *ColumnarFileSeries::AcquireChunk(unsigned int &chunk) {
+  lock_guard<mutex> lock(chunk_mutex);
+
+  // The latest chunk may already be complete if all threads that wrote to it
+  // have finished the run. Reopening it would overwrite it.
+  chunk = latest_chunk;
+  while (completed.count(chunk)) {
+    if (latest_chunk.compare_exchange_strong(chunk, chunk + 1)) {
+      n_events = 0;
+      ++chunk;
+    }
+  }
+  return ColumnarFileWriter::Acquire(manifest::ChunkFileName(path, chunk));
+}
+
+void ColumnarFileSeries::ReleaseChunk(ColumnarFileWriter *file,
+                                      const unsigned int chunk) {
+  lock_guard<mutex> lock(chunk_mutex);
+
+  if (!ColumnarFileWriter::Release(file)) {
+    return;
+  }
+  completed[chunk] = manifest::ChunkFileName(path, chunk);
+  vector<string> file_names;
+  for (const auto &entry : completed) {
+    file_names.push_back(entry.second);
+  }
+  manifest::Write(manifest::ManifestFileName(path), file_names);
+}
+
+vector<string> ColumnarFileSeries::GetCompletedFileNames() const {
+  lock_guard<mutex> lock(chunk_mutex);
+
+  vector<string> file_names;
+  for (const auto &entry : completed) {
+    file_names.push_back(entry.second);
+  }
+  return file_names;
+}
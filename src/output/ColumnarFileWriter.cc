@@ -0,0 +1,167 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+using std::lock_guard;
+using std::runtime_error;
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ColumnarFileWriter.hh"
+
+mutex ColumnarFileWriter::registry_mutex;
+map<string, std::pair<unique_ptr<ColumnarFileWriter>, unsigned int>>
+    ColumnarFileWriter::registry;
+
+ColumnarFileWriter *ColumnarFileWriter::Acquire(const string &path) {
+  lock_guard<mutex> lock(registry_mutex);
+
+  auto &entry = registry[path];
+  if (entry.first == nullptr) {
+    entry.first.reset(new ColumnarFileWriter(path));
+  }
+  ++entry.second;
+  return entry.first.get();
+}
+
+bool ColumnarFileWriter::Release(ColumnarFileWriter *file) {
+  lock_guard<mutex> lock(registry_mutex);
+
+  auto entry = registry.find(file->GetPath());
+  if (entry == registry.end() || entry->second.first.get() != file) {
+    return false;
+  }
+  if (--entry->second.second == 0) {
+    // Remove the file from the registry before finalizing it, so that the
+    // path can be reused even if writing the footer fails.
+    auto last_user = std::move(entry->second.first);
+    registry.erase(entry);
+    last_user->Finalize();
+    return true;
+  }
+  return false;
+}
+
+ColumnarFileWriter::ColumnarFileWriter(const string &_path)
+    : path(_path), file_descriptor(-1), end_of_data(columnar::header_size),
+      n_writers(0) {
+  file_descriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (file_descriptor < 0) {
+    throw runtime_error("Could not create output file '" + path +
+                        "': " + std::strerror(errno));
+  }
+
+  char header[columnar::header_size];
+  std::memcpy(header, columnar::magic, sizeof(columnar::magic));
+  std::memcpy(header + sizeof(columnar::magic), &columnar::format_version,
+              sizeof(columnar::format_version));
+  WriteAt(header, sizeof(header), 0);
+}
+
+ColumnarFileWriter::~ColumnarFileWriter() {
+  if (file_descriptor >= 0) {
+    close(file_descriptor);
+  }
+}
+
+uint32_t ColumnarFileWriter::DefineTable(const columnar::TableSchema &schema) {
+  lock_guard<mutex> lock(footer_mutex);
+
+  for (uint32_t i = 0; i < footer.tables.size(); ++i) {
+    if (footer.tables[i].name == schema.name) {
+      if (!(footer.tables[i] == schema)) {
+        throw runtime_error("Table '" + schema.name + "' in output file '" +
+                            path +
+                            "' was defined with different columns by "
+                            "different threads.");
+      }
+      return i;
+    }
+  }
+  footer.tables.push_back(schema);
+  return static_cast<uint32_t>(footer.tables.size() - 1);
+}
+
+void ColumnarFileWriter::WriteRowGroup(
+    const uint32_t table, const uint32_t writer, const uint64_t n_rows,
+    const vector<columnar::EncodedChunk> &chunks) {
+  uint64_t size = 0;
+  for (const auto &chunk : chunks) {
+    size += chunk.bytes.size();
+  }
+  uint64_t offset = end_of_data.fetch_add(size);
+
+  columnar::RowGroupInfo row_group{table, writer, n_rows, {}};
+  row_group.chunks.reserve(chunks.size());
+  for (const auto &chunk : chunks) {
+    WriteAt(chunk.bytes.data(), chunk.bytes.size(), offset);
+    row_group.chunks.push_back(
+        {offset, chunk.bytes.size(), chunk.encoded_size, chunk.codec});
+    offset += chunk.bytes.size();
+  }
+
+  lock_guard<mutex> lock(footer_mutex);
+  footer.row_groups.push_back(std::move(row_group));
+}
+
+void ColumnarFileWriter::WriteAt(const char *data, size_t size,
+                                 uint64_t offset) {
+  while (size > 0) {
+    const ssize_t written =
+        pwrite(file_descriptor, data, size, static_cast<off_t>(offset));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw runtime_error("Could not write to output file '" + path +
+                          "': " + std::strerror(errno));
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+    offset += static_cast<uint64_t>(written);
+  }
+}
+
+void ColumnarFileWriter::Finalize() {
+  const string serialized_footer = columnar::SerializeFooter(footer);
+  const uint64_t footer_offset = end_of_data;
+  const uint64_t footer_size = serialized_footer.size();
+
+  char trailer[columnar::trailer_size];
+  std::memcpy(trailer, &footer_offset, sizeof(footer_offset));
+  std::memcpy(trailer + sizeof(footer_offset), &footer_size,
+              sizeof(footer_size));
+  std::memcpy(trailer + 2 * sizeof(uint64_t), columnar::magic,
+              sizeof(columnar::magic));
+
+  WriteAt(serialized_footer.data(), footer_size, footer_offset);
+  WriteAt(trailer, sizeof(trailer), footer_offset + footer_size);
+
+  if (close(file_descriptor) != 0) {
+    file_descriptor = -1;
+    throw runtime_error("Could not close output file '" + path +
+                        "': " + std::strerror(errno));
+  }
+  file_descriptor = -1;
+}
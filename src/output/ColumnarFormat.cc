@@ -0,0 +1,195 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <cstring>
+#include <stdexcept>
+
+using std::runtime_error;
+
+#include "ColumnarFormat.hh"
+
+namespace columnar {
+
+namespace {
+
+class ByteWriter {
+public:
+  template <typename T> void put(const T value) {
+    bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+  void put_string(const string &value) {
+    put<uint32_t>(static_cast<uint32_t>(value.size()));
+    bytes.append(value);
+  }
+
+  string bytes;
+};
+
+class ByteReader {
+public:
+  ByteReader(const uint8_t *_data, const size_t _size)
+      : data(_data), size(_size), position(0) {}
+
+  template <typename T> T get() {
+    require(sizeof(T));
+    T value;
+    std::memcpy(&value, data + position, sizeof(T));
+    position += sizeof(T);
+    return value;
+  }
+  string get_string() {
+    const auto length = get<uint32_t>();
+    require(length);
+    string value(reinterpret_cast<const char *>(data + position), length);
+    position += length;
+    return value;
+  }
+
+private:
+  void require(const size_t n_bytes) const {
+    if (position + n_bytes > size) {
+      throw runtime_error("Corrupt footer in columnar file.");
+    }
+  }
+
+  const uint8_t *data;
+  const size_t size;
+  size_t position;
+};
+
+} // namespace
+
+size_t ColumnTypeSize(const ColumnType type) {
+  switch (type) {
+  case ColumnType::int32:
+    return sizeof(int32_t);
+  case ColumnType::float64:
+    return sizeof(double);
+  case ColumnType::float32:
+    return sizeof(float);
+  case ColumnType::quantized:
+  case ColumnType::int64:
+    return sizeof(int64_t);
+  }
+  return 0;
+}
+
+bool IsIntegerType(const ColumnType type) {
+  return type == ColumnType::int32 || type == ColumnType::int64;
+}
+
+string ColumnTypeName(const ColumnType type) {
+  switch (type) {
+  case ColumnType::int32:
+    return "int32";
+  case ColumnType::float64:
+    return "float64";
+  case ColumnType::float32:
+    return "float32";
+  case ColumnType::quantized:
+    return "quantized";
+  case ColumnType::int64:
+    return "int64";
+  }
+  return "unknown";
+}
+
+string SerializeFooter(const Footer &footer) {
+  ByteWriter writer;
+
+  writer.put<uint32_t>(static_cast<uint32_t>(footer.tables.size()));
+  for (const auto &table : footer.tables) {
+    writer.put_string(table.name);
+    writer.put_string(table.title);
+    writer.put<uint32_t>(static_cast<uint32_t>(table.columns.size()));
+    for (const auto &column : table.columns) {
+      writer.put_string(column.name);
+      writer.put<uint8_t>(static_cast<uint8_t>(column.type));
+      if (column.type == ColumnType::quantized) {
+        writer.put<double>(column.scale);
+      }
+    }
+  }
+
+  writer.put<uint64_t>(footer.row_groups.size());
+  for (const auto &row_group : footer.row_groups) {
+    writer.put<uint32_t>(row_group.table);
+    writer.put<uint32_t>(row_group.writer);
+    writer.put<uint64_t>(row_group.n_rows);
+    for (const auto &chunk : row_group.chunks) {
+      writer.put<uint64_t>(chunk.offset);
+      writer.put<uint64_t>(chunk.stored_size);
+      writer.put<uint64_t>(chunk.encoded_size);
+      writer.put<uint8_t>(chunk.codec);
+    }
+  }
+
+  return writer.bytes;
+}
+
+Footer ParseFooter(const uint8_t *data, const size_t size) {
+  ByteReader reader(data, size);
+  Footer footer;
+
+  const auto n_tables = reader.get<uint32_t>();
+  for (uint32_t i = 0; i < n_tables; ++i) {
+    TableSchema table;
+    table.name = reader.get_string();
+    table.title = reader.get_string();
+    const auto n_columns = reader.get<uint32_t>();
+    for (uint32_t j = 0; j < n_columns; ++j) {
+      ColumnSchema column;
+      column.name = reader.get_string();
+      column.type = static_cast<ColumnType>(reader.get<uint8_t>());
+      if (column.type > ColumnType::int64) {
+        throw runtime_error("Unknown column type in columnar file.");
+      }
+      if (column.type == ColumnType::quantized) {
+        column.scale = reader.get<double>();
+      }
+      table.columns.push_back(column);
+    }
+    footer.tables.push_back(table);
+  }
+
+  const auto n_row_groups = reader.get<uint64_t>();
+  for (uint64_t i = 0; i < n_row_groups; ++i) {
+    RowGroupInfo row_group;
+    row_group.table = reader.get<uint32_t>();
+    row_group.writer = reader.get<uint32_t>();
+    row_group.n_rows = reader.get<uint64_t>();
+    if (row_group.table >= footer.tables.size()) {
+      throw runtime_error("Corrupt footer in columnar file.");
+    }
+    for (size_t j = 0; j < footer.tables[row_group.table].columns.size();
+         ++j) {
+      ChunkInfo chunk;
+      chunk.offset = reader.get<uint64_t>();
+      chunk.stored_size = reader.get<uint64_t>();
+      chunk.encoded_size = reader.get<uint64_t>();
+      chunk.codec = reader.get<uint8_t>();
+      row_group.chunks.push_back(chunk);
+    }
+    footer.row_groups.push_back(row_group);
+  }
+
+  return footer;
+}
+
+} // namespace columnar
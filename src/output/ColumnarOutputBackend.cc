@@ -0,0 +1,286 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+using std::cerr;
+using std::endl;
+using std::runtime_error;
+
+#include "ColumnCodec.hh"
+#include "ColumnarOutputBackend.hh"
+
+ColumnarOutputBackend::~ColumnarOutputBackend() {
+  // Releasing the last user of a file writes its footer. Only CloseFile()
+  // reports an error of that to the caller, since a destructor must not
+  // throw.
+  try {
+    ReleaseFile();
+  } catch (const std::exception &e) {
+    cerr << e.what() << endl;
+  }
+  if (series != nullptr) {
+    ColumnarFileSeries::Release(series);
+  }
+}
+
+void ColumnarOutputBackend::OpenFile(const string &_file_name) {
+  if (file != nullptr || series != nullptr) {
+    CloseFile();
+  }
+  file_name = _file_name;
+  completed_file_names.clear();
+  if (max_events > 0 || max_bytes > 0) {
+    series = ColumnarFileSeries::Acquire(file_name, max_events, max_bytes);
+  } else {
+    file = ColumnarFileWriter::Acquire(file_name);
+    writer = file->NewWriter();
+  }
+  tables.clear();
+}
+
+void ColumnarOutputBackend::OpenChunk() {
+  file = series->AcquireChunk(chunk);
+  writer = file->NewWriter();
+  for (auto &table : tables) {
+    table.id = file->DefineTable(table.schema);
+  }
+}
+
+void ColumnarOutputBackend::ReleaseFile() {
+  if (file == nullptr) {
+    return;
+  }
+  auto *released = file;
+  file = nullptr;
+  if (series != nullptr) {
+    series->ReleaseChunk(released, chunk);
+  } else {
+    ColumnarFileWriter::Release(released);
+  }
+}
+
+int ColumnarOutputBackend::CreateNtuple(const string &name,
+                                        const string &title) {
+  tables.push_back(Table{{name, title, {}}, 0, 0, 0, {}});
+  return static_cast<int>(tables.size() - 1);
+}
+
+int ColumnarOutputBackend::CreateNtupleIColumn(const string &name) {
+  return CreateColumn({name, columnar::ColumnType::int32});
+}
+
+int ColumnarOutputBackend::CreateNtupleLColumn(const string &name) {
+  return CreateColumn({name, columnar::ColumnType::int64});
+}
+
+int ColumnarOutputBackend::CreateNtupleDColumn(
+    const string &name, const ColumnPrecision precision) {
+  switch (precision.type) {
+  case ColumnPrecision::float32:
+    return CreateColumn({name, columnar::ColumnType::float32});
+  case ColumnPrecision::quantized:
+    return CreateColumn({name, columnar::ColumnType::quantized, precision.lsb});
+  default:
+    return CreateColumn({name, columnar::ColumnType::float64});
+  }
+}
+
+int ColumnarOutputBackend::CreateColumn(const columnar::ColumnSchema &schema) {
+  if (tables.empty()) {
+    throw runtime_error("Column '" + schema.name +
+                        "' created before any ntuple in output file '" +
+                        file_name + "'.");
+  }
+  auto &table = tables.back();
+  table.schema.columns.push_back(schema);
+  table.columns.push_back(Column{0, 0., {}, {}, {}});
+  return static_cast<int>(table.columns.size() - 1);
+}
+
+void ColumnarOutputBackend::FinishNtuple() {
+  if (tables.empty()) {
+    return;
+  }
+  auto &table = tables.back();
+  if (file != nullptr) {
+    table.id = file->DefineTable(table.schema);
+  }
+  // The size of a file only grows when row groups are written, so smaller
+  // row groups are needed to rotate files by size with some accuracy.
+  const uint64_t group_bytes =
+      max_bytes > 0 ? std::clamp<uint64_t>(max_bytes / 16, min_row_group_bytes,
+                                           row_group_bytes)
+                    : row_group_bytes;
+  table.rows_per_group = std::max<uint64_t>(
+      1, group_bytes /
+             (sizeof(int64_t) * std::max<size_t>(1, table.columns.size())));
+}
+
+ColumnarOutputBackend::Column *
+ColumnarOutputBackend::GetColumn(const int ntuple, const int column,
+                                 const bool floating_point) {
+  if (ntuple < 0 || static_cast<size_t>(ntuple) >= tables.size()) {
+    return nullptr;
+  }
+  auto &table = tables[ntuple];
+  if (column < 0 || static_cast<size_t>(column) >= table.columns.size() ||
+      columnar::IsIntegerType(table.schema.columns[column].type) ==
+          floating_point) {
+    return nullptr;
+  }
+  return &table.columns[column];
+}
+
+bool ColumnarOutputBackend::FillNtupleIColumn(const int ntuple,
+                                              const int column,
+                                              const int value) {
+  auto *col = GetColumn(ntuple, column, false);
+  if (col == nullptr) {
+    return false;
+  }
+  col->integer = value;
+  return true;
+}
+
+bool ColumnarOutputBackend::FillNtupleLColumn(const int ntuple,
+                                              const int column,
+                                              const int64_t value) {
+  auto *col = GetColumn(ntuple, column, false);
+  if (col == nullptr) {
+    return false;
+  }
+  col->integer = value;
+  return true;
+}
+
+bool ColumnarOutputBackend::FillNtupleDColumn(const int ntuple,
+                                              const int column,
+                                              const double value) {
+  auto *col = GetColumn(ntuple, column, true);
+  if (col == nullptr) {
+    return false;
+  }
+  col->floating_point = value;
+  return true;
+}
+
+bool ColumnarOutputBackend::AddNtupleRow(const int ntuple) {
+  if (ntuple < 0 || static_cast<size_t>(ntuple) >= tables.size()) {
+    return false;
+  }
+  auto &table = tables[ntuple];
+  for (size_t i = 0; i < table.columns.size(); ++i) {
+    auto &column = table.columns[i];
+    switch (table.schema.columns[i].type) {
+    case columnar::ColumnType::int32:
+    case columnar::ColumnType::int64:
+      column.integers.push_back(column.integer);
+      break;
+    case columnar::ColumnType::float64:
+      column.doubles.push_back(column.floating_point);
+      break;
+    case columnar::ColumnType::float32:
+      column.floats.push_back(static_cast<float>(column.floating_point));
+      break;
+    case columnar::ColumnType::quantized:
+      column.integers.push_back(
+          Quantize(column.floating_point, table.schema.columns[i].scale));
+      break;
+    }
+  }
+  if (++table.n_rows >= table.rows_per_group) {
+    Flush(table);
+  }
+  return true;
+}
+
+void ColumnarOutputBackend::NewEvent() {
+  if (series == nullptr) {
+    return;
+  }
+  if (file == nullptr) {
+    OpenChunk();
+  }
+  if (series->AddEvent(chunk, file->GetSize()) != chunk) {
+    Write();
+    ReleaseFile();
+    OpenChunk();
+  }
+}
+
+void ColumnarOutputBackend::Flush(Table &table) {
+  if (table.n_rows > 0 && file == nullptr && series != nullptr) {
+    OpenChunk();
+  }
+  if (table.n_rows == 0 || file == nullptr) {
+    return;
+  }
+
+  vector<columnar::EncodedChunk> chunks;
+  chunks.reserve(table.columns.size());
+  for (size_t i = 0; i < table.columns.size(); ++i) {
+    auto &column = table.columns[i];
+    switch (table.schema.columns[i].type) {
+    case columnar::ColumnType::int32:
+    case columnar::ColumnType::int64:
+    case columnar::ColumnType::quantized:
+      chunks.push_back(columnar::EncodeIntegers(column.integers));
+      column.integers.clear();
+      break;
+    case columnar::ColumnType::float64:
+      chunks.push_back(columnar::EncodeFloats(column.doubles));
+      column.doubles.clear();
+      break;
+    case columnar::ColumnType::float32:
+      chunks.push_back(columnar::EncodeFloats(column.floats));
+      column.floats.clear();
+      break;
+    }
+  }
+  file->WriteRowGroup(table.id, writer, table.n_rows, chunks);
+  table.n_rows = 0;
+}
+
+void ColumnarOutputBackend::Write() {
+  for (auto &table : tables) {
+    Flush(table);
+  }
+}
+
+void ColumnarOutputBackend::CloseFile() {
+  Write();
+  ReleaseFile();
+  if (series != nullptr) {
+    completed_file_names = series->GetCompletedFileNames();
+    auto *released = series;
+    series = nullptr;
+    ColumnarFileSeries::Release(released);
+  }
+}
+
+vector<string> ColumnarOutputBackend::GetFileNames() const {
+  if (max_events > 0 || max_bytes > 0) {
+    return series != nullptr ? series->GetCompletedFileNames()
+                             : completed_file_names;
+  }
+  return {file_name};
+}
@@ -0,0 +1,226 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+using std::runtime_error;
+using std::to_string;
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ColumnCodec.hh"
+#include "ColumnarReader.hh"
+
+ColumnarReader::ColumnarReader(const string &_path)
+    : path(_path), file_descriptor(-1), data(nullptr), size(0) {
+  file_descriptor = open(path.c_str(), O_RDONLY);
+  if (file_descriptor < 0) {
+    throw runtime_error("Could not open '" + path +
+                        "': " + std::strerror(errno));
+  }
+
+  struct stat status;
+  if (fstat(file_descriptor, &status) != 0) {
+    close(file_descriptor);
+    throw runtime_error("Could not determine the size of '" + path +
+                        "': " + std::strerror(errno));
+  }
+  size = static_cast<size_t>(status.st_size);
+  if (size < columnar::header_size + columnar::trailer_size) {
+    close(file_descriptor);
+    throw runtime_error("'" + path + "' is not a nutr columnar file.");
+  }
+
+  void *mapping =
+      mmap(nullptr, size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+  if (mapping == MAP_FAILED) {
+    close(file_descriptor);
+    throw runtime_error("Could not map '" + path +
+                        "' into memory: " + std::strerror(errno));
+  }
+  data = static_cast<const uint8_t *>(mapping);
+
+  try {
+    const uint8_t *trailer = data + size - columnar::trailer_size;
+    if (std::memcmp(data, columnar::magic, sizeof(columnar::magic)) != 0 ||
+        std::memcmp(trailer + 2 * sizeof(uint64_t), columnar::magic,
+                    sizeof(columnar::magic)) != 0) {
+      throw runtime_error("'" + path +
+                          "' is not a complete nutr columnar file.");
+    }
+    uint64_t version, footer_offset, footer_size;
+    std::memcpy(&version, data + sizeof(columnar::magic), sizeof(version));
+    if (version != columnar::format_version) {
+      throw runtime_error("'" + path + "' has unsupported format version " +
+                          to_string(version) + ".");
+    }
+    std::memcpy(&footer_offset, trailer, sizeof(footer_offset));
+    std::memcpy(&footer_size, trailer + sizeof(footer_offset),
+                sizeof(footer_size));
+    if (footer_offset < columnar::header_size ||
+        footer_offset + footer_size != size - columnar::trailer_size) {
+      throw runtime_error("Corrupt trailer in '" + path + "'.");
+    }
+    footer = columnar::ParseFooter(data + footer_offset, footer_size);
+    for (const auto &row_group : footer.row_groups) {
+      for (const auto &chunk : row_group.chunks) {
+        if (chunk.offset < columnar::header_size ||
+            chunk.offset + chunk.stored_size > footer_offset) {
+          throw runtime_error("Corrupt footer in '" + path + "'.");
+        }
+      }
+    }
+  } catch (...) {
+    munmap(const_cast<uint8_t *>(data), size);
+    close(file_descriptor);
+    throw;
+  }
+}
+
+ColumnarReader::~ColumnarReader() {
+  munmap(const_cast<uint8_t *>(data), size);
+  close(file_descriptor);
+}
+
+size_t ColumnarReader::GetTableID(const string &name) const {
+  for (size_t i = 0; i < footer.tables.size(); ++i) {
+    if (footer.tables[i].name == name) {
+      return i;
+    }
+  }
+  throw runtime_error("No table '" + name + "' in '" + path + "'.");
+}
+
+size_t ColumnarReader::GetColumnID(const size_t table,
+                                   const string &name) const {
+  const auto &columns = footer.tables.at(table).columns;
+  for (size_t i = 0; i < columns.size(); ++i) {
+    if (columns[i].name == name) {
+      return i;
+    }
+  }
+  throw runtime_error("No column '" + name + "' in table '" +
+                      footer.tables[table].name + "' of '" + path + "'.");
+}
+
+uint64_t ColumnarReader::GetNumberOfRows(const size_t table) const {
+  uint64_t n_rows = 0;
+  for (const auto &row_group : footer.row_groups) {
+    if (row_group.table == table) {
+      n_rows += row_group.n_rows;
+    }
+  }
+  return n_rows;
+}
+
+vector<size_t> ColumnarReader::GetRowGroups(const size_t table) const {
+  vector<size_t> row_groups;
+  for (size_t i = 0; i < footer.row_groups.size(); ++i) {
+    if (footer.row_groups[i].table == table) {
+      row_groups.push_back(i);
+    }
+  }
+  return row_groups;
+}
+
+const columnar::ChunkInfo &
+ColumnarReader::GetChunk(const size_t row_group, const size_t table,
+                         const size_t column) const {
+  const auto &info = footer.row_groups.at(row_group);
+  if (info.table != table || column >= footer.tables.at(table).columns.size()) {
+    throw runtime_error("No column " + to_string(column) + " in row group " +
+                        to_string(row_group) + " of table " +
+                        to_string(table) + " in '" + path + "'.");
+  }
+  return info.chunks[column];
+}
+
+void ColumnarReader::ReadColumn(const size_t row_group, const size_t table,
+                                const size_t column,
+                                vector<int64_t> &values) const {
+  const auto &chunk = GetChunk(row_group, table, column);
+  const auto type = footer.tables[table].columns[column].type;
+  if (!columnar::IsIntegerType(type)) {
+    throw runtime_error("Column '" + footer.tables[table].columns[column].name +
+                        "' in '" + path + "' has type " +
+                        columnar::ColumnTypeName(type) +
+                        " and cannot be read as integers.");
+  }
+  columnar::DecodeIntegers(data + chunk.offset, chunk.stored_size,
+                           chunk.encoded_size, chunk.codec,
+                           footer.row_groups[row_group].n_rows, values);
+}
+
+void ColumnarReader::ReadColumn(const size_t row_group, const size_t table,
+                                const size_t column,
+                                vector<double> &values) const {
+  const auto &chunk = GetChunk(row_group, table, column);
+  const auto n_rows = footer.row_groups[row_group].n_rows;
+  const auto &schema = footer.tables[table].columns[column];
+  switch (schema.type) {
+  case columnar::ColumnType::int32:
+  case columnar::ColumnType::int64:
+  case columnar::ColumnType::quantized: {
+    vector<int64_t> integers;
+    integers.reserve(n_rows);
+    columnar::DecodeIntegers(data + chunk.offset, chunk.stored_size,
+                             chunk.encoded_size, chunk.codec, n_rows,
+                             integers);
+    const double scale =
+        schema.type == columnar::ColumnType::quantized ? schema.scale : 1.;
+    for (const auto integer : integers) {
+      values.push_back(static_cast<double>(integer) * scale);
+    }
+    return;
+  }
+  case columnar::ColumnType::float32: {
+    vector<float> floats;
+    floats.reserve(n_rows);
+    columnar::DecodeFloats(data + chunk.offset, chunk.stored_size,
+                           chunk.encoded_size, chunk.codec, n_rows, floats);
+    values.insert(values.end(), floats.begin(), floats.end());
+    return;
+  }
+  case columnar::ColumnType::float64:
+    columnar::DecodeFloats(data + chunk.offset, chunk.stored_size,
+                           chunk.encoded_size, chunk.codec, n_rows, values);
+    return;
+  }
+}
+
+void ColumnarReader::ReadColumn(const size_t table, const size_t column,
+                                vector<int64_t> &values) const {
+  values.reserve(values.size() + GetNumberOfRows(table));
+  for (const auto row_group : GetRowGroups(table)) {
+    ReadColumn(row_group, table, column, values);
+  }
+}
+
+void ColumnarReader::ReadColumn(const size_t table, const size_t column,
+                                vector<double> &values) const {
+  values.reserve(values.size() + GetNumberOfRows(table));
+  for (const auto row_group : GetRowGroups(table)) {
+    ReadColumn(row_group, table, column, values);
+  }
+}
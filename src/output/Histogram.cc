@@ -0,0 +1,147 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+
+using std::runtime_error;
+namespace fs = std::filesystem;
+
+#include "ColumnarOutputBackend.hh"
+#include "Histogram.hh"
+
+size_t Histogram::Axis::Bin(const double x) const {
+  if (!(x >= min)) {
+    // Also NaN, which is counted as underflow.
+    return 0;
+  }
+  if (x >= max) {
+    return n_bins + 1;
+  }
+  // Rounding may put values just below max into the overflow bin otherwise.
+  return std::min(static_cast<size_t>((x - min) / (max - min) *
+                                      static_cast<double>(n_bins)),
+                  n_bins - 1) +
+         1;
+}
+
+double Histogram::Axis::LowEdge(const size_t bin) const {
+  if (bin == 0) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  return min + (max - min) * static_cast<double>(bin - 1) /
+                   static_cast<double>(n_bins);
+}
+
+double Histogram::Axis::HighEdge(const size_t bin) const {
+  if (bin > n_bins) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return bin == n_bins ? max : LowEdge(bin + 1);
+}
+
+Histogram::Histogram(const string &_name, const vector<Axis> &_axes)
+    : name(_name), axes(_axes) {
+  if (axes.empty() || axes.size() > 2) {
+    throw runtime_error("Histogram '" + name +
+                        "' must have one or two axes.");
+  }
+  size_t n_cells = 1;
+  for (const auto &axis : axes) {
+    if (axis.n_bins == 0 || !(axis.max > axis.min)) {
+      throw runtime_error("Axis '" + axis.name + "' of histogram '" + name +
+                          "' has no bins or an empty range.");
+    }
+    n_cells *= axis.n_bins + 2;
+  }
+  entries.assign(n_cells, 0);
+  sum_weights.assign(n_cells, 0.);
+  sum_squared_weights.assign(n_cells, 0.);
+}
+
+void Histogram::Add(const Histogram &other) {
+  if (other.axes != axes) {
+    throw runtime_error("Cannot add histograms '" + other.name + "' and '" +
+                        name + "' with different axes.");
+  }
+  for (size_t cell = 0; cell < sum_weights.size(); ++cell) {
+    entries[cell] += other.entries[cell];
+    sum_weights[cell] += other.sum_weights[cell];
+    sum_squared_weights[cell] += other.sum_squared_weights[cell];
+  }
+}
+
+void Histogram::PadEntries(const uint64_t n_entries) {
+  for (auto &cell_entries : entries) {
+    cell_entries = std::max(cell_entries, n_entries);
+  }
+}
+
+size_t Histogram::GetBin(const size_t cell, const size_t axis) const {
+  return axis == 0 ? cell % (axes[0].n_bins + 2) : cell / (axes[0].n_bins + 2);
+}
+
+namespace histogram {
+
+string HistogramFileName(const string &output_file_name) {
+  return fs::path(output_file_name).replace_extension(extension).string();
+}
+
+void Write(const string &path, const vector<Histogram> &histograms) {
+  ColumnarOutputBackend output;
+  output.OpenFile(path);
+  for (const auto &histogram : histograms) {
+    output.CreateNtuple(histogram.GetName(), histogram.GetName());
+    for (const auto &axis : histogram.GetAxes()) {
+      output.CreateNtupleDColumn(axis.name + "_low", ColumnPrecision());
+      output.CreateNtupleDColumn(axis.name + "_high", ColumnPrecision());
+    }
+    output.CreateNtupleLColumn("entries");
+    output.CreateNtupleDColumn("sumw", ColumnPrecision());
+    output.CreateNtupleDColumn("sumw2", ColumnPrecision());
+    output.FinishNtuple();
+  }
+
+  for (size_t ntuple = 0; ntuple < histograms.size(); ++ntuple) {
+    const auto &histogram = histograms[ntuple];
+    const auto &axes = histogram.GetAxes();
+    const int n = static_cast<int>(ntuple);
+    for (size_t cell = 0; cell < histogram.GetNumberOfCells(); ++cell) {
+      int column = 0;
+      for (size_t axis = 0; axis < axes.size(); ++axis) {
+        const size_t bin = histogram.GetBin(cell, axis);
+        output.FillNtupleDColumn(n, column++, axes[axis].LowEdge(bin));
+        output.FillNtupleDColumn(n, column++, axes[axis].HighEdge(bin));
+      }
+      output.FillNtupleLColumn(
+          n, column++, static_cast<int64_t>(histogram.GetEntries(cell)));
+      output.FillNtupleDColumn(n, column++, histogram.GetSumWeights(cell));
+      output.FillNtupleDColumn(n, column++,
+                               histogram.GetSumSquaredWeights(cell));
+      output.AddNtupleRow(n);
+    }
+  }
+  output.Write();
+  output.CloseFile();
+}
+
+} // namespace histogram
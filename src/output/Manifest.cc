@@ -0,0 +1,105 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+using std::runtime_error;
+namespace fs = std::filesystem;
+
+#include "Manifest.hh"
+
+namespace manifest {
+
+string ManifestFileName(const string &output_file_name) {
+  return fs::path(output_file_name).replace_extension(extension).string();
+}
+
+namespace {
+
+string InsertBeforeSuffix(const string &file_name, const string &infix) {
+  fs::path path(file_name);
+  path.replace_filename(path.stem().string() + infix +
+                        path.extension().string());
+  return path.string();
+}
+
+} // namespace
+
+string ThreadFileName(const string &output_file_name, const int thread_id) {
+  return InsertBeforeSuffix(output_file_name,
+                            "_t" + std::to_string(thread_id));
+}
+
+string ChunkFileName(const string &output_file_name,
+                     const unsigned int chunk) {
+  return InsertBeforeSuffix(output_file_name, "_c" + std::to_string(chunk));
+}
+
+void Write(const string &path, const vector<string> &files) {
+  const fs::path directory = fs::absolute(path).parent_path();
+
+  // Write to a temporary file and rename it, so that a reader never sees an
+  // incomplete manifest, even if it is updated during a run.
+  const string temporary_path = path + ".tmp";
+  std::ofstream file(temporary_path);
+  file << header << "\n";
+  for (const auto &output_file : files) {
+    file << "file "
+         << fs::absolute(output_file).lexically_relative(directory).string()
+         << "\n";
+  }
+  file.close();
+  std::error_code error;
+  if (file) {
+    fs::rename(temporary_path, path, error);
+  }
+  if (!file || error) {
+    throw runtime_error("Could not write manifest '" + path + "'.");
+  }
+}
+
+vector<string> Read(const string &path) {
+  std::ifstream file(path);
+  if (!file) {
+    throw runtime_error("Could not open manifest '" + path + "'.");
+  }
+
+  string line;
+  if (!std::getline(file, line) || line != header) {
+    throw runtime_error("'" + path + "' is not a nutr output manifest.");
+  }
+
+  const fs::path directory = fs::path(path).parent_path();
+  vector<string> files;
+  while (std::getline(file, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    if (line.compare(0, 5, "file ") != 0) {
+      throw runtime_error("Invalid line '" + line + "' in manifest '" + path +
+                          "'.");
+    }
+    files.push_back((directory / line.substr(5)).string());
+  }
+  return files;
+}
+
+} // namespace manifest
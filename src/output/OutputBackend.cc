@@ -0,0 +1,45 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "OutputBackend.hh"
+
+ColumnPrecision OutputBackend::GetPrecision(const string &column_name) const {
+  for (auto precision = precisions.rbegin(); precision != precisions.rend();
+       ++precision) {
+    const auto &pattern = precision->first;
+    if (pattern == column_name ||
+        (!pattern.empty() && pattern.back() == '*' &&
+         column_name.compare(0, pattern.size() - 1, pattern, 0,
+                             pattern.size() - 1) == 0)) {
+      return precision->second;
+    }
+  }
+  return ColumnPrecision();
+}
+
+int64_t OutputBackend::Quantize(const double value, const double lsb) {
+  const double channel = value / lsb;
+  if (std::isnan(channel)) {
+    return 0;
+  }
+  return std::llround(std::clamp(channel, -max_channel, max_channel));
+}
@@ -0,0 +1,132 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+#include <unistd.h>
+
+using std::runtime_error;
+namespace fs = std::filesystem;
+
+#include "Manifest.hh"
+#include "ResultCache.hh"
+
+namespace {
+
+fs::path Rename(const fs::path &file, const string &from_stem,
+                const fs::path &to_directory, const string &to_stem) {
+  const string name = file.filename().string();
+  if (name.compare(0, from_stem.size(), from_stem) != 0) {
+    throw runtime_error("Output file '" + file.string() +
+                        "' does not start with '" + from_stem + "'.");
+  }
+  return to_directory / (to_stem + name.substr(from_stem.size()));
+}
+
+/**
+ * \brief Copy files to another directory and replace the stem of their names
+ *
+ * The files listed in manifests are renamed in the same way.
+ */
+vector<string> CopyFiles(const vector<string> &files, const string &from_stem,
+                         const fs::path &to_directory, const string &to_stem) {
+  vector<string> copies;
+  for (const auto &file : files) {
+    const fs::path copy = Rename(file, from_stem, to_directory, to_stem);
+    if (fs::path(file).extension() == manifest::extension) {
+      auto listed = manifest::Read(file);
+      for (auto &listed_file : listed) {
+        listed_file =
+            Rename(listed_file, from_stem, to_directory, to_stem).string();
+      }
+      manifest::Write(copy.string(), listed);
+    } else {
+      fs::copy_file(file, copy, fs::copy_options::overwrite_existing);
+    }
+    copies.push_back(copy.string());
+  }
+  return copies;
+}
+
+} // namespace
+
+ResultCache::ResultCache(const string &_directory) : directory(_directory) {}
+
+string ResultCache::GetEntry(const string &hash) const {
+  return (fs::path(directory) / hash).string();
+}
+
+vector<string> ResultCache::Restore(const string &hash,
+                                    const string &output_file_name) const {
+  const fs::path entry = GetEntry(hash);
+  if (!fs::is_directory(entry)) {
+    return {};
+  }
+
+  vector<string> files;
+  for (const auto &file : fs::directory_iterator(entry)) {
+    files.push_back(file.path().string());
+  }
+  std::sort(files.begin(), files.end());
+
+  const fs::path output = fs::absolute(output_file_name);
+  try {
+    fs::create_directories(output.parent_path());
+    return CopyFiles(files, entry_stem, output.parent_path(),
+                     output.stem().string());
+  } catch (const fs::filesystem_error &error) {
+    throw runtime_error("Could not restore cached result '" + entry.string() +
+                        "': " + error.what());
+  }
+}
+
+void ResultCache::Store(const string &hash, const string &output_file_name,
+                        const vector<string> &files) const {
+  const fs::path entry = GetEntry(hash);
+  if (fs::exists(entry)) {
+    return;
+  }
+
+  // Other processes may store the same entry at the same time, so each one
+  // uses its own temporary directory.
+  const fs::path temporary =
+      entry.string() + ".tmp" + std::to_string(getpid());
+  try {
+    fs::remove_all(temporary);
+    fs::create_directories(temporary);
+    CopyFiles(files, fs::path(output_file_name).stem().string(), temporary,
+              entry_stem);
+  } catch (const std::exception &error) {
+    fs::remove_all(temporary);
+    throw runtime_error("Could not store result in cache '" + directory +
+                        "': " + error.what());
+  }
+
+  std::error_code error;
+  fs::rename(temporary, entry, error);
+  if (error) {
+    fs::remove_all(temporary);
+    if (!fs::exists(entry)) {
+      throw runtime_error("Could not store result in cache '" + directory +
+                          "'.");
+    }
+  }
+}
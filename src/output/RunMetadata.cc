@@ -0,0 +1,163 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+using std::runtime_error;
+namespace fs = std::filesystem;
+
+#include "RunMetadata.hh"
+
+namespace {
+
+constexpr uint64_t fnv_offset_basis = 14695981039346656037ull;
+constexpr uint64_t fnv_prime = 1099511628211ull;
+
+uint64_t HashBytes(const std::string_view data, uint64_t hash) {
+  for (const unsigned char byte : data) {
+    hash ^= byte;
+    hash *= fnv_prime;
+  }
+  return hash;
+}
+
+string EscapeJSON(const string &value) {
+  std::ostringstream escaped;
+  escaped << '"';
+  for (const unsigned char character : value) {
+    switch (character) {
+    case '"':
+      escaped << "\\\"";
+      break;
+    case '\\':
+      escaped << "\\\\";
+      break;
+    case '\n':
+      escaped << "\\n";
+      break;
+    case '\t':
+      escaped << "\\t";
+      break;
+    default:
+      if (character < 0x20) {
+        escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                << static_cast<int>(character) << std::dec;
+      } else {
+        escaped << character;
+      }
+    }
+  }
+  escaped << '"';
+  return escaped.str();
+}
+
+} // namespace
+
+uint64_t RunMetadata::Hash(const Configuration &configuration) {
+  // The names and values are terminated by a null character, so that
+  // different splits of the same characters have different hashes.
+  uint64_t hash = fnv_offset_basis;
+  for (const auto &[name, value] : configuration) {
+    hash = HashBytes(name, hash);
+    hash = HashBytes(string(1, '\0'), hash);
+    hash = HashBytes(value, hash);
+    hash = HashBytes(string(1, '\0'), hash);
+  }
+  return hash;
+}
+
+uint64_t RunMetadata::HashFile(const string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw runtime_error("Could not read '" + path + "'.");
+  }
+  uint64_t hash = fnv_offset_basis;
+  string buffer(64 * 1024, '\0');
+  while (file.read(&buffer[0], static_cast<std::streamsize>(buffer.size())) ||
+         file.gcount() > 0) {
+    hash = HashBytes(std::string_view(buffer.data(),
+                                      static_cast<size_t>(file.gcount())),
+                     hash);
+  }
+  return hash;
+}
+
+string RunMetadata::HashToString(const uint64_t hash) {
+  std::ostringstream hex;
+  hex << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return hex.str();
+}
+
+void RunMetadata::SetConfiguration(const Configuration &_configuration) {
+  configuration = _configuration;
+  hash = HashToString(Hash(configuration));
+}
+
+string RunMetadata::MetadataFileName(const string &output_file_name) {
+  return fs::path(output_file_name).replace_extension(extension).string();
+}
+
+void RunMetadata::Write(const string &output_file_name,
+                        const vector<string> &_files,
+                        const string &cache_entry) {
+  const string path = MetadataFileName(output_file_name);
+  const fs::path directory = fs::absolute(path).parent_path();
+
+  const std::time_t now =
+      std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+  std::tm utc;
+  gmtime_r(&now, &utc);
+
+  const string temporary_path = path + ".tmp";
+  std::ofstream file(temporary_path);
+  file << "{\n  \"config_hash\": " << EscapeJSON(hash) << ",\n"
+       << "  \"configuration\": {";
+  for (size_t i = 0; i < configuration.size(); ++i) {
+    file << (i ? ",\n" : "\n") << "    " << EscapeJSON(configuration[i].first)
+         << ": " << EscapeJSON(configuration[i].second);
+  }
+  file << "\n  },\n"
+       << "  \"created\": \"" << std::put_time(&utc, "%FT%TZ") << "\",\n";
+  if (!cache_entry.empty()) {
+    file << "  \"cache_entry\": " << EscapeJSON(cache_entry) << ",\n";
+  }
+  file << "  \"files\": [";
+  for (size_t i = 0; i < _files.size(); ++i) {
+    file << (i ? ",\n" : "\n") << "    "
+         << EscapeJSON(
+                fs::absolute(_files[i]).lexically_relative(directory).string());
+  }
+  file << "\n  ]\n}\n";
+  file.close();
+  std::error_code error;
+  if (file) {
+    fs::rename(temporary_path, path, error);
+  }
+  if (!file || error) {
+    throw runtime_error("Could not write metadata '" + path + "'.");
+  }
+  files = _files;
+}
@@ -0,0 +1,102 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <cstring>
+#include <stdexcept>
+
+using std::runtime_error;
+
+#include "StepFormat.hh"
+#include "StepReader.hh"
+
+StepReader::StepReader(const string &_path)
+    : path(_path), file(_path, std::ios::binary), lsbs{1., 1.} {
+  if (!file) {
+    throw runtime_error("Could not open step-point file '" + path + "'.");
+  }
+  char header[step_format::header_size];
+  if (!file.read(header, sizeof(header))) {
+    throw runtime_error("'" + path + "' is not a step-point file.");
+  }
+  track_format::BlockReader reader(header, header + sizeof(header));
+  char magic[sizeof(step_format::magic)];
+  for (auto &byte : magic) {
+    byte = reader.Get<char>();
+  }
+  if (std::memcmp(magic, step_format::magic, sizeof(magic)) != 0) {
+    throw runtime_error("'" + path + "' is not a step-point file.");
+  }
+  const auto version = reader.Get<uint64_t>();
+  if (version != step_format::format_version) {
+    throw runtime_error("Step-point file '" + path +
+                        "' has unsupported version " +
+                        std::to_string(version) + ".");
+  }
+  for (auto &lsb : lsbs) {
+    lsb = reader.Get<double>();
+  }
+}
+
+uint32_t StepReader::NextBlockSize() {
+  uint32_t block_size = 0;
+  if (!file.read(reinterpret_cast<char *>(&block_size), sizeof(block_size))) {
+    return 0;
+  }
+  return block_size;
+}
+
+bool StepReader::Skip() {
+  const uint32_t block_size = NextBlockSize();
+  if (block_size == 0) {
+    return false;
+  }
+  if (!file.seekg(block_size, std::ios::cur)) {
+    throw runtime_error("Step-point file '" + path + "' ends within a block.");
+  }
+  return true;
+}
+
+bool StepReader::Next(Event &event) {
+  const uint32_t block_size = NextBlockSize();
+  if (block_size == 0) {
+    return false;
+  }
+  block.resize(block_size);
+  if (!file.read(&block[0], block_size)) {
+    throw runtime_error("Step-point file '" + path + "' ends within a block.");
+  }
+
+  track_format::BlockReader reader(block.data(), block.data() + block.size());
+  event.event_id = reader.Get<int64_t>();
+  event.run_id = reader.Get<int32_t>();
+  double time = reader.Get<double>();
+  event.points.resize(reader.GetVarint());
+  for (auto &point : event.points) {
+    point.detector_id = static_cast<uint32_t>(reader.GetVarint());
+    for (auto &coordinate : point.position) {
+      coordinate =
+          static_cast<double>(track_format::UnZigZag(reader.GetVarint())) *
+          lsbs[0];
+    }
+    point.depth = static_cast<double>(reader.GetVarint()) * lsbs[0];
+    point.edep = static_cast<double>(reader.Get<float>());
+    point.time = reader.GetTime(time, lsbs[1]);
+  }
+  return true;
+}
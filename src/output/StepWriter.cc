@@ -0,0 +1,108 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+
+#include "OutputBackend.hh"
+#include "StepFormat.hh"
+#include "StepWriter.hh"
+
+StepWriter::~StepWriter() {
+  if (file != nullptr) {
+    TrackFileWriter::Release(file);
+  }
+}
+
+void StepWriter::Open(const string &path, const double _position_lsb,
+                      const double _time_lsb) {
+  if (file != nullptr) {
+    Close();
+  }
+  position_lsb = _position_lsb;
+  time_lsb = _time_lsb;
+  points.clear();
+  batch.clear();
+
+  file = TrackFileWriter::Acquire(path);
+  string header(step_format::magic, sizeof(step_format::magic));
+  track_format::Put(header, step_format::format_version);
+  track_format::Put(header, position_lsb);
+  track_format::Put(header, time_lsb);
+  try {
+    file->SetHeader(header);
+  } catch (...) {
+    TrackFileWriter::Release(file);
+    file = nullptr;
+    throw;
+  }
+}
+
+void StepWriter::FinishEvent(const int64_t event_id, const int32_t run_id) {
+  if (points.empty()) {
+    return;
+  }
+
+  // The size of the block is filled in after it has been encoded.
+  const size_t block_start = batch.size();
+  track_format::Put(batch, uint32_t(0));
+  track_format::Put(batch, event_id);
+  track_format::Put(batch, run_id);
+  double previous_time = points.front().time;
+  track_format::Put(batch, previous_time);
+  track_format::PutVarint(batch, points.size());
+  for (const auto &point : points) {
+    track_format::PutVarint(batch, point.detector_id);
+    for (const auto coordinate : point.position) {
+      track_format::PutVarint(
+          batch, track_format::ZigZag(
+                     OutputBackend::Quantize(coordinate, position_lsb)));
+    }
+    track_format::PutVarint(
+        batch, static_cast<uint64_t>(std::max(
+                   OutputBackend::Quantize(point.depth, position_lsb),
+                   int64_t(0))));
+    track_format::Put(batch, point.edep);
+    track_format::PutTime(batch, point.time, previous_time, time_lsb);
+  }
+  points.clear();
+
+  const auto block_size =
+      static_cast<uint32_t>(batch.size() - block_start - sizeof(uint32_t));
+  std::copy_n(reinterpret_cast<const char *>(&block_size), sizeof(block_size),
+              batch.begin() + static_cast<ptrdiff_t>(block_start));
+
+  if (batch.size() >= batch_bytes) {
+    file->WriteBlocks(batch);
+    batch.clear();
+  }
+}
+
+void StepWriter::Close() {
+  if (file == nullptr) {
+    return;
+  }
+  points.clear();
+  if (!batch.empty()) {
+    file->WriteBlocks(batch);
+    batch.clear();
+  }
+  auto *released = file;
+  file = nullptr;
+  TrackFileWriter::Release(released);
+}
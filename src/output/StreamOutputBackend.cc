@@ -0,0 +1,205 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <stdexcept>
+
+using std::runtime_error;
+
+#include "StreamFormat.hh"
+#include "StreamOutputBackend.hh"
+
+namespace {
+
+template <typename T> void Append(string &data, const T value) {
+  data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+} // namespace
+
+StreamOutputBackend::~StreamOutputBackend() {
+  if (stream != nullptr) {
+    StreamWriter::Release(stream);
+  }
+}
+
+void StreamOutputBackend::OpenFile(const string &_file_name) {
+  if (stream != nullptr) {
+    CloseFile();
+  }
+  file_name = _file_name;
+  stream = StreamWriter::Acquire(file_name);
+  tables.clear();
+  batch.clear();
+}
+
+int StreamOutputBackend::CreateNtuple(const string &name,
+                                      const string &title) {
+  tables.push_back(Table{{name, title, {}}, 0, {}, {}, 0, {}});
+  return static_cast<int>(tables.size() - 1);
+}
+
+int StreamOutputBackend::CreateNtupleIColumn(const string &name) {
+  return CreateColumn({name, columnar::ColumnType::int32});
+}
+
+int StreamOutputBackend::CreateNtupleLColumn(const string &name) {
+  return CreateColumn({name, columnar::ColumnType::int64});
+}
+
+int StreamOutputBackend::CreateNtupleDColumn(
+    const string &name, const ColumnPrecision precision) {
+  switch (precision.type) {
+  case ColumnPrecision::float32:
+    return CreateColumn({name, columnar::ColumnType::float32});
+  case ColumnPrecision::quantized:
+    return CreateColumn({name, columnar::ColumnType::quantized, precision.lsb});
+  default:
+    return CreateColumn({name, columnar::ColumnType::float64});
+  }
+}
+
+int StreamOutputBackend::CreateColumn(const columnar::ColumnSchema &schema) {
+  if (tables.empty()) {
+    throw runtime_error("Column '" + schema.name +
+                        "' created before any ntuple in output stream '" +
+                        file_name + "'.");
+  }
+  auto &table = tables.back();
+  table.schema.columns.push_back(schema);
+  table.integers.push_back(0);
+  table.floating_points.push_back(0.);
+  return static_cast<int>(table.schema.columns.size() - 1);
+}
+
+void StreamOutputBackend::FinishNtuple() {
+  if (tables.empty() || stream == nullptr) {
+    return;
+  }
+  tables.back().id = stream->DefineTable(tables.back().schema);
+}
+
+bool StreamOutputBackend::CheckColumn(const int ntuple, const int column,
+                                      const bool floating_point) const {
+  if (ntuple < 0 || static_cast<size_t>(ntuple) >= tables.size()) {
+    return false;
+  }
+  const auto &columns = tables[ntuple].schema.columns;
+  return column >= 0 && static_cast<size_t>(column) < columns.size() &&
+         columnar::IsIntegerType(columns[column].type) != floating_point;
+}
+
+bool StreamOutputBackend::FillNtupleIColumn(const int ntuple,
+                                            const int column,
+                                            const int value) {
+  if (!CheckColumn(ntuple, column, false)) {
+    return false;
+  }
+  tables[ntuple].integers[column] = value;
+  return true;
+}
+
+bool StreamOutputBackend::FillNtupleLColumn(const int ntuple,
+                                            const int column,
+                                            const int64_t value) {
+  if (!CheckColumn(ntuple, column, false)) {
+    return false;
+  }
+  tables[ntuple].integers[column] = value;
+  return true;
+}
+
+bool StreamOutputBackend::FillNtupleDColumn(const int ntuple,
+                                            const int column,
+                                            const double value) {
+  if (!CheckColumn(ntuple, column, true)) {
+    return false;
+  }
+  tables[ntuple].floating_points[column] = value;
+  return true;
+}
+
+bool StreamOutputBackend::AddNtupleRow(const int ntuple) {
+  if (ntuple < 0 || static_cast<size_t>(ntuple) >= tables.size()) {
+    return false;
+  }
+  auto &table = tables[ntuple];
+  for (size_t i = 0; i < table.schema.columns.size(); ++i) {
+    switch (table.schema.columns[i].type) {
+    case columnar::ColumnType::int32:
+      Append(table.rows, static_cast<int32_t>(table.integers[i]));
+      break;
+    case columnar::ColumnType::int64:
+      Append(table.rows, table.integers[i]);
+      break;
+    case columnar::ColumnType::float64:
+      Append(table.rows, table.floating_points[i]);
+      break;
+    case columnar::ColumnType::float32:
+      Append(table.rows, static_cast<float>(table.floating_points[i]));
+      break;
+    case columnar::ColumnType::quantized:
+      Append(table.rows, Quantize(table.floating_points[i],
+                                  table.schema.columns[i].scale));
+      break;
+    }
+  }
+  ++table.n_rows;
+  return true;
+}
+
+void StreamOutputBackend::FinishRecords() {
+  for (auto &table : tables) {
+    if (table.n_rows == 0) {
+      continue;
+    }
+    Append(batch, static_cast<uint32_t>(stream::record_header_size -
+                                        sizeof(uint32_t) + table.rows.size()));
+    Append(batch, table.id);
+    Append(batch, table.n_rows);
+    batch += table.rows;
+    table.rows.clear();
+    table.n_rows = 0;
+  }
+}
+
+void StreamOutputBackend::NewEvent() {
+  FinishRecords();
+  if (batch.size() >= batch_bytes && stream != nullptr) {
+    stream->Submit(std::move(batch));
+    batch.clear();
+  }
+}
+
+void StreamOutputBackend::Write() {
+  FinishRecords();
+  if (!batch.empty() && stream != nullptr) {
+    stream->Submit(std::move(batch));
+    batch.clear();
+  }
+}
+
+void StreamOutputBackend::CloseFile() {
+  if (stream == nullptr) {
+    return;
+  }
+  Write();
+  auto *released = stream;
+  stream = nullptr;
+  StreamWriter::Release(released);
+}
@@ -0,0 +1,164 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+using std::runtime_error;
+
+#include <unistd.h>
+
+#include "StreamFormat.hh"
+#include "StreamReader.hh"
+
+StreamReader::StreamReader(const int _file_descriptor)
+    : file_descriptor(_file_descriptor), buffer(64 * 1024), buffer_begin(0),
+      buffer_end(0) {}
+
+bool StreamReader::Read(char *data, const size_t size) {
+  size_t n_read = 0;
+  while (n_read < size) {
+    if (buffer_begin == buffer_end) {
+      const ssize_t n = read(file_descriptor, buffer.data(), buffer.size());
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0) {
+        throw runtime_error("Could not read from the stream: " +
+                            string(std::strerror(errno)));
+      }
+      if (n == 0) {
+        if (n_read == 0) {
+          return false;
+        }
+        throw runtime_error("The stream ended in the middle of a record.");
+      }
+      buffer_begin = 0;
+      buffer_end = static_cast<size_t>(n);
+    }
+    const size_t n_copy = std::min(size - n_read, buffer_end - buffer_begin);
+    std::memcpy(data + n_read, buffer.data() + buffer_begin, n_copy);
+    buffer_begin += n_copy;
+    n_read += n_copy;
+  }
+  return true;
+}
+
+uint32_t StreamReader::ReadUInt32() {
+  uint32_t value;
+  if (!Read(reinterpret_cast<char *>(&value), sizeof(value))) {
+    throw runtime_error("The stream ended in the middle of a run.");
+  }
+  return value;
+}
+
+bool StreamReader::NextRun() {
+  char magic[sizeof(stream::magic)];
+  if (!Read(magic, sizeof(magic))) {
+    return false;
+  }
+  if (std::memcmp(magic, stream::magic, sizeof(magic)) != 0) {
+    throw runtime_error("The data is not a nutr output stream.");
+  }
+  string schema(ReadUInt32(), '\0');
+  if (!Read(schema.data(), schema.size()) && !schema.empty()) {
+    throw runtime_error("The stream ended in the middle of a header.");
+  }
+  tables = columnar::ParseFooter(
+               reinterpret_cast<const uint8_t *>(schema.data()), schema.size())
+               .tables;
+
+  row_sizes.clear();
+  column_offsets.clear();
+  for (const auto &table : tables) {
+    vector<size_t> offsets;
+    size_t offset = 0;
+    for (const auto &column : table.columns) {
+      offsets.push_back(offset);
+      offset += columnar::ColumnTypeSize(column.type);
+    }
+    row_sizes.push_back(offset);
+    column_offsets.push_back(offsets);
+  }
+  return true;
+}
+
+bool StreamReader::NextRecord(Record &record) {
+  const uint32_t size = ReadUInt32();
+  if (size == 0) {
+    return false;
+  }
+  if (size < stream::record_header_size - sizeof(uint32_t)) {
+    throw runtime_error("Invalid record in the stream.");
+  }
+  record.table = ReadUInt32();
+  record.n_rows = ReadUInt32();
+  record.rows.resize(size - (stream::record_header_size - sizeof(uint32_t)));
+  if (record.table >= tables.size() ||
+      record.rows.size() !=
+          static_cast<size_t>(record.n_rows) * row_sizes[record.table] ||
+      (!record.rows.empty() && !Read(record.rows.data(), record.rows.size()))) {
+    throw runtime_error("Invalid record in the stream.");
+  }
+  return true;
+}
+
+double StreamReader::GetValue(const Record &record, const size_t row,
+                              const size_t column) const {
+  const auto &schema = tables[record.table].columns[column];
+  const char *value = record.rows.data() + row * row_sizes[record.table] +
+                      column_offsets[record.table][column];
+  switch (schema.type) {
+  case columnar::ColumnType::int32:
+  case columnar::ColumnType::int64:
+    return static_cast<double>(GetInteger(record, row, column));
+  case columnar::ColumnType::float32: {
+    float floating_point;
+    std::memcpy(&floating_point, value, sizeof(floating_point));
+    return floating_point;
+  }
+  case columnar::ColumnType::quantized: {
+    int64_t channel;
+    std::memcpy(&channel, value, sizeof(channel));
+    return static_cast<double>(channel) * schema.scale;
+  }
+  default: {
+    double floating_point;
+    std::memcpy(&floating_point, value, sizeof(floating_point));
+    return floating_point;
+  }
+  }
+}
+
+int64_t StreamReader::GetInteger(const Record &record, const size_t row,
+                                 const size_t column) const {
+  const char *value = record.rows.data() + row * row_sizes[record.table] +
+                      column_offsets[record.table][column];
+  if (tables[record.table].columns[column].type ==
+      columnar::ColumnType::int32) {
+    int32_t integer;
+    std::memcpy(&integer, value, sizeof(integer));
+    return integer;
+  }
+  int64_t integer;
+  std::memcpy(&integer, value, sizeof(integer));
+  return integer;
+}
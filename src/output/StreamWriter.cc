@@ -0,0 +1,269 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+
+using std::lock_guard;
+using std::runtime_error;
+using std::unique_lock;
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "StreamFormat.hh"
+#include "StreamWriter.hh"
+
+mutex StreamWriter::registry_mutex;
+map<string, std::pair<unique_ptr<StreamWriter>, unsigned int>>
+    StreamWriter::registry;
+int StreamWriter::standard_output = -1;
+
+namespace {
+
+constexpr char unix_socket_prefix[] = "unix:";
+
+void AppendUInt32(string &data, const uint32_t value) {
+  data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+} // namespace
+
+StreamWriter *StreamWriter::Acquire(const string &destination) {
+  lock_guard<mutex> lock(registry_mutex);
+
+  auto &entry = registry[destination];
+  if (entry.first == nullptr) {
+    try {
+      entry.first.reset(new StreamWriter(destination));
+    } catch (...) {
+      registry.erase(destination);
+      throw;
+    }
+  }
+  ++entry.second;
+  return entry.first.get();
+}
+
+void StreamWriter::Release(StreamWriter *stream) {
+  unique_ptr<StreamWriter> last_user;
+  {
+    lock_guard<mutex> lock(registry_mutex);
+    auto entry = registry.find(stream->GetDestination());
+    if (entry == registry.end() || entry->second.first.get() != stream ||
+        --entry->second.second > 0) {
+      return;
+    }
+    last_user = std::move(entry->second.first);
+    registry.erase(entry);
+  }
+
+  {
+    lock_guard<mutex> lock(last_user->queue_mutex);
+    if (!last_user->header_queued) {
+      last_user->QueueHeader();
+    }
+    string end_of_run;
+    AppendUInt32(end_of_run, 0);
+    last_user->queue.push_back(std::move(end_of_run));
+    last_user->closing = true;
+  }
+  last_user->queue_changed.notify_all();
+  last_user->thread.join();
+  if (!last_user->error.empty()) {
+    throw runtime_error(last_user->error);
+  }
+}
+
+bool StreamWriter::IsStream(const string &destination) {
+  struct stat status;
+  return destination == "-" || destination.rfind(unix_socket_prefix, 0) == 0 ||
+         (stat(destination.c_str(), &status) == 0 && S_ISFIFO(status.st_mode));
+}
+
+void StreamWriter::ReserveStandardOutput() {
+  static std::once_flag reserved;
+  std::call_once(reserved, []() {
+    std::cout.flush();
+    std::fflush(stdout);
+    standard_output = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0);
+    if (standard_output < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+      throw runtime_error("Could not reserve the standard output: " +
+                          string(std::strerror(errno)));
+    }
+  });
+}
+
+StreamWriter::StreamWriter(const string &_destination)
+    : destination(_destination), file_descriptor(-1),
+      owns_file_descriptor(true), header_queued(false), closing(false) {
+  if (destination == "-") {
+    ReserveStandardOutput();
+    file_descriptor = standard_output;
+    owns_file_descriptor = false;
+  } else if (destination.rfind(unix_socket_prefix, 0) == 0) {
+    const string socket_path =
+        destination.substr(sizeof(unix_socket_prefix) - 1);
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+      throw runtime_error("Socket path '" + socket_path + "' is too long.");
+    }
+    std::strncpy(address.sun_path, socket_path.c_str(),
+                 sizeof(address.sun_path) - 1);
+    file_descriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (file_descriptor < 0 ||
+        connect(file_descriptor, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) < 0) {
+      const string reason = std::strerror(errno);
+      if (file_descriptor >= 0) {
+        close(file_descriptor);
+      }
+      throw runtime_error("Could not connect to the consumer on '" +
+                          socket_path + "': " + reason);
+    }
+  } else {
+    // Blocks until a consumer opens the named pipe for reading.
+    file_descriptor = open(destination.c_str(), O_WRONLY | O_CLOEXEC);
+    if (file_descriptor < 0) {
+      throw runtime_error("Could not open output stream '" + destination +
+                          "': " + std::strerror(errno));
+    }
+  }
+
+  thread = std::thread(&StreamWriter::Run, this);
+}
+
+StreamWriter::~StreamWriter() {
+  if (thread.joinable()) {
+    {
+      lock_guard<mutex> lock(queue_mutex);
+      closing = true;
+    }
+    queue_changed.notify_all();
+    thread.join();
+  }
+  if (owns_file_descriptor && file_descriptor >= 0) {
+    close(file_descriptor);
+  }
+}
+
+uint32_t StreamWriter::DefineTable(const columnar::TableSchema &schema) {
+  lock_guard<mutex> lock(queue_mutex);
+
+  for (uint32_t i = 0; i < tables.size(); ++i) {
+    if (tables[i].name == schema.name) {
+      if (!(tables[i] == schema)) {
+        throw runtime_error("Table '" + schema.name + "' in output stream '" +
+                            destination +
+                            "' was defined with different columns by "
+                            "different threads.");
+      }
+      return i;
+    }
+  }
+  if (header_queued) {
+    throw runtime_error("Table '" + schema.name + "' in output stream '" +
+                        destination + "' was defined after the first event.");
+  }
+  tables.push_back(schema);
+  return static_cast<uint32_t>(tables.size() - 1);
+}
+
+void StreamWriter::Submit(string &&records) {
+  unique_lock<mutex> lock(queue_mutex);
+  if (!header_queued) {
+    QueueHeader();
+  }
+  // Backpressure: wait for the consumer instead of buffering without limit.
+  queue_changed.wait(lock, [this]() {
+    return queue.size() < max_queued_batches || !error.empty();
+  });
+  if (!error.empty()) {
+    throw runtime_error(error);
+  }
+  queue.push_back(std::move(records));
+  lock.unlock();
+  queue_changed.notify_all();
+}
+
+void StreamWriter::QueueHeader() {
+  const string schema = columnar::SerializeFooter({tables, {}});
+  string header(stream::magic, sizeof(stream::magic));
+  AppendUInt32(header, static_cast<uint32_t>(schema.size()));
+  header += schema;
+  queue.push_back(std::move(header));
+  header_queued = true;
+}
+
+void StreamWriter::Run() {
+  // A consumer that goes away must not terminate the simulation with
+  // SIGPIPE. With the signal blocked in this thread, write() fails with
+  // EPIPE instead, which is reported to the threads that submit records.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  unique_lock<mutex> lock(queue_mutex);
+  while (true) {
+    queue_changed.wait(lock, [this]() { return !queue.empty() || closing; });
+    if (queue.empty()) {
+      return;
+    }
+    const string data = std::move(queue.front());
+    queue.pop_front();
+    lock.unlock();
+    queue_changed.notify_all();
+
+    size_t n_written = 0;
+    string write_error;
+    while (n_written < data.size()) {
+      const ssize_t n = write(file_descriptor, data.data() + n_written,
+                              data.size() - n_written);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        write_error = "Could not write to output stream '" + destination +
+                      "': " + std::strerror(errno);
+        break;
+      }
+      n_written += static_cast<size_t>(n);
+    }
+
+    lock.lock();
+    if (!write_error.empty()) {
+      error = write_error;
+      queue.clear();
+      queue_changed.notify_all();
+      return;
+    }
+  }
+}
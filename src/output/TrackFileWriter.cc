@@ -0,0 +1,134 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+using std::lock_guard;
+using std::runtime_error;
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "TrackFileWriter.hh"
+#include "TrackFormat.hh"
+
+mutex TrackFileWriter::registry_mutex;
+map<string, std::pair<unique_ptr<TrackFileWriter>, unsigned int>>
+    TrackFileWriter::registry;
+
+TrackFileWriter *TrackFileWriter::Acquire(const string &path) {
+  lock_guard<mutex> lock(registry_mutex);
+
+  auto &entry = registry[path];
+  if (entry.first == nullptr) {
+    entry.first.reset(new TrackFileWriter(path));
+  }
+  ++entry.second;
+  return entry.first.get();
+}
+
+void TrackFileWriter::Release(TrackFileWriter *file) {
+  lock_guard<mutex> lock(registry_mutex);
+
+  auto entry = registry.find(file->GetPath());
+  if (entry != registry.end() && entry->second.first.get() == file &&
+      --entry->second.second == 0) {
+    registry.erase(entry);
+  }
+}
+
+TrackFileWriter::TrackFileWriter(const string &_path)
+    : path(_path), file_descriptor(-1), end_of_data(0), has_header(false) {
+  file_descriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (file_descriptor < 0) {
+    throw runtime_error("Could not create output file '" + path +
+                        "': " + std::strerror(errno));
+  }
+}
+
+TrackFileWriter::~TrackFileWriter() {
+  if (file_descriptor < 0) {
+    return;
+  }
+  // The terminating empty block is only a marker for readers, so errors are
+  // ignored.
+  if (has_header) {
+    string end_of_file;
+    track_format::Put(end_of_file, uint32_t(0));
+    try {
+      WriteAt(end_of_file.data(), end_of_file.size(), end_of_data);
+    } catch (...) {
+    }
+  }
+  close(file_descriptor);
+}
+
+void TrackFileWriter::SetQuantization(const double time_lsb,
+                                      const double edep_lsb,
+                                      const double ekin_lsb) {
+  string track_header(track_format::magic, sizeof(track_format::magic));
+  track_format::Put(track_header, track_format::format_version);
+  for (const auto lsb : {time_lsb, edep_lsb, ekin_lsb}) {
+    track_format::Put(track_header, lsb);
+  }
+  SetHeader(track_header);
+}
+
+void TrackFileWriter::SetHeader(const string &_header) {
+  lock_guard<mutex> lock(header_mutex);
+
+  if (has_header) {
+    if (_header != header) {
+      throw runtime_error("Threads use different precisions for file '" +
+                          path + "'.");
+    }
+    return;
+  }
+
+  header = _header;
+  WriteAt(header.data(), header.size(), 0);
+  // Blocks are only written after the header has been set.
+  end_of_data = header.size();
+  has_header = true;
+}
+
+void TrackFileWriter::WriteBlocks(const string &blocks) {
+  WriteAt(blocks.data(), blocks.size(), end_of_data.fetch_add(blocks.size()));
+}
+
+void TrackFileWriter::WriteAt(const char *data, size_t size,
+                              uint64_t offset) {
+  while (size > 0) {
+    const ssize_t written =
+        pwrite(file_descriptor, data, size, static_cast<off_t>(offset));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw runtime_error("Could not write to output file '" + path +
+                          "': " + std::strerror(errno));
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+    offset += static_cast<uint64_t>(written);
+  }
+}
@@ -0,0 +1,252 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+using std::runtime_error;
+
+#include "TrackFormat.hh"
+#include "TrackOutputBackend.hh"
+
+namespace {
+
+bool IsIntegerField(const TrackOutputBackend::Field field) {
+  return field <= TrackOutputBackend::deid;
+}
+
+} // namespace
+
+TrackOutputBackend::~TrackOutputBackend() {
+  if (file != nullptr) {
+    TrackFileWriter::Release(file);
+  }
+}
+
+void TrackOutputBackend::OpenFile(const string &_file_name) {
+  if (file != nullptr) {
+    CloseFile();
+  }
+  file_name = _file_name;
+  file = TrackFileWriter::Acquire(file_name);
+  n_ntuples = 0;
+  fields.clear();
+  lsbs[0] = track_format::default_time_lsb;
+  lsbs[1] = track_format::default_energy_lsb;
+  lsbs[2] = track_format::default_energy_lsb;
+  std::fill(std::begin(integers), std::end(integers), 0);
+  std::fill(std::begin(floating_points), std::end(floating_points), 0.);
+  event_id = 0;
+  run_id = 0;
+  steps.clear();
+  batch.clear();
+}
+
+int TrackOutputBackend::CreateNtuple(const string &name, const string &) {
+  if (n_ntuples > 0) {
+    throw runtime_error("Track file '" + file_name +
+                        "' cannot store the additional ntuple '" + name +
+                        "'.");
+  }
+  return static_cast<int>(n_ntuples++);
+}
+
+int TrackOutputBackend::CreateNtupleIColumn(const string &name) {
+  return CreateColumn(name, true, ColumnPrecision());
+}
+
+int TrackOutputBackend::CreateNtupleLColumn(const string &name) {
+  return CreateColumn(name, true, ColumnPrecision());
+}
+
+int TrackOutputBackend::CreateNtupleDColumn(const string &name,
+                                            const ColumnPrecision precision) {
+  return CreateColumn(name, false, precision);
+}
+
+int TrackOutputBackend::CreateColumn(const string &name, const bool integer,
+                                     const ColumnPrecision precision) {
+  const auto field_name =
+      std::find(std::begin(field_names), std::end(field_names), name);
+  const auto field =
+      static_cast<Field>(std::distance(std::begin(field_names), field_name));
+  if (field == n_fields || IsIntegerField(field) != integer) {
+    throw runtime_error("Column '" + name +
+                        "' cannot be stored in track file '" + file_name +
+                        "', which only supports the tracker sensitive "
+                        "detector without TRACK_PRIMARY.");
+  }
+  if (precision.type == ColumnPrecision::quantized && field >= time &&
+      field <= ekin) {
+    lsbs[field - time] = precision.lsb;
+  }
+  fields.push_back(field);
+  return static_cast<int>(fields.size() - 1);
+}
+
+void TrackOutputBackend::FinishNtuple() {
+  for (int field = 0; field < n_fields; ++field) {
+    if (std::find(fields.begin(), fields.end(), field) == fields.end()) {
+      throw runtime_error("Track file '" + file_name +
+                          "' requires the column '" + field_names[field] +
+                          "' of the tracker sensitive detector.");
+    }
+  }
+  file->SetQuantization(lsbs[0], lsbs[1], lsbs[2]);
+}
+
+bool TrackOutputBackend::CheckColumn(const int ntuple, const int column,
+                                     const bool integer) const {
+  return ntuple == 0 && column >= 0 &&
+         static_cast<size_t>(column) < fields.size() &&
+         IsIntegerField(fields[column]) == integer;
+}
+
+bool TrackOutputBackend::FillNtupleIColumn(const int ntuple, const int column,
+                                           const int value) {
+  if (!CheckColumn(ntuple, column, true)) {
+    return false;
+  }
+  integers[fields[column]] = value;
+  return true;
+}
+
+bool TrackOutputBackend::FillNtupleLColumn(const int ntuple, const int column,
+                                           const int64_t value) {
+  if (!CheckColumn(ntuple, column, true)) {
+    return false;
+  }
+  integers[fields[column]] = value;
+  return true;
+}
+
+bool TrackOutputBackend::FillNtupleDColumn(const int ntuple, const int column,
+                                           const double value) {
+  if (!CheckColumn(ntuple, column, false)) {
+    return false;
+  }
+  floating_points[fields[column]] = value;
+  return true;
+}
+
+bool TrackOutputBackend::AddNtupleRow(const int ntuple) {
+  if (ntuple != 0 || file == nullptr) {
+    return false;
+  }
+  if (!steps.empty() && integers[evid] != event_id) {
+    FinishEvent();
+  }
+  event_id = integers[evid];
+  run_id = static_cast<int32_t>(integers[runid]);
+  steps.push_back(Step{static_cast<int32_t>(integers[trid]),
+                       static_cast<int32_t>(integers[paid]),
+                       static_cast<int32_t>(integers[deid]),
+                       floating_points[time],
+                       floating_points[edep],
+                       floating_points[ekin],
+                       {floating_points[posx], floating_points[posy],
+                        floating_points[posz]},
+                       {floating_points[momx], floating_points[momy],
+                        floating_points[momz]}});
+  return true;
+}
+
+void TrackOutputBackend::FinishEvent() {
+  if (steps.empty()) {
+    return;
+  }
+
+  // The size of the block is filled in after it has been encoded.
+  const size_t block_start = batch.size();
+  track_format::Put(batch, uint32_t(0));
+  track_format::Put(batch, event_id);
+  track_format::Put(batch, run_id);
+  const double t0 = steps.front().time;
+  track_format::Put(batch, t0);
+
+  // Tracks are numbered in the order of their first step.
+  track_indices.clear();
+  tracks.clear();
+  string dictionary;
+  for (const auto &step : steps) {
+    if (track_indices.emplace(step.track_id, tracks.size()).second) {
+      tracks.push_back(Track{t0, {0., 0., 0.}});
+      track_format::PutVarint(dictionary,
+                              static_cast<uint32_t>(step.track_id));
+      track_format::PutVarint(dictionary, track_format::ZigZag(step.pdg));
+    }
+  }
+  track_format::PutVarint(batch, tracks.size());
+  batch += dictionary;
+
+  track_format::PutVarint(batch, steps.size());
+  for (const auto &step : steps) {
+    const uint32_t index = track_indices[step.track_id];
+    auto &track = tracks[index];
+    track_format::PutVarint(batch, index);
+    track_format::PutVarint(batch, track_format::ZigZag(step.detector_id));
+    track_format::PutTime(batch, step.time, track.time, lsbs[0]);
+    track_format::PutVarint(
+        batch, track_format::ZigZag(Quantize(step.edep, lsbs[1])));
+    track_format::PutVarint(
+        batch, track_format::ZigZag(Quantize(step.ekin, lsbs[2])));
+    for (size_t i = 0; i < 3; ++i) {
+      const auto delta =
+          static_cast<float>(step.position[i] - track.position[i]);
+      track_format::Put(batch, delta);
+      track.position[i] += static_cast<double>(delta);
+    }
+    for (const auto momentum : step.momentum) {
+      track_format::Put(batch, static_cast<float>(momentum));
+    }
+  }
+  steps.clear();
+
+  const auto block_size =
+      static_cast<uint32_t>(batch.size() - block_start - sizeof(uint32_t));
+  std::copy_n(reinterpret_cast<const char *>(&block_size), sizeof(block_size),
+              batch.begin() + static_cast<ptrdiff_t>(block_start));
+}
+
+void TrackOutputBackend::NewEvent() {
+  FinishEvent();
+  if (batch.size() >= batch_bytes && file != nullptr) {
+    file->WriteBlocks(batch);
+    batch.clear();
+  }
+}
+
+void TrackOutputBackend::Write() {
+  FinishEvent();
+  if (!batch.empty() && file != nullptr) {
+    file->WriteBlocks(batch);
+    batch.clear();
+  }
+}
+
+void TrackOutputBackend::CloseFile() {
+  if (file == nullptr) {
+    return;
+  }
+  Write();
+  auto *released = file;
+  file = nullptr;
+  TrackFileWriter::Release(released);
+}
@@ -0,0 +1,114 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <cstring>
+#include <stdexcept>
+
+using std::runtime_error;
+
+#include "TrackFormat.hh"
+#include "TrackReader.hh"
+
+TrackReader::TrackReader(const string &_path)
+    : path(_path), file(_path, std::ios::binary), lsbs{1., 1., 1.} {
+  if (!file) {
+    throw runtime_error("Could not open track file '" + path + "'.");
+  }
+  char header[track_format::header_size];
+  if (!file.read(header, sizeof(header))) {
+    throw runtime_error("'" + path + "' is not a track file.");
+  }
+  track_format::BlockReader reader(header, header + sizeof(header));
+  char magic[sizeof(track_format::magic)];
+  for (auto &byte : magic) {
+    byte = reader.Get<char>();
+  }
+  if (std::memcmp(magic, track_format::magic, sizeof(magic)) != 0) {
+    throw runtime_error("'" + path + "' is not a track file.");
+  }
+  const auto version = reader.Get<uint64_t>();
+  if (version != track_format::format_version) {
+    throw runtime_error("Track file '" + path + "' has unsupported version " +
+                        std::to_string(version) + ".");
+  }
+  for (auto &lsb : lsbs) {
+    lsb = reader.Get<double>();
+  }
+}
+
+bool TrackReader::Next(Event &event) {
+  uint32_t block_size = 0;
+  if (!file.read(reinterpret_cast<char *>(&block_size), sizeof(block_size)) ||
+      block_size == 0) {
+    return false;
+  }
+  block.resize(block_size);
+  if (!file.read(&block[0], block_size)) {
+    throw runtime_error("Track file '" + path + "' ends within a block.");
+  }
+
+  track_format::BlockReader reader(block.data(), block.data() + block.size());
+  event.event_id = reader.Get<int64_t>();
+  event.run_id = reader.Get<int32_t>();
+  const auto t0 = reader.Get<double>();
+
+  struct Track {
+    int32_t track_id;
+    int32_t pdg;
+    double time;
+    double position[3];
+  };
+  vector<Track> tracks(reader.GetVarint());
+  for (auto &track : tracks) {
+    track.track_id = static_cast<int32_t>(reader.GetVarint());
+    track.pdg =
+        static_cast<int32_t>(track_format::UnZigZag(reader.GetVarint()));
+    track.time = t0;
+    track.position[0] = track.position[1] = track.position[2] = 0.;
+  }
+
+  event.steps.resize(reader.GetVarint());
+  for (auto &step : event.steps) {
+    const auto index = reader.GetVarint();
+    if (index >= tracks.size()) {
+      throw runtime_error("Invalid track in block of track file '" + path +
+                          "'.");
+    }
+    auto &track = tracks[index];
+    step.track_id = track.track_id;
+    step.pdg = track.pdg;
+    step.detector_id =
+        static_cast<int32_t>(track_format::UnZigZag(reader.GetVarint()));
+    step.time = reader.GetTime(track.time, lsbs[0]);
+    step.edep =
+        static_cast<double>(track_format::UnZigZag(reader.GetVarint())) *
+        lsbs[1];
+    step.ekin =
+        static_cast<double>(track_format::UnZigZag(reader.GetVarint())) *
+        lsbs[2];
+    for (size_t i = 0; i < 3; ++i) {
+      track.position[i] += static_cast<double>(reader.Get<float>());
+      step.position[i] = track.position[i];
+    }
+    for (auto &momentum : step.momentum) {
+      momentum = static_cast<double>(reader.Get<float>());
+    }
+  }
+  return true;
+}
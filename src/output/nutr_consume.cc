@@ -0,0 +1,183 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::runtime_error;
+using std::string;
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+#include "StreamReader.hh"
+
+namespace {
+
+/**
+ * \brief Listen on a Unix domain socket and accept a single producer
+ */
+int AcceptProducer(const string &socket_path) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    throw runtime_error("Socket path '" + socket_path + "' is too long.");
+  }
+  std::strncpy(address.sun_path, socket_path.c_str(),
+               sizeof(address.sun_path) - 1);
+
+  // Remove a stale socket of a previous run, but never any other file.
+  struct stat status;
+  if (lstat(socket_path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+    unlink(socket_path.c_str());
+  }
+
+  const int listen_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_socket < 0 ||
+      bind(listen_socket, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) < 0 ||
+      listen(listen_socket, 1) < 0) {
+    throw runtime_error("Cannot listen on '" + socket_path +
+                        "': " + std::strerror(errno));
+  }
+  cerr << "Waiting for nutr on '" << socket_path << "'" << endl;
+  const int connection = accept(listen_socket, nullptr, nullptr);
+  close(listen_socket);
+  unlink(socket_path.c_str());
+  if (connection < 0) {
+    throw runtime_error("Cannot accept a connection on '" + socket_path +
+                        "': " + std::strerror(errno));
+  }
+  return connection;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  po::options_description desc(
+      "nutr_consume: reference consumer for the output stream of nutr. "
+      "Prints a summary of each run, or the rows as comma-separated values");
+  desc.add_options()("help", "Show help message.")(
+      "source", po::value<string>()->default_value("-"),
+      "'-' for the standard input (default), 'unix:PATH' to listen on a Unix "
+      "domain socket, or the path of a named pipe.")(
+      "csv", "Print the rows of the first table as comma-separated values.")(
+      "delay", po::value<unsigned int>()->default_value(0),
+      "Wait for the given number of microseconds after each record, to "
+      "simulate a slow consumer.");
+  po::positional_options_description positional;
+  positional.add("source", 1);
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv)
+                .options(desc)
+                .positional(positional)
+                .run(),
+            vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    cout << desc << endl;
+    return 1;
+  }
+
+  try {
+    const string source = vm["source"].as<string>();
+    int file_descriptor = STDIN_FILENO;
+    if (source.rfind("unix:", 0) == 0) {
+      file_descriptor = AcceptProducer(source.substr(5));
+    } else if (source != "-") {
+      file_descriptor = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+      if (file_descriptor < 0) {
+        throw runtime_error("Could not open '" + source +
+                            "': " + std::strerror(errno));
+      }
+    }
+
+    const bool csv = vm.count("csv");
+    const std::chrono::microseconds delay(vm["delay"].as<unsigned int>());
+    StreamReader reader(file_descriptor);
+    StreamReader::Record record;
+    for (unsigned int run = 0; reader.NextRun(); ++run) {
+      const auto &tables = reader.GetTables();
+      if (csv && !tables.empty()) {
+        for (size_t i = 0; i < tables[0].columns.size(); ++i) {
+          cout << (i ? "," : "") << tables[0].columns[i].name;
+        }
+        cout << "\n";
+      }
+
+      const auto start = std::chrono::steady_clock::now();
+      uint64_t n_records = 0, n_rows = 0, n_bytes = 0;
+      while (reader.NextRecord(record)) {
+        ++n_records;
+        n_rows += record.n_rows;
+        n_bytes += record.rows.size();
+        if (csv && record.table == 0) {
+          for (uint32_t row = 0; row < record.n_rows; ++row) {
+            for (size_t i = 0; i < tables[0].columns.size(); ++i) {
+              cout << (i ? "," : "");
+              if (columnar::IsIntegerType(tables[0].columns[i].type)) {
+                cout << reader.GetInteger(record, row, i);
+              } else {
+                cout << std::setprecision(17)
+                     << reader.GetValue(record, row, i);
+              }
+            }
+            cout << "\n";
+          }
+        }
+        if (delay.count() > 0) {
+          std::this_thread::sleep_for(delay);
+        }
+      }
+      const double seconds = std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+
+      (csv ? cerr : cout) << "Run " << run << ": " << n_records
+                          << " event records, " << n_rows << " rows, "
+                          << n_bytes << " bytes in " << seconds << " s ("
+                          << n_records / std::max(seconds, 1e-9)
+                          << " records/s)" << endl;
+    }
+  } catch (const std::exception &e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,169 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+#include "ColumnCodec.hh"
+#include "ColumnarDataset.hh"
+
+int main(int argc, char **argv) {
+  po::options_description desc(
+      "nutr_dump: print the content of a nutr columnar output file or of the "
+      "files in a manifest");
+  desc.add_options()("help", "Show help message.")(
+      "file", po::value<string>(),
+      "Name of the columnar output file or of the manifest.")(
+      "schema", "Only print the tables, columns, and row groups of the file.")(
+      "table", po::value<string>(),
+      "Name of the table to be printed. Default: the first table.")(
+      "columns", po::value<string>(),
+      "Comma-separated list of columns to be printed. Default: all columns.")(
+      "head", po::value<unsigned long>(),
+      "Only print the given number of rows.");
+  po::positional_options_description positional;
+  positional.add("file", 1);
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv)
+                .options(desc)
+                .positional(positional)
+                .run(),
+            vm);
+  po::notify(vm);
+
+  if (vm.count("help") || !vm.count("file")) {
+    cout << desc << endl;
+    return 1;
+  }
+
+  try {
+    ColumnarDataset dataset(vm["file"].as<string>());
+    const auto &tables = dataset.GetTables();
+
+    if (vm.count("schema")) {
+      for (size_t i = 0; i < tables.size(); ++i) {
+        cout << tables[i].name << " (" << tables[i].title << "): "
+             << dataset.GetNumberOfRows(i) << " rows in "
+             << dataset.GetRowGroups(i).size() << " row groups in "
+             << dataset.GetNumberOfFiles() << " files" << endl;
+        for (size_t j = 0; j < tables[i].columns.size(); ++j) {
+          uint64_t stored_size = 0, encoded_size = 0;
+          for (const auto &row_group : dataset.GetRowGroups(i)) {
+            const auto &chunk = dataset.GetFile(row_group.file)
+                                    .GetRowGroup(row_group.row_group)
+                                    .chunks[j];
+            stored_size += chunk.stored_size;
+            encoded_size += chunk.encoded_size;
+          }
+          cout << "  " << tables[i].columns[j].name << " "
+               << columnar::ColumnTypeName(tables[i].columns[j].type);
+          if (tables[i].columns[j].type == columnar::ColumnType::quantized) {
+            cout << " (lsb " << tables[i].columns[j].scale << ")";
+          }
+          cout << ", " << stored_size << " bytes (" << encoded_size
+               << " bytes before compression)" << endl;
+        }
+      }
+      return 0;
+    }
+
+    if (tables.empty()) {
+      return 0;
+    }
+    const size_t table =
+        vm.count("table") ? dataset.GetTableID(vm["table"].as<string>()) : 0;
+
+    vector<size_t> columns;
+    if (vm.count("columns")) {
+      std::stringstream column_list(vm["columns"].as<string>());
+      string column;
+      while (std::getline(column_list, column, ',')) {
+        columns.push_back(dataset.GetColumnID(table, column));
+      }
+    } else {
+      for (size_t i = 0; i < tables[table].columns.size(); ++i) {
+        columns.push_back(i);
+      }
+    }
+
+    for (size_t i = 0; i < columns.size(); ++i) {
+      cout << (i ? "," : "") << tables[table].columns[columns[i]].name;
+    }
+    cout << "\n";
+
+    // Print row group by row group, so that the memory consumption does not
+    // depend on the size of the file.
+    uint64_t n_rows = vm.count("head") ? vm["head"].as<unsigned long>()
+                                       : dataset.GetNumberOfRows(table);
+    for (const auto &row_group : dataset.GetRowGroups(table)) {
+      if (n_rows == 0) {
+        break;
+      }
+      vector<vector<int64_t>> integers(columns.size());
+      vector<vector<double>> floating_points(columns.size());
+      for (size_t i = 0; i < columns.size(); ++i) {
+        if (columnar::IsIntegerType(
+                tables[table].columns[columns[i]].type)) {
+          dataset.ReadColumn(row_group, table, columns[i], integers[i]);
+        } else {
+          dataset.ReadColumn(row_group, table, columns[i],
+                             floating_points[i]);
+        }
+      }
+      const uint64_t n_rows_group =
+          std::min(n_rows, dataset.GetNumberOfRows(row_group));
+      for (uint64_t row = 0; row < n_rows_group; ++row) {
+        for (size_t i = 0; i < columns.size(); ++i) {
+          cout << (i ? "," : "");
+          if (integers[i].size()) {
+            cout << integers[i][row];
+          } else {
+            // Print as many digits as needed to restore the stored value.
+            cout << std::setprecision(tables[table].columns[columns[i]].type ==
+                                              columnar::ColumnType::float32
+                                          ? 9
+                                          : 17)
+                 << floating_points[i][row];
+          }
+        }
+        cout << "\n";
+      }
+      n_rows -= n_rows_group;
+    }
+  } catch (const std::exception &e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return 0;
+}
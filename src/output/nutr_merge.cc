@@ -0,0 +1,344 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::atomic;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+#include "ColumnCodec.hh"
+#include "ColumnarDataset.hh"
+#include "ColumnarFileWriter.hh"
+
+namespace {
+
+/**
+ * \brief Decoded values of a column in the storage type of the column
+ */
+struct ColumnBuffer {
+  vector<int64_t> integers;
+  vector<double> doubles;
+  vector<float> floats;
+};
+
+/**
+ * \brief Copy a row group without decoding it
+ */
+void CopyRowGroup(const ColumnarDataset &dataset,
+                  const ColumnarDataset::RowGroup &row_group,
+                  ColumnarFileWriter &output, const uint32_t table,
+                  const uint32_t writer) {
+  const auto &reader = dataset.GetFile(row_group.file);
+  const auto &info = reader.GetRowGroup(row_group.row_group);
+  vector<columnar::EncodedChunk> chunks;
+  chunks.reserve(info.chunks.size());
+  for (const auto &chunk : info.chunks) {
+    const auto *bytes =
+        reinterpret_cast<const char *>(reader.GetChunkData(chunk));
+    chunks.push_back(columnar::EncodedChunk{
+        string(bytes, chunk.stored_size), chunk.encoded_size, chunk.codec});
+  }
+  output.WriteRowGroup(table, writer, info.n_rows, chunks);
+}
+
+void WriteColumns(const columnar::TableSchema &schema,
+                  vector<ColumnBuffer> &columns, const uint64_t n_rows,
+                  ColumnarFileWriter &output, const uint32_t table,
+                  const uint32_t writer) {
+  vector<columnar::EncodedChunk> chunks;
+  chunks.reserve(columns.size());
+  for (size_t i = 0; i < columns.size(); ++i) {
+    switch (schema.columns[i].type) {
+    case columnar::ColumnType::int32:
+    case columnar::ColumnType::int64:
+    case columnar::ColumnType::quantized:
+      chunks.push_back(columnar::EncodeIntegers(columns[i].integers));
+      columns[i].integers.clear();
+      break;
+    case columnar::ColumnType::float64:
+      chunks.push_back(columnar::EncodeFloats(columns[i].doubles));
+      columns[i].doubles.clear();
+      break;
+    case columnar::ColumnType::float32:
+      chunks.push_back(columnar::EncodeFloats(columns[i].floats));
+      columns[i].floats.clear();
+      break;
+    }
+  }
+  output.WriteRowGroup(table, writer, n_rows, chunks);
+}
+
+/**
+ * \brief Consecutive row groups of a table that are compacted by one task
+ */
+struct CompactTask {
+  size_t table;
+  vector<ColumnarDataset::RowGroup> row_groups;
+  uint64_t n_rows;
+};
+
+/**
+ * \brief Split the row groups of a table into consecutive runs of at least
+ * rows_per_group rows, one run per thread if the table is large enough
+ *
+ * Since the runs are only split between row groups, the files of a manifest
+ * are combined as well.
+ */
+void AddCompactTasks(const ColumnarDataset &dataset, const size_t table,
+                     const uint64_t rows_per_group,
+                     const unsigned int n_threads,
+                     vector<CompactTask> &tasks) {
+  const uint64_t n_rows = dataset.GetNumberOfRows(table);
+  const uint64_t rows_per_task =
+      std::max(rows_per_group, n_rows / std::max(1u, n_threads));
+  uint64_t rows_left = n_rows;
+  CompactTask task{table, {}, 0};
+  for (const auto &row_group : dataset.GetRowGroups(table)) {
+    const auto n = dataset.GetNumberOfRows(row_group);
+    task.row_groups.push_back(row_group);
+    task.n_rows += n;
+    rows_left -= n;
+    // The rest of the table is added to the last task if it would be too
+    // small for a row group of its own.
+    if (task.n_rows >= rows_per_task && rows_left >= rows_per_group) {
+      tasks.push_back(std::move(task));
+      task = CompactTask{table, {}, 0};
+    }
+  }
+  if (!task.row_groups.empty()) {
+    tasks.push_back(std::move(task));
+  }
+}
+
+/**
+ * \brief Decode the row groups of a task and re-encode them in row groups of
+ * at least rows_per_group rows
+ *
+ * Row groups are not split, and the last row group of the task also takes
+ * the rows that would not fill another one. A compacted row group may
+ * therefore be up to about twice as large as rows_per_group. Quantized
+ * columns keep their integer channels, so compaction is lossless.
+ */
+void CompactRowGroups(const ColumnarDataset &dataset, const CompactTask &task,
+                      const uint64_t rows_per_group,
+                      ColumnarFileWriter &output, const uint32_t output_table,
+                      const uint32_t writer) {
+  const auto &schema = dataset.GetTables()[task.table];
+
+  vector<ColumnBuffer> columns(schema.columns.size());
+  uint64_t n_rows = 0;
+  uint64_t rows_left = task.n_rows;
+  for (const auto &row_group : task.row_groups) {
+    const auto &reader = dataset.GetFile(row_group.file);
+    const auto &info = reader.GetRowGroup(row_group.row_group);
+    for (size_t i = 0; i < columns.size(); ++i) {
+      const auto &chunk = info.chunks[i];
+      const auto *data = reader.GetChunkData(chunk);
+      switch (schema.columns[i].type) {
+      case columnar::ColumnType::int32:
+      case columnar::ColumnType::int64:
+      case columnar::ColumnType::quantized:
+        columnar::DecodeIntegers(data, chunk.stored_size, chunk.encoded_size,
+                                 chunk.codec, info.n_rows,
+                                 columns[i].integers);
+        break;
+      case columnar::ColumnType::float64:
+        columnar::DecodeFloats(data, chunk.stored_size, chunk.encoded_size,
+                               chunk.codec, info.n_rows, columns[i].doubles);
+        break;
+      case columnar::ColumnType::float32:
+        columnar::DecodeFloats(data, chunk.stored_size, chunk.encoded_size,
+                               chunk.codec, info.n_rows, columns[i].floats);
+        break;
+      }
+    }
+    n_rows += info.n_rows;
+    rows_left -= info.n_rows;
+    if (n_rows >= rows_per_group && rows_left >= rows_per_group) {
+      WriteColumns(schema, columns, n_rows, output, output_table, writer);
+      n_rows = 0;
+    }
+  }
+  if (n_rows > 0) {
+    WriteColumns(schema, columns, n_rows, output, output_table, writer);
+  }
+}
+
+/**
+ * \brief Run tasks 0, ..., n_tasks - 1 on a pool of n_threads threads
+ *
+ * \throw The first exception that was thrown by a task.
+ */
+template <typename F>
+void RunTasks(const size_t n_tasks, const unsigned int n_threads, F task) {
+  atomic<size_t> next_task{0};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  vector<std::thread> threads;
+  for (unsigned int i = 0; i < std::max(1u, n_threads); ++i) {
+    threads.emplace_back([&]() {
+      for (size_t n = next_task++; n < n_tasks; n = next_task++) {
+        try {
+          task(n);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+          next_task = n_tasks;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  po::options_description desc(
+      "nutr_merge: merge nutr columnar output files, for example the files "
+      "of the threads of a simulation that are listed in a manifest, into a "
+      "single file.\n"
+      "The row groups of the input files are written in parallel, so the "
+      "order of the rows of different input files is not preserved");
+  desc.add_options()("help", "Show help message.")(
+      "input", po::value<vector<string>>(),
+      "Names of the input files or manifests.")(
+      "output,o", po::value<string>(), "Name of the merged output file.")(
+      "threads,j", po::value<unsigned int>(),
+      "Number of threads. Default: number of hardware threads.")(
+      "compact",
+      "Decode and re-encode the input, so that the merged file consists of "
+      "large row groups. Without this option, row groups are copied without "
+      "decoding them.")(
+      "rows", po::value<unsigned long>()->default_value(1000000),
+      "Minimum number of rows per row group with --compact, unless a table "
+      "has fewer rows.");
+  po::positional_options_description positional;
+  positional.add("input", -1);
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv)
+                .options(desc)
+                .positional(positional)
+                .run(),
+            vm);
+  po::notify(vm);
+
+  if (vm.count("help") || !vm.count("input") || !vm.count("output")) {
+    cout << desc << endl;
+    return 1;
+  }
+
+  try {
+    const ColumnarDataset dataset(vm["input"].as<vector<string>>());
+    const string output_path = vm["output"].as<string>();
+    for (size_t i = 0; i < dataset.GetNumberOfFiles(); ++i) {
+      if (std::filesystem::exists(output_path) &&
+          std::filesystem::equivalent(output_path,
+                                      dataset.GetFile(i).GetPath())) {
+        throw runtime_error("The output file '" + output_path +
+                            "' is also an input file.");
+      }
+    }
+    const unsigned int n_threads =
+        vm.count("threads") ? vm["threads"].as<unsigned int>()
+                            : std::thread::hardware_concurrency();
+
+    auto *output = ColumnarFileWriter::Acquire(output_path);
+    try {
+      const auto &tables = dataset.GetTables();
+      vector<uint32_t> output_tables;
+      for (const auto &table : tables) {
+        output_tables.push_back(output->DefineTable(table));
+      }
+
+      if (vm.count("compact")) {
+        const uint64_t rows_per_group =
+            std::max(1ul, vm["rows"].as<unsigned long>());
+        vector<CompactTask> tasks;
+        for (size_t table = 0; table < tables.size(); ++table) {
+          AddCompactTasks(dataset, table, rows_per_group, n_threads, tasks);
+        }
+        RunTasks(tasks.size(), n_threads, [&](const size_t n) {
+          CompactRowGroups(dataset, tasks[n], rows_per_group, *output,
+                           output_tables[tasks[n].table],
+                           output->NewWriter());
+        });
+      } else {
+        vector<std::pair<size_t, ColumnarDataset::RowGroup>> tasks;
+        for (size_t table = 0; table < tables.size(); ++table) {
+          for (const auto &row_group : dataset.GetRowGroups(table)) {
+            tasks.push_back({table, row_group});
+          }
+        }
+        // Row groups of the same input file keep the writer ID of the file.
+        vector<uint32_t> writers;
+        for (size_t file = 0; file < dataset.GetNumberOfFiles(); ++file) {
+          writers.push_back(output->NewWriter());
+        }
+        RunTasks(tasks.size(), n_threads, [&](const size_t n) {
+          const auto &[table, row_group] = tasks[n];
+          CopyRowGroup(dataset, row_group, *output, output_tables[table],
+                       writers[row_group.file]);
+        });
+      }
+    } catch (...) {
+      ColumnarFileWriter::Release(output);
+      throw;
+    }
+    ColumnarFileWriter::Release(output);
+
+    for (size_t table = 0; table < dataset.GetTables().size(); ++table) {
+      cout << "Merged " << dataset.GetNumberOfRows(table) << " rows of table '"
+           << dataset.GetTables()[table].name << "' from "
+           << dataset.GetNumberOfFiles() << " files into '" << output_path
+           << "'." << endl;
+    }
+  } catch (const std::exception &e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,180 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::runtime_error;
+using std::string;
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+#include "ColumnarOutputBackend.hh"
+#include "TrackOutputBackend.hh"
+#include "TrackReader.hh"
+
+namespace {
+
+bool EndsWith(const string &text, const string &suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * \brief Convert a track file to the ntuple layout of the tracker sensitive
+ * detector in the columnar format
+ *
+ * The energies keep the quantization of the track file, the time, which is
+ * decoded relative to the first step of the event, is stored as float64,
+ * and the momentum as float32, so the conversion is lossless.
+ */
+void WriteColumnar(TrackReader &reader, const string &output) {
+  ColumnarOutputBackend backend;
+  backend.OpenFile(output);
+  backend.CreateNtuple("nutr", "nutr");
+  int columns[TrackOutputBackend::n_fields];
+  for (int field = 0; field < TrackOutputBackend::n_fields; ++field) {
+    const string name = TrackOutputBackend::field_names[field];
+    ColumnPrecision precision;
+    if (field == TrackOutputBackend::evid) {
+      columns[field] = backend.CreateNtupleLColumn(name);
+      continue;
+    }
+    if (field <= TrackOutputBackend::deid) {
+      columns[field] = backend.CreateNtupleIColumn(name);
+      continue;
+    }
+    if (field == TrackOutputBackend::edep) {
+      precision = {ColumnPrecision::quantized, reader.GetEdepLSB()};
+    } else if (field == TrackOutputBackend::ekin) {
+      precision = {ColumnPrecision::quantized, reader.GetEkinLSB()};
+    } else if (field >= TrackOutputBackend::momx) {
+      precision.type = ColumnPrecision::float32;
+    }
+    columns[field] = backend.CreateNtupleDColumn(name, precision);
+  }
+  backend.FinishNtuple();
+
+  TrackReader::Event event;
+  while (reader.Next(event)) {
+    for (const auto &step : event.steps) {
+      backend.FillNtupleLColumn(0, columns[TrackOutputBackend::evid],
+                                event.event_id);
+      backend.FillNtupleIColumn(0, columns[TrackOutputBackend::runid],
+                                event.run_id);
+      backend.FillNtupleIColumn(0, columns[TrackOutputBackend::trid],
+                                step.track_id);
+      backend.FillNtupleIColumn(0, columns[TrackOutputBackend::paid],
+                                step.pdg);
+      backend.FillNtupleIColumn(0, columns[TrackOutputBackend::deid],
+                                step.detector_id);
+      const double values[] = {
+          step.time,        step.edep,        step.ekin,
+          step.position[0], step.position[1], step.position[2],
+          step.momentum[0], step.momentum[1], step.momentum[2]};
+      for (int i = 0; i < 9; ++i) {
+        backend.FillNtupleDColumn(0, columns[TrackOutputBackend::time + i],
+                                  values[i]);
+      }
+      backend.AddNtupleRow(0);
+    }
+    backend.NewEvent();
+  }
+  backend.CloseFile();
+}
+
+void WriteCSV(TrackReader &reader, std::ostream &output) {
+  for (int field = 0; field < TrackOutputBackend::n_fields; ++field) {
+    output << (field ? "," : "") << TrackOutputBackend::field_names[field];
+  }
+  output << "\n" << std::setprecision(17);
+
+  TrackReader::Event event;
+  while (reader.Next(event)) {
+    for (const auto &step : event.steps) {
+      output << event.event_id << "," << event.run_id << "," << step.track_id
+             << "," << step.pdg << "," << step.detector_id << "," << step.time
+             << "," << step.edep << "," << step.ekin;
+      for (const auto position : step.position) {
+        output << "," << position;
+      }
+      for (const auto momentum : step.momentum) {
+        output << "," << momentum;
+      }
+      output << "\n";
+    }
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  po::options_description desc(
+      "nutr_tracks: convert a track file of the tracker sensitive detector "
+      "to the columnar format or to comma-separated values");
+  desc.add_options()("help", "Show help message.")(
+      "input", po::value<string>(), "Track file.")(
+      "output,o", po::value<string>()->default_value("-"),
+      "Output file. A file name that ends with '.nutr' selects the columnar "
+      "format, anything else comma-separated values. '-' prints "
+      "comma-separated values to the standard output (default).");
+  po::positional_options_description positional;
+  positional.add("input", 1);
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv)
+                .options(desc)
+                .positional(positional)
+                .run(),
+            vm);
+  po::notify(vm);
+
+  if (vm.count("help") || !vm.count("input")) {
+    cout << desc << endl;
+    return 1;
+  }
+
+  try {
+    TrackReader reader(vm["input"].as<string>());
+    const string output = vm["output"].as<string>();
+    if (output == "-") {
+      WriteCSV(reader, cout);
+    } else if (EndsWith(output, ".nutr")) {
+      WriteColumnar(reader, output);
+    } else {
+      std::ofstream file(output);
+      if (!file) {
+        throw runtime_error("Could not create '" + output + "'.");
+      }
+      WriteCSV(reader, file);
+    }
+  } catch (const std::exception &e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -26,6 +26,7 @@
 #include <stdexcept>
 #include <string_view>
 #include <system_error>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -46,6 +47,8 @@ using std::vector;
 #include "PrimaryGeneratorAction.hh"
 #include "SourceVolume.hh"
 #include "State.hh"
+#include "PerfCounters.hh"
+#include "Tracer.hh"
 
 template <typename F>
 void split_string_foreach(const std::string &str, const std::string &delim,
@@ -171,6 +174,8 @@ PrimaryGeneratorAction::PrimaryGeneratorAction(const long seed)
 }
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event *event) {
+  TraceScope trace("GeneratePrimaries");
+  PerfCounterScope counters(PerfCounters::generation);
 
   if (cascade.size() != cascade_energies.size() || cascade.size() == 0)
       [[unlikely]] {
@@ -227,21 +232,28 @@ void PrimaryGeneratorAction::normalize_intensities() {
   }
 }
 
-void PrimaryGeneratorAction::set_energies(const std::string &s_energies) {
+std::pair<std::vector<double>, std::string>
+parse_energies(const std::string &energies) {
   const std::string delim = " ";
   size_t start = 0;
-  size_t end = s_energies.find(delim);
+  size_t end = energies.find(delim);
 
-  cascade_energies.clear();
+  std::vector<double> values;
   while (end != std::string::npos) {
-    const auto str = s_energies.substr(start, end - start);
+    const auto str = energies.substr(start, end - start);
     start = end + delim.length();
-    end = s_energies.find(delim, start);
+    end = energies.find(delim, start);
 
-    cascade_energies.push_back(std::stod(str));
+    values.push_back(std::stod(str));
   }
 
-  auto unit = s_energies.substr(start, end - start);
+  return {values, energies.substr(start, end - start)};
+}
+
+void PrimaryGeneratorAction::set_energies(const std::string &s_energies) {
+  std::string unit;
+  std::tie(cascade_energies, unit) = parse_energies(s_energies);
+
   if (G4Threading::G4GetThreadId() == 0) {
     std::stringstream ss;
     ss << "Set alpaca energies to";
@@ -22,6 +22,9 @@
 #include "G4Event.hh"
 #include "G4GeneralParticleSource.hh"
 
+#include "PerfCounters.hh"
+#include "Tracer.hh"
+
 PrimaryGeneratorAction::PrimaryGeneratorAction([[maybe_unused]] const long seed)
     : G4VUserPrimaryGeneratorAction(), fParticleGun(nullptr) {
   fParticleGun = new G4GeneralParticleSource();
@@ -30,5 +33,7 @@ PrimaryGeneratorAction::PrimaryGeneratorAction([[maybe_unused]] const long seed)
 PrimaryGeneratorAction::~PrimaryGeneratorAction() { delete fParticleGun; }
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event *anEvent) {
+  TraceScope trace("GeneratePrimaries");
+  PerfCounterScope counters(PerfCounters::generation);
   fParticleGun->GeneratePrimaryVertex(anEvent);
 }
\ No newline at end of file
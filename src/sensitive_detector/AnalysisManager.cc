@@ -1,15 +1,44 @@
+#include <algorithm>
+#include <cctype>
 #include <ctime>
 #include <filesystem>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 
+using std::make_unique;
+using std::runtime_error;
+using std::to_string;
 using std::time;
 
 #include "G4Threading.hh"
 
 #include "AnalysisManager.hh"
+#include "ColumnarOutputBackend.hh"
+#include "G4OutputBackend.hh"
+#include "LiveMetrics.hh"
+#include "Manifest.hh"
+#include "MemoryMonitor.hh"
 #include "NutrMessenger.hh"
+#include "RunMetadata.hh"
+#include "Scorer.hh"
 #include "SensitiveDetectorBuildOptions.hh"
+#include "StepFormat.hh"
+#include "StreamOutputBackend.hh"
+#include "TrackFormat.hh"
+#include "TrackOutputBackend.hh"
+#include "Tracer.hh"
 
-AnalysisManager::AnalysisManager() : fFactoryOn(false) {}
+AnalysisManager::AnalysisManager()
+    : fFactoryOn(false), collected_energies(nullptr), keep_edep(true),
+      addback(false), keep_crystals(true), time_window(0.),
+      split_time_windows(false),
+      time_window_index(0), time_window_start(0.), write_weights(false),
+      spectrum({"energy", 0, 0., 0.}), merge(true), run_id(0),
+      global_event_id_offset(0), last_event_id(-1), primary_ntuple(-1) {}
+
+AnalysisManager::~AnalysisManager() = default;
 
 string AnalysisManager::create_default_file_name() const {
   string prefix = to_string(time(nullptr));
@@ -28,7 +57,70 @@ string AnalysisManager::create_default_file_name() const {
   return file_name_proposal;
 }
 
-void AnalysisManager::Book(string output_file_name) {
+void AnalysisManager::Book(string output_file_name, const G4int _run_id) {
+  TraceScope trace("AnalysisManager::Book");
+
+  if (_run_id < 0 || _run_id >= (G4int(1) << run_id_bits)) {
+    throw runtime_error("Run ID " + to_string(_run_id) +
+                        " does not fit into the " + to_string(run_id_bits) +
+                        " bits of the global event ID.");
+  }
+  run_id = _run_id;
+  global_event_id_offset = GlobalEventID(NutrMessenger::GetShard(), run_id, 0);
+  primary_ntuple = -1;
+
+  // The calibration is read at the beginning of each run, so that it may be
+  // changed in between. The columns depend on it.
+  const string calibration = NutrMessenger::GetCalibration();
+  digitizer =
+      calibration.empty() ? nullptr : make_unique<Digitizer>(calibration);
+  const string charge_collection_file = NutrMessenger::GetChargeCollection();
+  charge_collection = charge_collection_file.empty()
+                          ? nullptr
+                          : make_unique<ChargeCollection>(
+                                charge_collection_file);
+  collected_energies = nullptr;
+  keep_edep = NutrMessenger::GetKeepEdep();
+  addback = NutrMessenger::GetAddback();
+  keep_crystals = NutrMessenger::GetKeepCrystals();
+  time_window = NutrMessenger::GetTimeWindow();
+  split_time_windows = NutrMessenger::GetSplitTimeWindows();
+  write_weights = NutrMessenger::GetWriteWeights();
+  spectrum = NutrMessenger::GetSpectrum();
+  histograms.clear();
+  next_event_estimator = nullptr;
+  if (!NutrMessenger::GetPointDetectors().empty()) {
+    if (!HasSpectra()) {
+      if (G4Threading::IsMasterThread()) {
+        G4cout << "Warning: point detectors need the binning of their "
+                  "spectra (see /analysis/spectrum). They are ignored."
+               << G4endl;
+      }
+    } else if (NutrMessenger::GetPointDetectorVolumes().empty()) {
+      if (G4Threading::IsMasterThread()) {
+        G4cout << "Warning: point detectors need at least one volume in "
+                  "which photons scatter (see "
+                  "/analysis/point_detector_volume). They are ignored."
+               << G4endl;
+      }
+    } else {
+      next_event_estimator = make_unique<NextEventEstimator>(
+          NutrMessenger::GetPointDetectors(),
+          NutrMessenger::GetPointDetectorVolumes(), spectrum);
+    }
+  }
+  const auto &scorers = NutrMessenger::GetScorers();
+  const bool step_points =
+      std::find(scorers.begin(), scorers.end(), "step_points") !=
+      scorers.end();
+  if (scorers.size() > (step_points ? 1 : 0) && !HasSpectra() &&
+      G4Threading::IsMasterThread()) {
+    G4cout << "Warning: scorers need the binning of their spectra (see "
+              "/analysis/spectrum). They are ignored."
+           << G4endl;
+  }
+  ScorerSet::ForThread().BeginOfRun(spectrum, NutrMessenger::GetAngleBins(),
+                                    NutrMessenger::GetBatchSize());
 
   auto output_file_name_macro = NutrMessenger::GetFilename();
   if (output_file_name_macro != "") {
@@ -37,63 +129,233 @@ void AnalysisManager::Book(string output_file_name) {
     output_file_name = create_default_file_name();
   }
 
-  G4AnalysisManager *analysisManager = G4AnalysisManager::Instance();
-  // The command below merges the output created by different threads into a
-  // single file. This does not work for some file formats. Geant4 will print a
-  // warning during execution and refuse to merge the files. In principle, one
-  // could use SetNtupleMerging only if OUTPUT_FORMAT="root". However, it was
-  // chosen to keep the warning message here so that a user who has been working
-  // with OUTPUT_FORMAT="root" and switches to OUTPUT_FORMAT="csv" will not
-  // wonder why the files are not merged any more.
-  analysisManager->SetNtupleMerging(true);
-  analysisManager->OpenFile(output_file_name);
-  CreateNtupleColumns(analysisManager);
-  analysisManager->FinishNtuple();
+  // Without merging, each worker thread writes its own file, and the master
+  // thread lists them in a manifest at the end of the run. In sequential
+  // mode, there is only a single file anyway. A stream is always shared by
+  // all threads.
+  const bool stream = StreamWriter::IsStream(output_file_name);
+  merge = stream || NutrMessenger::GetMerge() ||
+          !G4Threading::IsMultithreadedApplication();
+  manifest_file_name = "";
+  result_file_name = stream ? "" : output_file_name;
+  if (!merge && G4Threading::IsMasterThread()) {
+    manifest_file_name = manifest::ManifestFileName(output_file_name);
+    std::lock_guard<std::mutex> lock(thread_files_mutex);
+    thread_files.clear();
+  }
+
+  // The step-point file is shared by all threads. The master thread opens it
+  // as well, so that it stays open until the end of the run.
+  if (step_points && result_file_name.empty()) {
+    if (G4Threading::IsMasterThread()) {
+      G4cout << "Warning: step points cannot be sent to a stream. Set a file "
+                "name with /analysis/filename to record them."
+             << G4endl;
+    }
+  } else if (step_points) {
+    ScorerSet::ForThread().OpenStepFile(
+        step_format::StepFileName(result_file_name), run_id,
+        global_event_id_offset);
+  }
+
+  const auto extension = std::filesystem::path(output_file_name).extension();
+  const bool columnar = !stream && extension == ".nutr";
+  const bool tracks = !stream && extension == track_format::extension;
+  if (tracks && write_weights) {
+    if (G4Threading::IsMasterThread()) {
+      G4cout << "Warning: track files ('" << track_format::extension
+             << "') cannot store the weights of the tracks." << G4endl;
+    }
+    write_weights = false;
+  }
+  if (!columnar && G4Threading::IsMasterThread() &&
+      (NutrMessenger::GetRotateEvents() > 0 ||
+       NutrMessenger::GetRotateBytes() > 0)) {
+    G4cout << "Warning: output file rotation is only supported for the "
+              "native columnar format ('.nutr'). Writing a single file."
+           << G4endl;
+  }
+  // Geant4 ntuples have no 64-bit integer columns, so the global event IDs
+  // are stored as doubles, which are only exact up to 2^53. Rounded IDs of
+  // different events would collide when the shards are merged.
+  if (!stream && !columnar && !tracks &&
+      global_event_id_offset >= (int64_t(1) << 53)) {
+    throw runtime_error("The global event IDs of shard " +
+                        to_string(NutrMessenger::GetShard()) +
+                        " cannot be stored exactly in Geant4 ntuples. Use "
+                        "the native columnar format ('.nutr') or a shard "
+                        "index below " +
+                        to_string(1 << (53 - event_id_bits - run_id_bits)) +
+                        ".");
+  }
+
+  if (stream) {
+    output = make_unique<StreamOutputBackend>();
+  } else if (columnar || tracks) {
+    if (!merge) {
+      if (G4Threading::IsMasterThread()) {
+        // The master thread processes no events, so it writes no file.
+        LiveMetrics::SetOutputFile(output_file_name);
+        output = nullptr;
+        return;
+      }
+      output_file_name = manifest::ThreadFileName(
+          output_file_name, G4Threading::G4GetThreadId());
+    }
+    if (tracks) {
+      output = make_unique<TrackOutputBackend>();
+    } else {
+      auto columnar_output = make_unique<ColumnarOutputBackend>();
+      columnar_output->SetRotation(NutrMessenger::GetRotateEvents(),
+                                   NutrMessenger::GetRotateBytes());
+      output = std::move(columnar_output);
+    }
+  } else {
+    output = make_unique<G4OutputBackend>(merge);
+  }
+  for (const auto &[pattern, precision] : NutrMessenger::GetPrecisions()) {
+    output->SetPrecision(pattern, precision);
+  }
+  output->OpenFile(output_file_name);
+  CreateNtupleColumns(output.get());
+  output->FinishNtuple();
+  if (NutrMessenger::GetRecordPrimaries() && tracks) {
+    if (G4Threading::IsMasterThread()) {
+      G4cout << "Warning: track files ('" << track_format::extension
+             << "') cannot store the primary particles." << G4endl;
+    }
+  } else if (NutrMessenger::GetRecordPrimaries()) {
+    CreatePrimaryNtuple(output.get());
+    output->FinishNtuple();
+  }
+
+  if (G4Threading::IsMasterThread()) {
+    LiveMetrics::SetOutputFile(output->GetFileName());
+  }
+
+  // The trigger is compiled at the beginning of each run, since the
+  // expression may have been changed in between.
+  const string trigger_expression = NutrMessenger::GetTrigger();
+  trigger = trigger_expression.empty()
+                ? nullptr
+                : make_unique<Trigger>(trigger_expression);
 
+  last_event_id = -1;
   fFactoryOn = true;
 }
 
-void AnalysisManager::CreateNtupleColumns(G4AnalysisManager *analysisManager) {
+size_t AnalysisManager::GetMaxTimeWindows() const {
+  return time_window > 0. && split_time_windows
+             ? std::numeric_limits<size_t>::max()
+             : 1;
+}
+
+void AnalysisManager::CreateNtupleColumns(OutputBackend *output) {
 
-  analysisManager->CreateNtupleIColumn("evid");
+  output->CreateNtupleLColumn("evid");
+  output->CreateNtupleIColumn("runid");
 
   if constexpr (sensitive_detector_build_options.track_primary) {
-    analysisManager->CreateNtupleDColumn("pos0x");
-    analysisManager->CreateNtupleDColumn("pos0y");
-    analysisManager->CreateNtupleDColumn("pos0z");
-    analysisManager->CreateNtupleDColumn("mom0x");
-    analysisManager->CreateNtupleDColumn("mom0y");
-    analysisManager->CreateNtupleDColumn("mom0z");
+    output->CreateNtupleDColumn("pos0x");
+    output->CreateNtupleDColumn("pos0y");
+    output->CreateNtupleDColumn("pos0z");
+    output->CreateNtupleDColumn("mom0x");
+    output->CreateNtupleDColumn("mom0y");
+    output->CreateNtupleDColumn("mom0z");
+  }
+}
+
+void AnalysisManager::CreateTimeWindowColumns(OutputBackend *output) {
+  if (time_window > 0.) {
+    output->CreateNtupleIColumn("win");
+    output->CreateNtupleDColumn("t0");
+  }
+}
+
+size_t AnalysisManager::FillTimeWindowColumns(OutputBackend *output,
+                                              size_t col) {
+  if (time_window > 0.) {
+    output->FillNtupleIColumn(0, col++, time_window_index);
+    output->FillNtupleDColumn(0, col++, time_window_start);
+  }
+  return col;
+}
+
+void AnalysisManager::CreatePrimaryNtuple(OutputBackend *output) {
+  primary_ntuple = output->CreateNtuple("primaries", "Primary particles");
+  output->CreateNtupleLColumn("evid");
+  output->CreateNtupleIColumn("vtx");
+  output->CreateNtupleIColumn("pdg");
+  output->CreateNtupleDColumn("ekin");
+  output->CreateNtupleDColumn("dirx");
+  output->CreateNtupleDColumn("diry");
+  output->CreateNtupleDColumn("dirz");
+  output->CreateNtupleDColumn("polx");
+  output->CreateNtupleDColumn("poly");
+  output->CreateNtupleDColumn("polz");
+}
+
+void AnalysisManager::FillPrimaryNtuple(const G4Event *event,
+                                        const int64_t global_event_id) {
+  G4int vertex_index = 0;
+  for (const G4PrimaryVertex *vertex = event->GetPrimaryVertex(0);
+       vertex != nullptr; vertex = vertex->GetNext(), ++vertex_index) {
+    for (const G4PrimaryParticle *particle = vertex->GetPrimary();
+         particle != nullptr; particle = particle->GetNext()) {
+      const G4ThreeVector &direction = particle->GetMomentumDirection();
+      const G4ThreeVector &polarization = particle->GetPolarization();
+      output->FillNtupleLColumn(primary_ntuple, 0, global_event_id);
+      output->FillNtupleIColumn(primary_ntuple, 1, vertex_index);
+      output->FillNtupleIColumn(primary_ntuple, 2, particle->GetPDGcode());
+      output->FillNtupleDColumn(primary_ntuple, 3,
+                                particle->GetKineticEnergy());
+      output->FillNtupleDColumn(primary_ntuple, 4, direction.x());
+      output->FillNtupleDColumn(primary_ntuple, 5, direction.y());
+      output->FillNtupleDColumn(primary_ntuple, 6, direction.z());
+      output->FillNtupleDColumn(primary_ntuple, 7, polarization.x());
+      output->FillNtupleDColumn(primary_ntuple, 8, polarization.y());
+      output->FillNtupleDColumn(primary_ntuple, 9, polarization.z());
+      output->AddNtupleRow(primary_ntuple);
+    }
   }
 }
 
 void AnalysisManager::FillNtuple(const G4Event *event, vector<G4VHit *> hits) {
+  TraceScope trace("AnalysisManager::FillNtuple");
 
-  G4AnalysisManager *analysisManager = G4AnalysisManager::Instance();
-  FillNtupleColumns(analysisManager, event, hits);
-  analysisManager->AddNtupleRow(0);
+  // Some sensitive detectors write several rows per event.
+  if (event->GetEventID() != last_event_id) {
+    last_event_id = event->GetEventID();
+    output->NewEvent();
+    if (primary_ntuple >= 0) {
+      FillPrimaryNtuple(event, global_event_id_offset | last_event_id);
+    }
+  }
+  MemoryMonitor::RecordNtupleRow(FillNtupleColumns(output.get(), event, hits));
+  output->AddNtupleRow(0);
 }
 
 size_t
-AnalysisManager::FillNtupleColumns(G4AnalysisManager *analysisManager,
-                                   const G4Event *event,
+AnalysisManager::FillNtupleColumns(OutputBackend *output, const G4Event *event,
                                    [[maybe_unused]] vector<G4VHit *> hits) {
 
   size_t col = 0;
-  analysisManager->FillNtupleIColumn(0, col++, event->GetEventID());
+  output->FillNtupleLColumn(0, col++,
+                            global_event_id_offset | event->GetEventID());
+  output->FillNtupleIColumn(0, col++, run_id);
 
   if constexpr (sensitive_detector_build_options.track_primary) {
     const G4PrimaryVertex *primary_vertex = event->GetPrimaryVertex(0);
     if (primary_vertex != nullptr) {
-      analysisManager->FillNtupleDColumn(0, col++, primary_vertex->GetX0());
-      analysisManager->FillNtupleDColumn(0, col++, primary_vertex->GetY0());
-      analysisManager->FillNtupleDColumn(0, col++, primary_vertex->GetZ0());
+      output->FillNtupleDColumn(0, col++, primary_vertex->GetX0());
+      output->FillNtupleDColumn(0, col++, primary_vertex->GetY0());
+      output->FillNtupleDColumn(0, col++, primary_vertex->GetZ0());
 
       const G4PrimaryParticle *primary_particle = primary_vertex->GetPrimary();
       if (primary_particle != nullptr) {
-        analysisManager->FillNtupleDColumn(0, col++, primary_particle->GetPx());
-        analysisManager->FillNtupleDColumn(0, col++, primary_particle->GetPy());
-        analysisManager->FillNtupleDColumn(0, col++, primary_particle->GetPz());
+        output->FillNtupleDColumn(0, col++, primary_particle->GetPx());
+        output->FillNtupleDColumn(0, col++, primary_particle->GetPy());
+        output->FillNtupleDColumn(0, col++, primary_particle->GetPz());
       } else {
         col += 3;
       }
@@ -105,19 +367,146 @@ AnalysisManager::FillNtupleColumns(G4AnalysisManager *analysisManager,
   return col;
 }
 
+void AnalysisManager::FillHistograms(
+    [[maybe_unused]] const vector<G4VHit *> &hits) {}
+
+void AnalysisManager::FinishHistograms() {}
+
 void AnalysisManager::Save() {
 
-  if (!fFactoryOn)
-    return;
+  if (fFactoryOn) {
+    TraceScope trace("AnalysisManager::Save");
 
-  G4AnalysisManager *analysisManager = G4AnalysisManager::Instance();
-  analysisManager->Write();
-  analysisManager->CloseFile();
+    output->Write();
+    output->CloseFile();
 
-  if (G4Threading::G4GetThreadId() == 0) {
-    G4cout << "Created output file '" << analysisManager->GetFileName() << "'."
-           << G4endl;
+    if (merge && G4Threading::G4GetThreadId() == 0) {
+      const auto file_names = output->GetFileNames();
+      if (file_names.empty()) {
+        G4cout << "Sent output to stream '" << output->GetFileName() << "'."
+               << G4endl;
+      } else if (file_names.size() == 1 &&
+                 file_names[0] == output->GetFileName()) {
+        G4cout << "Created output file '" << output->GetFileName() << "'."
+               << G4endl;
+      } else {
+        G4cout << "Output files are listed in '"
+               << manifest::ManifestFileName(output->GetFileName()) << "'."
+               << G4endl;
+      }
+    }
+    if (!merge && !G4Threading::IsMasterThread()) {
+      const auto file_names = output->GetFileNames();
+      std::lock_guard<std::mutex> lock(thread_files_mutex);
+      thread_files.insert(thread_files.end(), file_names.begin(),
+                          file_names.end());
+    }
+    if (merge && G4Threading::IsMasterThread()) {
+      result_files = output->GetFileNames();
+      for (const auto &file_name : result_files) {
+        MemoryMonitor::RecordOutputFile(file_name);
+      }
+      // A sequence of rotated files is listed in an index.
+      if (!result_files.empty() &&
+          (result_files.size() > 1 ||
+           result_files[0] != output->GetFileName())) {
+        result_files.push_back(
+            manifest::ManifestFileName(output->GetFileName()));
+      }
+    }
+
+    fFactoryOn = false;
+  }
+
+  FinishHistograms();
+  if (next_event_estimator != nullptr) {
+    const auto &estimator_histograms = next_event_estimator->GetHistograms();
+    histograms.insert(histograms.end(), estimator_histograms.begin(),
+                      estimator_histograms.end());
+    next_event_estimator = nullptr;
+  }
+  ScorerSet::ForThread().EndOfRun(histograms, batches);
+
+  // Each thread adds its spectra to the ones of the run. Histograms with the
+  // same name have the same binning, since they were created in the same run.
+  if (!histograms.empty() || !batches.empty()) {
+    std::lock_guard<std::mutex> lock(merged_histograms_mutex);
+    for (const auto &[prefix, n_batches] : batches) {
+      merged_batches[prefix] += n_batches;
+    }
+    batches.clear();
+    for (const auto &histogram : histograms) {
+      auto merged =
+          std::find_if(merged_histograms.begin(), merged_histograms.end(),
+                       [&histogram](const Histogram &h) {
+                         return h.GetName() == histogram.GetName();
+                       });
+      if (merged == merged_histograms.end()) {
+        merged_histograms.push_back(histogram);
+      } else {
+        merged->Add(histogram);
+      }
+    }
+    histograms.clear();
+  }
+
+  // The master thread ends the run after all workers, so all thread files
+  // have been registered at this point.
+  if (!manifest_file_name.empty()) {
+    std::lock_guard<std::mutex> lock(thread_files_mutex);
+    std::sort(thread_files.begin(), thread_files.end());
+    manifest::Write(manifest_file_name, thread_files);
+    for (const auto &file_name : thread_files) {
+      MemoryMonitor::RecordOutputFile(file_name);
+    }
+    G4cout << "Created output manifest '" << manifest_file_name << "' of "
+           << thread_files.size() << " files." << G4endl;
+    result_files = thread_files;
+    result_files.push_back(manifest_file_name);
+    manifest_file_name = "";
+  }
+
+  if (G4Threading::IsMasterThread()) {
+    std::lock_guard<std::mutex> lock(merged_histograms_mutex);
+    // A thread only creates a batch-statistics spectrum when a particle
+    // arrives, so the other threads did not add their empty batches.
+    for (auto &histogram : merged_histograms) {
+      const string &name = histogram.GetName();
+      for (const auto &[prefix, n_batches] : merged_batches) {
+        if (name.size() > prefix.size() && name.starts_with(prefix) &&
+            std::isdigit(static_cast<unsigned char>(name[prefix.size()]))) {
+          histogram.PadEntries(n_batches);
+        }
+      }
+    }
+    merged_batches.clear();
+    if (!merged_histograms.empty() && result_file_name.empty()) {
+      G4cout << "Warning: spectra cannot be sent to a stream. Set a file name "
+                "with /analysis/filename to write them."
+             << G4endl;
+    } else if (!merged_histograms.empty()) {
+      const string histogram_file_name =
+          histogram::HistogramFileName(result_file_name);
+      histogram::Write(histogram_file_name, merged_histograms);
+      MemoryMonitor::RecordOutputFile(histogram_file_name);
+      G4cout << "Created spectrum file '" << histogram_file_name << "' of "
+             << merged_histograms.size() << " spectra." << G4endl;
+      result_files.push_back(histogram_file_name);
+    }
+    merged_histograms.clear();
+
+    const string &step_file_name = ScorerSet::ForThread().GetStepFileName();
+    if (!step_file_name.empty()) {
+      MemoryMonitor::RecordOutputFile(step_file_name);
+      G4cout << "Created step-point file '" << step_file_name << "'."
+             << G4endl;
+      result_files.push_back(step_file_name);
+    }
   }
 
-  fFactoryOn = false;
+  if (G4Threading::IsMasterThread() && RunMetadata::IsConfigured() &&
+      !result_file_name.empty() && !result_files.empty()) {
+    RunMetadata::Write(result_file_name, result_files);
+  }
+  result_files.clear();
 }
@@ -0,0 +1,168 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+using std::runtime_error;
+using std::to_string;
+
+#include "G4SystemOfUnits.hh"
+
+#include "ChargeCollection.hh"
+
+namespace {
+
+double ParseNumber(const string &field, const string &location) {
+  size_t end = 0;
+  double value = 0.;
+  try {
+    value = std::stod(field, &end);
+  } catch (const std::exception &) {
+    end = 0;
+  }
+  if (end != field.size()) {
+    throw runtime_error("Invalid number '" + field + "' in " + location + ".");
+  }
+  return value;
+}
+
+} // namespace
+
+double ChargeCollection::Layer::Efficiency(const double depth) const {
+  if (depth < dead_layer) {
+    return 0.;
+  }
+  if (depth < dead_layer + transition) {
+    return efficiency * (depth - dead_layer) / transition;
+  }
+  return efficiency;
+}
+
+ChargeCollection::ChargeCollection(const string &_file_name)
+    : file_name(_file_name) {
+  std::ifstream file(file_name);
+  if (!file) {
+    throw runtime_error("Could not open charge-collection file '" +
+                        file_name + "'.");
+  }
+
+  // Layers by variant and detector ID, or by variant for the default.
+  std::map<std::pair<size_t, size_t>, Layer> listed_layers;
+  std::map<size_t, Layer> listed_default_layers;
+  string line;
+  for (unsigned int line_number = 1; std::getline(file, line);
+       ++line_number) {
+    std::istringstream fields(line.substr(0, line.find('#')));
+    string variant;
+    if (!(fields >> variant)) {
+      continue;
+    }
+    const string location = "line " + to_string(line_number) +
+                            " of charge-collection file '" + file_name + "'";
+
+    string id, dead_layer, transition, efficiency;
+    if (!(fields >> id >> dead_layer)) {
+      throw runtime_error("Expected 'variant ID dead_layer [transition "
+                          "[efficiency]]' in " +
+                          location + ".");
+    }
+    Layer layer;
+    layer.dead_layer = ParseNumber(dead_layer, location);
+    if (fields >> transition) {
+      layer.transition = ParseNumber(transition, location);
+      if (fields >> efficiency) {
+        layer.efficiency = ParseNumber(efficiency, location);
+      }
+    }
+    if (layer.dead_layer < 0. || layer.transition < 0. ||
+        layer.efficiency < 0. || layer.efficiency > 1.) {
+      throw runtime_error("Negative thickness or efficiency outside [0, 1] "
+                          "in " +
+                          location + ".");
+    }
+    layer.dead_layer *= mm;
+    layer.transition *= mm;
+
+    if (!std::all_of(variant.begin(), variant.end(), [](const char c) {
+          return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        })) {
+      throw runtime_error("Invalid variant name '" + variant + "' in " +
+                          location + ".");
+    }
+    const auto existing = std::find(variants.begin(), variants.end(), variant);
+    const size_t variant_index =
+        static_cast<size_t>(existing - variants.begin());
+    if (existing == variants.end()) {
+      variants.push_back(variant);
+    }
+
+    if (id == "*") {
+      listed_default_layers[variant_index] = layer;
+      continue;
+    }
+    // The same check of the detector ID as in the Digitizer.
+    size_t end = 0;
+    unsigned long detector_id = 0;
+    try {
+      detector_id = std::stoul(id, &end);
+    } catch (const std::exception &) {
+      end = 0;
+    }
+    if (end != id.size() || !std::isdigit(static_cast<unsigned char>(id[0])) ||
+        detector_id > static_cast<unsigned long>(
+                          std::numeric_limits<int>::max())) {
+      throw runtime_error("Invalid detector ID '" + id + "' in " + location +
+                          ".");
+    }
+    listed_layers[{detector_id, variant_index}] = layer;
+  }
+  if (variants.empty()) {
+    throw runtime_error("No variant in charge-collection file '" + file_name +
+                        "'.");
+  }
+
+  // As for the digitizer, the defaults may be given anywhere in the file.
+  default_layers.resize(variants.size());
+  for (const auto &[variant, layer] : listed_default_layers) {
+    default_layers[variant] = layer;
+  }
+  for (const auto &[key, layer] : listed_layers) {
+    const auto &[detector_id, variant] = key;
+    if (detector_id >= layers.size()) {
+      layers.resize(detector_id + 1, default_layers);
+    }
+    layers[detector_id][variant] = layer;
+  }
+}
+
+void ChargeCollection::Collect(const size_t detector_id, const double depth,
+                               const double energy, double *collected) const {
+  const vector<Layer> &detector_layers =
+      detector_id < layers.size() ? layers[detector_id] : default_layers;
+  for (size_t variant = 0; variant < variants.size(); ++variant) {
+    collected[variant] = energy * detector_layers[variant].Efficiency(depth);
+  }
+}
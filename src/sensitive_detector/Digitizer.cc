@@ -0,0 +1,185 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+using std::runtime_error;
+using std::to_string;
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include "Digitizer.hh"
+
+namespace {
+
+/**
+ * \brief Ratio of the standard deviation to the full width at half maximum
+ * of a normal distribution, 1/(2 sqrt(2 ln 2))
+ */
+constexpr double fwhm_to_sigma = 0.42466090014400953;
+
+} // namespace
+
+Digitizer::Digitizer(const string &_calibration_file)
+    : calibration_file(_calibration_file) {
+  std::ifstream file(calibration_file);
+  if (!file) {
+    throw runtime_error("Could not open calibration file '" +
+                        calibration_file + "'.");
+  }
+
+  std::map<size_t, Channel> channels;
+  string line;
+  for (unsigned int line_number = 1; std::getline(file, line);
+       ++line_number) {
+    std::istringstream fields(line.substr(0, line.find('#')));
+    string id;
+    if (!(fields >> id)) {
+      continue;
+    }
+    const string location = "line " + to_string(line_number) +
+                            " of calibration file '" + calibration_file + "'";
+
+    Channel channel;
+    string dead;
+    if (fields >> dead && dead == "dead") {
+      channel.gain = 0.;
+    } else {
+      fields.clear();
+      fields.str(line.substr(0, line.find('#')));
+      fields >> id;
+      if (!(fields >> channel.a >> channel.b >> channel.c >>
+            channel.threshold)) {
+        throw runtime_error("Expected 'a b c threshold [gain]' or 'dead' "
+                            "after the detector ID in " +
+                            location + ".");
+      }
+      string gain;
+      channel.gain = 1.;
+      if (fields >> gain) {
+        size_t end = 0;
+        try {
+          channel.gain = std::stod(gain, &end);
+        } catch (const std::exception &) {
+          end = 0;
+        }
+        if (end != gain.size()) {
+          throw runtime_error("Invalid gain '" + gain + "' in " + location +
+                              ".");
+        }
+      }
+      channel.a *= keV * keV;
+      channel.b *= keV;
+      channel.threshold *= keV;
+    }
+
+    if (id == "*") {
+      default_channel = channel;
+      continue;
+    }
+    // Detector IDs are G4int. Signs are rejected, since std::stoul() would
+    // wrap a negative ID around to a huge one.
+    size_t end = 0;
+    unsigned long detector_id = 0;
+    try {
+      detector_id = std::stoul(id, &end);
+    } catch (const std::exception &) {
+      end = 0;
+    }
+    if (end != id.size() || !std::isdigit(static_cast<unsigned char>(id[0])) ||
+        detector_id > static_cast<unsigned long>(
+                          std::numeric_limits<int>::max())) {
+      throw runtime_error("Invalid detector ID '" + id + "' in " + location +
+                          ".");
+    }
+    channels[detector_id] = channel;
+  }
+
+  // Detectors that are not listed use the default channel, which may be
+  // given anywhere in the file.
+  if (!channels.empty()) {
+    Resize(channels.rbegin()->first + 1);
+  }
+  for (const auto &[detector_id, channel] : channels) {
+    a[detector_id] = channel.a;
+    b[detector_id] = channel.b;
+    c[detector_id] = channel.c;
+    thresholds[detector_id] = channel.threshold;
+    gains[detector_id] = channel.gain;
+  }
+}
+
+void Digitizer::Resize(const size_t n_detectors) {
+  a.resize(n_detectors, default_channel.a);
+  b.resize(n_detectors, default_channel.b);
+  c.resize(n_detectors, default_channel.c);
+  thresholds.resize(n_detectors, default_channel.threshold);
+  gains.resize(n_detectors, default_channel.gain);
+}
+
+void Digitizer::DrawNormals(const size_t n, CLHEP::HepRandomEngine &engine) {
+  // Box-Muller transform of pairs of uniform random numbers, which are drawn
+  // from the engine in a single call.
+  const size_t n_pairs = (n + 1) / 2;
+  uniforms.resize(2 * n_pairs);
+  normals.resize(2 * n_pairs);
+  engine.flatArray(static_cast<int>(uniforms.size()), uniforms.data());
+  for (size_t i = 0; i < n_pairs; ++i) {
+    // Depending on the engine, flat() may return 0.
+    const double radius = std::sqrt(
+        -2. * std::log(std::max(uniforms[2 * i],
+                                std::numeric_limits<double>::min())));
+    const double angle = twopi * uniforms[2 * i + 1];
+    normals[2 * i] = radius * std::cos(angle);
+    normals[2 * i + 1] = radius * std::sin(angle);
+  }
+}
+
+void Digitizer::Digitize(const vector<double> &energies,
+                         vector<double> &digitized,
+                         CLHEP::HepRandomEngine *engine) {
+  const size_t n = energies.size();
+  if (n > a.size()) {
+    Resize(n);
+  }
+  DrawNormals(n, engine != nullptr ? *engine : *G4Random::getTheEngine());
+  digitized.resize(n);
+
+  const double *energy = energies.data();
+  const double *normal = normals.data();
+  double *response = digitized.data();
+  for (size_t i = 0; i < n; ++i) {
+    const double variance =
+        std::max(a[i] + energy[i] * (b[i] + c[i] * energy[i]), 0.);
+    const double smeared =
+        energy[i] + fwhm_to_sigma * std::sqrt(variance) * normal[i];
+    response[i] = energy[i] > 0. && smeared >= thresholds[i] && smeared > 0.
+                      ? gains[i] * smeared
+                      : 0.;
+  }
+}
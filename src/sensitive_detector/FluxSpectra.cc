@@ -0,0 +1,142 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "G4AffineTransform.hh"
+#include "G4NavigationHistory.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4ParticleTable.hh"
+#include "G4VSolid.hh"
+#include "G4VTouchable.hh"
+
+#include "FluxSpectra.hh"
+
+FluxSpectra::FluxSpectra()
+    : energy_axis({"energy", 0, 0., 0.}), angle_axis({"angle", 0, 0., 0.}),
+      track_length(false), batch_size(1), batch_events(0), n_batches(0) {}
+
+void FluxSpectra::Reset(const string &_prefix,
+                        const Histogram::Axis &_energy_axis,
+                        const Histogram::Axis &_angle_axis,
+                        const bool _track_length, const size_t _batch_size) {
+  prefix = _prefix;
+  energy_axis = _energy_axis;
+  angle_axis = _angle_axis;
+  track_length = _track_length;
+  batch_size = _batch_size;
+  batch_events = 0;
+  n_batches = 0;
+  histograms.clear();
+  spectrum_indices.clear();
+  batch_sums.clear();
+}
+
+size_t FluxSpectra::SpectrumIndex(const int detector_id,
+                                  const int particle_id) {
+  const auto key = std::make_pair(detector_id, particle_id);
+  const auto index = spectrum_indices.find(key);
+  if (index != spectrum_indices.end()) {
+    return index->second;
+  }
+
+  const G4ParticleDefinition *particle =
+      G4ParticleTable::GetParticleTable()->FindParticle(particle_id);
+  const string name = prefix + std::to_string(detector_id) + "_" +
+                      (particle != nullptr ? string(particle->GetParticleName())
+                                           : std::to_string(particle_id));
+  if (track_length) {
+    histograms.emplace_back(name, vector<Histogram::Axis>{energy_axis});
+    // A spectrum that is created during the run has to contain the
+    // completed batches as well, in which it was empty.
+    for (size_t batch = 0; batch < n_batches; ++batch) {
+      for (size_t cell = 0; cell < histograms.back().GetNumberOfCells();
+           ++cell) {
+        histograms.back().FillCell(cell, 0.);
+      }
+    }
+    batch_sums.emplace_back(histograms.back().GetNumberOfCells(), 0.);
+  } else {
+    histograms.emplace_back(name,
+                            vector<Histogram::Axis>{energy_axis, angle_axis});
+  }
+  spectrum_indices.emplace(key, histograms.size() - 1);
+  return histograms.size() - 1;
+}
+
+void FluxSpectra::FillEntry(const int detector_id, const int particle_id,
+                            const double energy, const double angle,
+                            const double weight) {
+  histograms[SpectrumIndex(detector_id, particle_id)].Fill(energy, angle,
+                                                           weight);
+}
+
+void FluxSpectra::FillStep(const int detector_id, const int particle_id,
+                           const double energy, const double length,
+                           const double weight) {
+  batch_sums[SpectrumIndex(detector_id, particle_id)]
+            [energy_axis.Bin(energy)] += length * weight;
+}
+
+void FluxSpectra::EndOfEvent() {
+  if (track_length && ++batch_events == batch_size) {
+    FinishBatch();
+  }
+}
+
+void FluxSpectra::Finish(vector<Histogram> &output,
+                         map<string, uint64_t> &batches) {
+  // The last batch of a thread is usually incomplete, which is neglected in
+  // the uncertainty estimate.
+  if (track_length && batch_events > 0) {
+    FinishBatch();
+  }
+  if (track_length) {
+    batches[prefix] += n_batches;
+  }
+  output.insert(output.end(), histograms.begin(), histograms.end());
+  histograms.clear();
+  spectrum_indices.clear();
+  batch_sums.clear();
+}
+
+void FluxSpectra::FinishBatch() {
+  for (size_t index = 0; index < histograms.size(); ++index) {
+    for (size_t cell = 0; cell < batch_sums[index].size(); ++cell) {
+      histograms[index].FillCell(cell, batch_sums[index][cell]);
+      batch_sums[index][cell] = 0.;
+    }
+  }
+  batch_events = 0;
+  ++n_batches;
+}
+
+double FluxSpectra::IncidenceAngle(const G4StepPoint *point) {
+  const G4VTouchable *touchable = point->GetTouchable();
+  const G4AffineTransform &global_to_local =
+      touchable->GetHistory()->GetTopTransform();
+  const G4ThreeVector normal = touchable->GetSolid()->SurfaceNormal(
+      global_to_local.TransformPoint(point->GetPosition()));
+  const G4ThreeVector direction =
+      global_to_local.TransformAxis(point->GetMomentumDirection());
+
+  // The surface normal points outwards.
+  return std::acos(std::clamp(-direction.dot(normal), -1., 1.));
+}
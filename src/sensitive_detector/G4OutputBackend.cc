@@ -0,0 +1,122 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <filesystem>
+
+#include "G4Threading.hh"
+
+#include "G4OutputBackend.hh"
+#include "Manifest.hh"
+
+void G4OutputBackend::OpenFile(const string &file_name) {
+  // The command below merges the output created by different threads into a
+  // single file. This does not work for some file formats. Geant4 will print a
+  // warning during execution and refuse to merge the files. In principle, one
+  // could use SetNtupleMerging only if OUTPUT_FORMAT="root". However, it was
+  // chosen to keep the warning message here so that a user who has been working
+  // with OUTPUT_FORMAT="root" and switches to OUTPUT_FORMAT="csv" will not
+  // wonder why the files are not merged any more.
+  //
+  // Merging can be switched off with /analysis/merge, for example to avoid
+  // that the master thread has to receive the ntuples of all workers.
+  analysisManager->SetNtupleMerging(merge_threads);
+  analysisManager->OpenFile(file_name);
+}
+
+int G4OutputBackend::CreateNtuple(const string &name, const string &title) {
+  const int ntuple = analysisManager->CreateNtuple(name, title);
+  if (ntuple >= 0) {
+    precisions.resize(std::max(precisions.size(), size_t(ntuple) + 1));
+    ntuple_names.resize(precisions.size());
+    ntuple_names[ntuple] = name;
+  }
+  return ntuple;
+}
+
+int G4OutputBackend::CreateNtupleIColumn(const string &name) {
+  if (!precisions.empty()) {
+    precisions.back().push_back(ColumnPrecision());
+  }
+  return analysisManager->CreateNtupleIColumn(name);
+}
+
+int G4OutputBackend::CreateNtupleLColumn(const string &name) {
+  if (!precisions.empty()) {
+    precisions.back().push_back(ColumnPrecision());
+  }
+  return analysisManager->CreateNtupleDColumn(name);
+}
+
+int G4OutputBackend::CreateNtupleDColumn(const string &name,
+                                         const ColumnPrecision precision) {
+  if (!precisions.empty()) {
+    precisions.back().push_back(precision);
+  }
+  if (precision.type == ColumnPrecision::float64) {
+    return analysisManager->CreateNtupleDColumn(name);
+  }
+  return analysisManager->CreateNtupleFColumn(name);
+}
+
+bool G4OutputBackend::FillNtupleDColumn(const int ntuple, const int column,
+                                        const double value) {
+  if (ntuple < 0 || static_cast<size_t>(ntuple) >= precisions.size() ||
+      column < 0 ||
+      static_cast<size_t>(column) >= precisions[ntuple].size()) {
+    return analysisManager->FillNtupleDColumn(ntuple, column, value);
+  }
+  const auto &precision = precisions[ntuple][column];
+  switch (precision.type) {
+  case ColumnPrecision::float32:
+    return analysisManager->FillNtupleFColumn(ntuple, column,
+                                              static_cast<float>(value));
+  case ColumnPrecision::quantized:
+    return analysisManager->FillNtupleFColumn(
+        ntuple, column,
+        static_cast<float>(static_cast<double>(Quantize(value, precision.lsb)) *
+                           precision.lsb));
+  default:
+    return analysisManager->FillNtupleDColumn(ntuple, column, value);
+  }
+}
+
+vector<string> G4OutputBackend::GetFileNames() const {
+  const string file_name = GetFileName();
+  if (merge_threads || G4Threading::IsMasterThread()) {
+    return {file_name};
+  }
+
+  // File names of the ntuples in the worker threads, following the
+  // conventions of Geant4: each ntuple is written to a separate file in the
+  // CSV format.
+  const int thread_id = G4Threading::G4GetThreadId();
+  if (std::filesystem::path(file_name).extension() != ".csv") {
+    return {manifest::ThreadFileName(file_name, thread_id)};
+  }
+  vector<string> file_names;
+  for (const auto &ntuple_name : ntuple_names) {
+    std::filesystem::path ntuple_file(file_name);
+    ntuple_file.replace_filename(ntuple_file.stem().string() + "_nt_" +
+                                 ntuple_name + ".csv");
+    file_names.push_back(
+        manifest::ThreadFileName(ntuple_file.string(), thread_id));
+  }
+  return file_names;
+}
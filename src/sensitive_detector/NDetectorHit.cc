@@ -17,6 +17,7 @@
     Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
 */
 
+#include "MemoryMonitor.hh"
 #include "NDetectorHit.hh"
 
 #include "G4Circle.hh"
@@ -29,10 +30,17 @@
 
 G4ThreadLocal G4Allocator<NDetectorHit> *NDetectorHitAllocator = 0;
 
-NDetectorHit::NDetectorHit() : G4VHit(), fDetectorID(0) {}
+[[maybe_unused]] static const bool n_detector_hit_allocator_registered =
+    MemoryMonitor::RegisterAllocator("NDetectorHit", []() -> size_t {
+      return NDetectorHitAllocator ? NDetectorHitAllocator->GetAllocatedSize()
+                                   : 0;
+    });
+
+NDetectorHit::NDetectorHit() : G4VHit(), fDetectorID(0), fWeight(1.) {}
 
 NDetectorHit::NDetectorHit(const NDetectorHit &right) : G4VHit() {
   fDetectorID = right.fDetectorID;
+  fWeight = right.fWeight;
 }
 
 G4bool NDetectorHit::operator==(const NDetectorHit &right) const {
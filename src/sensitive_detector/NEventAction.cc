@@ -36,8 +36,12 @@ using std::setw;
 
 #include "G4RunManager.hh"
 
+#include "MemoryMonitor.hh"
+#include "NDetectorHit.hh"
 #include "NEventAction.hh"
 #include "NRunAction.hh"
+#include "PerfCounters.hh"
+#include "Tracer.hh"
 
 void NEventAction::BeginOfEventAction(const G4Event *event) {
 
@@ -53,5 +57,53 @@ void NEventAction::BeginOfEventAction(const G4Event *event) {
     G4cout << put_time(localtime(&current_time_t), "%F %T") << " ( "
            << scientific << setprecision(8) << delta_t.count()
            << " s since start ) : Event #" << setw(10) << eventID << G4endl;
+
+    MemoryMonitor::UpdateThread();
+  }
+
+  // The tracking phase is ended at the beginning of EndOfEventAction().
+  Tracer::Begin("Tracking");
+  PerfCounters::Begin(PerfCounters::tracking);
+}
+
+bool NEventAction::IsTriggered(const G4Event *event) {
+  if (!analysis_manager->HasTrigger()) {
+    return true;
+  }
+
+  TraceScope trace("Trigger");
+
+  // The vector is reused to avoid an allocation per event.
+  detector_energies.clear();
+  G4HCofThisEvent *hcs = event->GetHCofThisEvent();
+  for (int n_hc = 0; n_hc < hcs->GetNumberOfCollections(); ++n_hc) {
+    G4VHitsCollection *hc = hcs->GetHC(n_hc);
+    if (hc->GetSize() > 0) {
+      const size_t detector_id = static_cast<size_t>(
+          static_cast<NDetectorHit *>(hc->GetHit(0))->GetDetectorID());
+      if (detector_id >= detector_energies.size()) {
+        detector_energies.resize(detector_id + 1, 0.);
+      }
+      detector_energies[detector_id] += DetectorEnergy(hc);
+    }
   }
+
+  return analysis_manager->IsTriggered(detector_energies);
+}
+
+double NEventAction::DetectorEnergy(G4VHitsCollection *hc) const {
+  double edep = 0.;
+  for (size_t i = 0; i < hc->GetSize(); ++i) {
+    edep += static_cast<NDetectorHit *>(hc->GetHit(i))->GetEdep();
+  }
+  return edep;
+}
+
+bool NEventAction::IsTriggered(const vector<double> &energies) const {
+  if (!analysis_manager->HasTrigger()) {
+    return true;
+  }
+
+  TraceScope trace("Trigger");
+  return analysis_manager->IsTriggered(energies);
 }
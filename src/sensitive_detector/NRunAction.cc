@@ -26,7 +26,11 @@ using std::time;
 
 using std::put_time;
 
+#include "LiveMetrics.hh"
+#include "MemoryMonitor.hh"
 #include "NRunAction.hh"
+#include "PerfCounters.hh"
+#include "Tracer.hh"
 
 #include "G4Run.hh"
 #include "G4RunManager.hh"
@@ -36,12 +40,40 @@ NRunAction::NRunAction(const string _output_file_name, AnalysisManager *ana_man)
     : G4UserRunAction(), output_file_name(_output_file_name),
       analysis_manager(ana_man), start_time(system_clock::now()) {}
 
-void NRunAction::BeginOfRunAction(const G4Run *) {
+void NRunAction::BeginOfRunAction(const G4Run *run) {
+  TraceScope trace("BeginOfRunAction");
+
+  if (IsMaster()) {
+    LiveMetrics::BeginOfRun(run->GetRunID(),
+                            run->GetNumberOfEventToBeProcessed());
+    if (MemoryMonitor::ReportAtRunBoundaries()) {
+      MemoryMonitor::Report("beginning of run " + to_string(run->GetRunID()));
+    }
+  }
+
   const time_t start_time_t = system_clock::to_time_t(start_time);
   G4cout << "Run started on "
          << put_time(localtime(&start_time_t), "%F %T (thread ID ")
          << G4Threading::G4GetThreadId() << ")" << G4endl;
-  analysis_manager->Book(output_file_name);
+  analysis_manager->Book(output_file_name, run->GetRunID());
 }
 
-void NRunAction::EndOfRunAction(const G4Run *) { analysis_manager->Save(); }
+void NRunAction::EndOfRunAction(const G4Run *run) {
+  {
+    TraceScope trace("EndOfRunAction");
+    analysis_manager->Save();
+  }
+  MemoryMonitor::UpdateThread();
+
+  // In multithreaded mode, the master thread ends its run after all workers
+  // have finished, so all trace buffers and thread statistics are complete at
+  // this point.
+  if (IsMaster()) {
+    LiveMetrics::EndOfRun();
+    Tracer::Dump(run->GetRunID());
+    PerfCounters::Report(run->GetRunID());
+    if (MemoryMonitor::ReportAtRunBoundaries()) {
+      MemoryMonitor::Report("end of run " + to_string(run->GetRunID()));
+    }
+  }
+}
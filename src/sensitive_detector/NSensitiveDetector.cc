@@ -17,18 +17,44 @@
     Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
 */
 
+#include "G4AffineTransform.hh"
 #include "G4HCofThisEvent.hh"
+#include "G4NavigationHistory.hh"
 #include "G4SDManager.hh"
 #include "G4Step.hh"
 #include "G4ThreeVector.hh"
+#include "G4VSolid.hh"
+#include "G4VTouchable.hh"
 #include "G4ios.hh"
 
+#include "MemoryMonitor.hh"
 #include "NSensitiveDetector.hh"
 
 NSensitiveDetector::NSensitiveDetector(const string &name,
                                        const string &DetectorHitsCollectionName)
-    : G4VSensitiveDetector(name) {
+    : G4VSensitiveDetector(name), fHitsCollectionID(-1) {
   collectionName.insert(DetectorHitsCollectionName);
 }
 
-void NSensitiveDetector::EndOfEvent(G4HCofThisEvent *) {}
\ No newline at end of file
+void NSensitiveDetector::EndOfEvent(G4HCofThisEvent *hitCollection) {
+  if (fHitsCollectionID < 0) {
+    fHitsCollectionID = GetCollectionID(0);
+  }
+  MemoryMonitor::RecordHitsCollectionSize(
+      hitCollection->GetHC(fHitsCollectionID)->GetSize());
+}
+
+G4ThreeVector NSensitiveDetector::LocalPosition(const G4Step *step) {
+  const G4ThreeVector center = 0.5 * (step->GetPreStepPoint()->GetPosition() +
+                                      step->GetPostStepPoint()->GetPosition());
+  return step->GetPreStepPoint()
+      ->GetTouchable()
+      ->GetHistory()
+      ->GetTopTransform()
+      .TransformPoint(center);
+}
+
+double NSensitiveDetector::Depth(const G4Step *step) {
+  return step->GetPreStepPoint()->GetTouchable()->GetSolid()->DistanceToOut(
+      LocalPosition(step));
+}
@@ -0,0 +1,241 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+using std::make_unique;
+using std::runtime_error;
+
+#include "G4EmCalculator.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4Material.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4TransportationManager.hh"
+#include "G4VProcess.hh"
+
+#include "NextEventEstimator.hh"
+
+namespace {
+
+/**
+ * \brief Logarithmic energy grid of the tables of attenuation coefficients
+ */
+constexpr double grid_min = 1. * keV;
+constexpr double grid_max = 100. * MeV;
+constexpr size_t grid_points_per_decade = 50;
+constexpr size_t grid_points = 5 * grid_points_per_decade + 1;
+
+/**
+ * \brief Maximum number of volumes along a ray, to stop in case the
+ * navigator gets stuck
+ */
+constexpr size_t max_ray_steps = 100000;
+
+} // namespace
+
+NextEventEstimator::NextEventEstimator(const vector<PointDetector> &_detectors,
+                                       const vector<string> &volume_names,
+                                       const Histogram::Axis &energy_axis)
+    : detectors(_detectors) {
+  if (volume_names.empty()) {
+    throw runtime_error("The point detectors have no volumes.");
+  }
+  for (const auto &volume_name : volume_names) {
+    const G4LogicalVolume *volume =
+        G4LogicalVolumeStore::GetInstance()->GetVolume(volume_name, false);
+    if (volume == nullptr) {
+      throw runtime_error("The volume '" + volume_name +
+                          "' of the point detectors does not exist.");
+    }
+    volumes.insert(volume);
+  }
+  for (const auto &detector : detectors) {
+    histograms.emplace_back("nee_" + detector.name,
+                            vector<Histogram::Axis>{energy_axis});
+  }
+}
+
+NextEventEstimator::~NextEventEstimator() = default;
+
+double NextEventEstimator::ComptonEnergy(const double energy,
+                                         const double cos_theta) {
+  return energy / (1. + energy / electron_mass_c2 * (1. - cos_theta));
+}
+
+double NextEventEstimator::ComptonProbability(const double energy,
+                                              const double cos_theta) {
+  const double k = energy / electron_mass_c2;
+  const double ratio = 1. / (1. + k * (1. - cos_theta));
+  const double differential =
+      0.5 * ratio * ratio *
+      (ratio + 1. / ratio - (1. - cos_theta * cos_theta));
+
+  // Total cross section in units of 2 pi r_e^2. At low energies, the exact
+  // expression suffers from cancellation, so the expansion around the
+  // Thomson cross section is used.
+  double total;
+  if (k < 1e-3) {
+    total = 4. / 3. * (1. - 2. * k + 5.2 * k * k);
+  } else {
+    const double log_term = std::log(1. + 2. * k);
+    total = (1. + k) / (k * k) *
+                (2. * (1. + k) / (1. + 2. * k) - log_term / k) +
+            log_term / (2. * k) -
+            (1. + 3. * k) / ((1. + 2. * k) * (1. + 2. * k));
+  }
+  return differential / (twopi * total);
+}
+
+void NextEventEstimator::Score(const G4Step *step) {
+  const G4StepPoint *post_step_point = step->GetPostStepPoint();
+  const G4VProcess *process = post_step_point->GetProcessDefinedStep();
+  if (process == nullptr || process->GetProcessName() != "compt") {
+    return;
+  }
+  const G4StepPoint *pre_step_point = step->GetPreStepPoint();
+  const G4VTouchable *touchable = pre_step_point->GetTouchable();
+  if (volumes.count(touchable->GetVolume()->GetLogicalVolume()) == 0) {
+    return;
+  }
+
+  const double energy = pre_step_point->GetKineticEnergy();
+  const double weight = pre_step_point->GetWeight();
+  const G4ThreeVector direction = pre_step_point->GetMomentumDirection();
+  const G4ThreeVector position = post_step_point->GetPosition();
+  for (size_t detector = 0; detector < detectors.size(); ++detector) {
+    const G4ThreeVector to_detector = detectors[detector].position - position;
+    const double distance2 = to_detector.mag2();
+    if (distance2 == 0.) {
+      continue;
+    }
+    const double cos_theta = direction.dot(to_detector) / std::sqrt(distance2);
+    const double scattered_energy = ComptonEnergy(energy, cos_theta);
+    histograms[detector].Fill(
+        scattered_energy,
+        weight * ComptonProbability(energy, cos_theta) *
+            Attenuation(Ray(touchable, detector), scattered_energy) /
+            distance2);
+  }
+}
+
+const vector<NextEventEstimator::Segment> &
+NextEventEstimator::Ray(const G4VTouchable *touchable, const size_t detector) {
+  const pair<const G4VPhysicalVolume *, int> key{
+      touchable->GetVolume(), touchable->GetReplicaNumber()};
+  auto volume_rays = rays.find(key);
+  if (volume_rays == rays.end()) {
+    vector<vector<Segment>> new_rays;
+    for (const auto &point_detector : detectors) {
+      new_rays.push_back(
+          TraceRay(touchable->GetTranslation(), point_detector.position));
+    }
+    volume_rays = rays.emplace(key, std::move(new_rays)).first;
+  }
+  return volume_rays->second[detector];
+}
+
+vector<NextEventEstimator::Segment>
+NextEventEstimator::TraceRay(const G4ThreeVector &start,
+                             const G4ThreeVector &end) {
+  // The navigator of the tracking must not be disturbed, so the rays are
+  // traced with a separate one.
+  if (navigator == nullptr) {
+    navigator = make_unique<G4Navigator>();
+    navigator->SetWorldVolume(
+        G4TransportationManager::GetTransportationManager()
+            ->GetNavigatorForTracking()
+            ->GetWorldVolume());
+  }
+
+  vector<Segment> ray;
+  G4ThreeVector point = start;
+  G4ThreeVector direction = (end - start).unit();
+  double remaining = (end - start).mag();
+  const G4VPhysicalVolume *volume =
+      navigator->LocateGlobalPointAndSetup(point, &direction, false, false);
+  // Without a volume, the ray has left the world, where there is no
+  // material.
+  for (size_t n_steps = 0;
+       volume != nullptr && remaining > 0. && n_steps < max_ray_steps;
+       ++n_steps) {
+    double safety;
+    const double length =
+        std::min(navigator->ComputeStep(point, direction, remaining, safety),
+                 remaining);
+    const size_t material_index =
+        volume->GetLogicalVolume()->GetMaterial()->GetIndex();
+    if (!ray.empty() && ray.back().material_index == material_index) {
+      ray.back().length += length;
+    } else {
+      ray.push_back(Segment{material_index, length});
+    }
+    point += length * direction;
+    remaining -= length;
+    navigator->SetGeometricallyLimitedStep();
+    volume = navigator->LocateGlobalPointAndSetup(point, &direction, true,
+                                                  false);
+  }
+  return ray;
+}
+
+double NextEventEstimator::Attenuation(const vector<Segment> &ray,
+                                       const double energy) {
+  double exponent = 0.;
+  for (const auto &segment : ray) {
+    exponent +=
+        AttenuationCoefficient(segment.material_index, energy) * segment.length;
+  }
+  return std::exp(-exponent);
+}
+
+double NextEventEstimator::AttenuationCoefficient(const size_t material_index,
+                                                  const double energy) {
+  if (log_attenuation_coefficients.size() <= material_index) {
+    log_attenuation_coefficients.resize(material_index + 1);
+  }
+  auto &table = log_attenuation_coefficients[material_index];
+  if (table.empty()) {
+    G4EmCalculator calculator;
+    const G4Material *material =
+        (*G4Material::GetMaterialTable())[material_index];
+    table.resize(grid_points);
+    for (size_t i = 0; i < grid_points; ++i) {
+      const double grid_energy =
+          grid_min * std::pow(10., static_cast<double>(i) /
+                                       static_cast<double>(
+                                           grid_points_per_decade));
+      // Limit the coefficient of vacuum-like materials, whose attenuation
+      // length is infinite, to keep the logarithm finite.
+      table[i] = std::log(std::max(
+          1. / calculator.ComputeGammaAttenuationLength(grid_energy, material),
+          1e-300 / mm));
+    }
+  }
+
+  const double position = std::clamp(
+      std::log10(energy / grid_min) * grid_points_per_decade, 0.,
+      static_cast<double>(grid_points - 1));
+  const size_t i = std::min(static_cast<size_t>(position), grid_points - 2);
+  const double fraction = position - static_cast<double>(i);
+  return std::exp(table[i] + fraction * (table[i + 1] - table[i]));
+}
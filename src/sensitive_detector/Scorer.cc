@@ -0,0 +1,190 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <stdexcept>
+
+using std::runtime_error;
+
+#include "G4EventManager.hh"
+#include "G4SystemOfUnits.hh"
+
+#include "NSensitiveDetector.hh"
+#include "Scorer.hh"
+#include "StepFormat.hh"
+
+Scorer::Scorer(const string &volume_name, const Kind _kind,
+               const unsigned int _detector_id)
+    : G4VSensitiveDetector(volume_name + "_" + KindNames()[_kind]),
+      kind(_kind), detector_id(_detector_id), event_energy(0.),
+      event_weighted_energy(0.) {}
+
+const vector<string> &Scorer::KindNames() {
+  static const vector<string> names{"energy", "flux", "track_length",
+                                    "step_points"};
+  return names;
+}
+
+Scorer::Kind Scorer::KindFromName(const string &name) {
+  const auto &names = KindNames();
+  for (size_t index = 0; index < names.size(); ++index) {
+    if (names[index] == name) {
+      return static_cast<Kind>(index);
+    }
+  }
+  throw runtime_error("Unknown scorer '" + name + "'.");
+}
+
+void Scorer::Initialize(G4HCofThisEvent *) {
+  event_energy = 0.;
+  event_weighted_energy = 0.;
+}
+
+G4bool Scorer::ProcessHits(G4Step *step, G4TouchableHistory *) {
+  ScorerSet &scorers = ScorerSet::ForThread();
+  if (kind == step_points ? !scorers.RecordsSteps() : !scorers.HasSpectra()) {
+    return false;
+  }
+
+  const G4Track *track = step->GetTrack();
+  const G4StepPoint *pre_step_point = step->GetPreStepPoint();
+  switch (kind) {
+  case energy:
+    event_energy += step->GetTotalEnergyDeposit();
+    event_weighted_energy += step->GetTotalEnergyDeposit() * track->GetWeight();
+    break;
+  case flux:
+    if (pre_step_point->GetStepStatus() != fGeomBoundary) {
+      return false;
+    }
+    scorers.GetFlux().FillEntry(
+        detector_id, track->GetDynamicParticle()->GetPDGcode(),
+        pre_step_point->GetKineticEnergy(),
+        FluxSpectra::IncidenceAngle(pre_step_point), track->GetWeight());
+    break;
+  case track_length:
+    scorers.GetTrackLength().FillStep(
+        detector_id, track->GetDynamicParticle()->GetPDGcode(),
+        pre_step_point->GetKineticEnergy(), step->GetStepLength(),
+        track->GetWeight());
+    break;
+  case step_points: {
+    if (step->GetTotalEnergyDeposit() == 0.) {
+      return false;
+    }
+    const G4ThreeVector position = NSensitiveDetector::LocalPosition(step);
+    const double coordinates[3] = {position.x(), position.y(), position.z()};
+    scorers.GetSteps().Add(detector_id, coordinates,
+                           NSensitiveDetector::Depth(step),
+                           step->GetTotalEnergyDeposit(),
+                           pre_step_point->GetGlobalTime());
+    break;
+  }
+  }
+
+  return true;
+}
+
+void Scorer::EndOfEvent(G4HCofThisEvent *) {
+  ScorerSet &scorers = ScorerSet::ForThread();
+
+  // The spectrum is filled with the mean weight of the depositions, weighted
+  // by their energy, like the column 'weight' of the 'edep' and 'event'
+  // sensitive detectors.
+  if (kind == energy && event_energy > 0. && scorers.HasSpectra()) {
+    scorers.FillEnergy(detector_id, event_energy,
+                       event_weighted_energy / event_energy);
+  }
+  event_energy = 0.;
+  event_weighted_energy = 0.;
+
+  scorers.EndOfEvent(G4EventManager::GetEventManager()
+                         ->GetConstCurrentEvent()
+                         ->GetEventID());
+}
+
+ScorerSet::ScorerSet()
+    : energy_axis({"energy", 0, 0., 0.}), run_id(0), global_event_id_offset(0),
+      last_event_id(-1) {}
+
+ScorerSet &ScorerSet::ForThread() {
+  // Like the hit allocators of Geant4, the instance of a thread is never
+  // deleted.
+  static G4ThreadLocal ScorerSet *scorers = nullptr;
+  if (scorers == nullptr) {
+    scorers = new ScorerSet();
+  }
+  return *scorers;
+}
+
+void ScorerSet::BeginOfRun(const Histogram::Axis &_energy_axis,
+                           const size_t angle_bins, const size_t batch_size) {
+  energy_axis = _energy_axis;
+  energy_indices.clear();
+  energy_histograms.clear();
+  const Histogram::Axis angle_axis{"angle", angle_bins, 0., 90. * deg};
+  flux.Reset("flux_det", energy_axis, angle_axis, false, batch_size);
+  track_length.Reset("track_length_det", energy_axis, angle_axis, true,
+                     batch_size);
+  step_file_name = "";
+  last_event_id = -1;
+}
+
+void ScorerSet::OpenStepFile(const string &path, const int32_t _run_id,
+                             const int64_t _global_event_id_offset) {
+  steps.Open(path, step_format::default_position_lsb,
+             step_format::default_time_lsb);
+  step_file_name = path;
+  run_id = _run_id;
+  global_event_id_offset = _global_event_id_offset;
+}
+
+void ScorerSet::FillEnergy(const unsigned int detector_id,
+                           const double energy, const double weight) {
+  auto index = energy_indices.find(detector_id);
+  if (index == energy_indices.end()) {
+    energy_histograms.emplace_back("energy_det" + std::to_string(detector_id),
+                                   vector<Histogram::Axis>{energy_axis});
+    index =
+        energy_indices.emplace(detector_id, energy_histograms.size() - 1).first;
+  }
+  energy_histograms[index->second].Fill(energy, weight);
+}
+
+void ScorerSet::EndOfEvent(const int event_id) {
+  if (event_id == last_event_id) {
+    return;
+  }
+  last_event_id = event_id;
+  track_length.EndOfEvent();
+  if (steps.IsOpen()) {
+    // The event ID occupies the lowest bits of the global event ID.
+    steps.FinishEvent(global_event_id_offset | event_id, run_id);
+  }
+}
+
+void ScorerSet::EndOfRun(vector<Histogram> &output,
+                         map<string, uint64_t> &batches) {
+  output.insert(output.end(), energy_histograms.begin(),
+                energy_histograms.end());
+  energy_histograms.clear();
+  energy_indices.clear();
+  flux.Finish(output, batches);
+  track_length.Finish(output, batches);
+  steps.Close();
+}
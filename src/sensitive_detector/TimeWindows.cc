@@ -0,0 +1,82 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+
+#include "TimeWindows.hh"
+
+void TimeWindows::Group(const double length, const size_t max_windows) {
+  n_windows = 0;
+  if (deposits.empty() || max_windows == 0) {
+    return;
+  }
+
+  // The depositions only have to be sorted if there can be more than one
+  // window.
+  if (length > 0.) {
+    std::sort(deposits.begin(), deposits.end(),
+              [](const Deposit &a, const Deposit &b) {
+                return a.time < b.time;
+              });
+  }
+  double first_time = deposits[0].time;
+  size_t max_detector_id = 0;
+  for (const auto &deposit : deposits) {
+    first_time = std::min(first_time, deposit.time);
+    max_detector_id = std::max(max_detector_id, deposit.detector_id);
+  }
+
+  double window_end = 0.;
+  for (const auto &deposit : deposits) {
+    if (n_windows == 0 || (length > 0. && deposit.time >= window_end)) {
+      if (n_windows == max_windows) {
+        break;
+      }
+      if (start_times.size() <= n_windows) {
+        start_times.push_back(0.);
+        energies.emplace_back();
+        weights.emplace_back();
+        collected_energies.emplace_back();
+      }
+      start_times[n_windows] = n_windows == 0 ? first_time : deposit.time;
+      energies[n_windows].assign(max_detector_id + 1, 0.);
+      weights[n_windows].assign(max_detector_id + 1, 0.);
+      collected_energies[n_windows].assign((max_detector_id + 1) * n_variants,
+                                           0.);
+      window_end = start_times[n_windows] + length;
+      ++n_windows;
+    }
+    energies[n_windows - 1][deposit.detector_id] += deposit.energy;
+    weights[n_windows - 1][deposit.detector_id] +=
+        deposit.weight * deposit.energy;
+    for (size_t variant = 0; variant < n_variants; ++variant) {
+      collected_energies[n_windows - 1]
+                        [deposit.detector_id * n_variants + variant] +=
+          deposit_collected[deposit.collected + variant];
+    }
+  }
+
+  for (size_t window = 0; window < n_windows; ++window) {
+    for (size_t id = 0; id <= max_detector_id; ++id) {
+      weights[window][id] = energies[window][id] > 0.
+                                ? weights[window][id] / energies[window][id]
+                                : 1.;
+    }
+  }
+}
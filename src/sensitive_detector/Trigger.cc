@@ -0,0 +1,407 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+using std::runtime_error;
+using std::to_string;
+
+#include "G4SystemOfUnits.hh"
+
+#include "Trigger.hh"
+
+namespace {
+
+using Energies = vector<double>;
+
+struct Node {
+  function<double(const Energies &)> evaluate;
+  bool constant;
+  double value;
+};
+
+Node constant(const double value) {
+  return {[value](const Energies &) { return value; }, true, value};
+}
+
+template <typename Operation>
+Node binary(const Node &left, const Node &right, Operation operation) {
+  if (left.constant && right.constant) {
+    return constant(operation(left.value, right.value));
+  }
+  return {[left = left.evaluate, right = right.evaluate,
+           operation](const Energies &energies) {
+            return operation(left(energies), right(energies));
+          },
+          false, 0.};
+}
+
+template <typename Operation>
+Node unary(const Node &operand, Operation operation) {
+  if (operand.constant) {
+    return constant(operation(operand.value));
+  }
+  return {[operand = operand.evaluate, operation](const Energies &energies) {
+            return operation(operand(energies));
+          },
+          false, 0.};
+}
+
+/**
+ * \brief Recursive-descent parser that translates a trigger expression into
+ * a tree of closures
+ */
+class Parser {
+public:
+  explicit Parser(const string &_expression)
+      : expression(_expression), position(0) {}
+
+  Node parse() {
+    Node node = parse_or();
+    skip_whitespace();
+    if (position != expression.size()) {
+      error("unexpected '" + expression.substr(position, 1) + "'");
+    }
+    return node;
+  }
+
+private:
+  Node parse_or() {
+    Node node = parse_and();
+    while (accept("||")) {
+      const Node right = parse_and();
+      if (node.constant) {
+        node = node.value != 0. ? constant(1.) : unary(right, [](double r) {
+          return static_cast<double>(r != 0.);
+        });
+      } else {
+        node = {[left = node.evaluate,
+                 right = right.evaluate](const Energies &energies) {
+                  return static_cast<double>(left(energies) != 0. ||
+                                             right(energies) != 0.);
+                },
+                false, 0.};
+      }
+    }
+    return node;
+  }
+
+  Node parse_and() {
+    Node node = parse_comparison();
+    while (accept("&&")) {
+      const Node right = parse_comparison();
+      if (node.constant) {
+        node = node.value == 0. ? constant(0.) : unary(right, [](double r) {
+          return static_cast<double>(r != 0.);
+        });
+      } else {
+        node = {[left = node.evaluate,
+                 right = right.evaluate](const Energies &energies) {
+                  return static_cast<double>(left(energies) != 0. &&
+                                             right(energies) != 0.);
+                },
+                false, 0.};
+      }
+    }
+    return node;
+  }
+
+  Node parse_comparison() {
+    const Node left = parse_sum();
+    if (accept("<=")) {
+      return binary(left, parse_sum(), [](double l, double r) {
+        return static_cast<double>(l <= r);
+      });
+    }
+    if (accept(">=")) {
+      return binary(left, parse_sum(), [](double l, double r) {
+        return static_cast<double>(l >= r);
+      });
+    }
+    if (accept("==")) {
+      return binary(left, parse_sum(), [](double l, double r) {
+        return static_cast<double>(l == r);
+      });
+    }
+    if (accept("!=")) {
+      return binary(left, parse_sum(), [](double l, double r) {
+        return static_cast<double>(l != r);
+      });
+    }
+    if (accept("<")) {
+      return binary(left, parse_sum(), [](double l, double r) {
+        return static_cast<double>(l < r);
+      });
+    }
+    if (accept(">")) {
+      return binary(left, parse_sum(), [](double l, double r) {
+        return static_cast<double>(l > r);
+      });
+    }
+    return left;
+  }
+
+  Node parse_sum() {
+    Node node = parse_product();
+    while (true) {
+      if (accept("+")) {
+        node = binary(node, parse_product(),
+                      [](double l, double r) { return l + r; });
+      } else if (accept("-")) {
+        node = binary(node, parse_product(),
+                      [](double l, double r) { return l - r; });
+      } else {
+        return node;
+      }
+    }
+  }
+
+  Node parse_product() {
+    Node node = parse_unary();
+    while (true) {
+      if (accept("*")) {
+        node = binary(node, parse_unary(),
+                      [](double l, double r) { return l * r; });
+      } else if (accept("/")) {
+        node = binary(node, parse_unary(),
+                      [](double l, double r) { return l / r; });
+      } else {
+        return node;
+      }
+    }
+  }
+
+  Node parse_unary() {
+    // Make sure that '!=' is not mistaken for a negation.
+    skip_whitespace();
+    if (expression.compare(position, 2, "!=") != 0 && accept("!")) {
+      return unary(parse_unary(),
+                   [](double o) { return static_cast<double>(o == 0.); });
+    }
+    if (accept("-")) {
+      return unary(parse_unary(), [](double o) { return -o; });
+    }
+    return parse_primary();
+  }
+
+  Node parse_primary() {
+    skip_whitespace();
+    if (accept("(")) {
+      Node node = parse_or();
+      expect(")");
+      return node;
+    }
+    if (position < expression.size() &&
+        (std::isdigit(static_cast<unsigned char>(expression[position])) ||
+         expression[position] == '.')) {
+      return parse_number();
+    }
+
+    const string name = parse_identifier();
+    if (is_detector(name)) {
+      const size_t detector = detector_id(name);
+      return {[detector](const Energies &energies) {
+                return detector < energies.size() ? energies[detector] : 0.;
+              },
+              false, 0.};
+    }
+    if (name == "sum" || name == "mult" || name == "max") {
+      return parse_function(name);
+    }
+    error("unknown identifier '" + name + "'");
+  }
+
+  Node parse_number() {
+    const size_t start = position;
+    size_t length = 0;
+    double value = 0.;
+    try {
+      value = std::stod(expression.substr(start), &length);
+    } catch (const std::exception &) {
+      error("invalid number");
+    }
+    position = start + length;
+
+    // An optional unit may follow the number.
+    skip_whitespace();
+    const size_t before_unit = position;
+    if (position < expression.size() &&
+        std::isalpha(static_cast<unsigned char>(expression[position]))) {
+      const string unit = parse_identifier();
+      if (unit == "eV") {
+        value *= eV;
+      } else if (unit == "keV") {
+        value *= keV;
+      } else if (unit == "MeV") {
+        value *= MeV;
+      } else if (unit == "GeV") {
+        value *= GeV;
+      } else {
+        position = before_unit;
+        error("unknown unit '" + unit + "'");
+      }
+    }
+    return constant(value);
+  }
+
+  Node parse_function(const string &name) {
+    // An empty list of detectors means all detectors.
+    vector<size_t> detectors;
+    if (accept("(") && !accept(")")) {
+      do {
+        const string first = parse_identifier();
+        if (!is_detector(first)) {
+          error("expected a detector instead of '" + first + "'");
+        }
+        size_t last = detector_id(first);
+        if (accept(":")) {
+          skip_whitespace();
+          if (expression.compare(position, 3, "det") == 0) {
+            position += 3;
+          }
+          last = parse_index();
+        }
+        if (last < detector_id(first)) {
+          error("empty range of detectors");
+        }
+        for (size_t i = detector_id(first); i <= last; ++i) {
+          detectors.push_back(i);
+        }
+      } while (accept(","));
+      expect(")");
+    }
+
+    if (name == "sum") {
+      return aggregate(detectors, [](double result, double energy) {
+        return result + energy;
+      });
+    }
+    if (name == "mult") {
+      return aggregate(detectors, [](double result, double energy) {
+        return result + static_cast<double>(energy != 0.);
+      });
+    }
+    return aggregate(detectors, [](double result, double energy) {
+      return std::max(result, energy);
+    });
+  }
+
+  template <typename Accumulate>
+  static Node aggregate(const vector<size_t> &detectors,
+                        Accumulate accumulate) {
+    if (detectors.empty()) {
+      return {[accumulate](const Energies &energies) {
+                double result = 0.;
+                for (const auto energy : energies) {
+                  result = accumulate(result, energy);
+                }
+                return result;
+              },
+              false, 0.};
+    }
+    return {[detectors, accumulate](const Energies &energies) {
+              double result = 0.;
+              for (const auto detector : detectors) {
+                result = accumulate(result, detector < energies.size()
+                                                ? energies[detector]
+                                                : 0.);
+              }
+              return result;
+            },
+            false, 0.};
+  }
+
+  string parse_identifier() {
+    skip_whitespace();
+    const size_t start = position;
+    while (position < expression.size() &&
+           (std::isalnum(static_cast<unsigned char>(expression[position])) ||
+            expression[position] == '_')) {
+      ++position;
+    }
+    if (position == start) {
+      error(position < expression.size()
+                ? "unexpected '" + expression.substr(position, 1) + "'"
+                : "unexpected end of expression");
+    }
+    return expression.substr(start, position - start);
+  }
+
+  size_t parse_index() {
+    const size_t start = position;
+    while (position < expression.size() &&
+           std::isdigit(static_cast<unsigned char>(expression[position]))) {
+      ++position;
+    }
+    if (position == start) {
+      error("expected a detector ID");
+    }
+    return std::stoul(expression.substr(start, position - start));
+  }
+
+  static bool is_detector(const string &name) {
+    return name.size() > 3 && name.compare(0, 3, "det") == 0 &&
+           std::all_of(name.begin() + 3, name.end(), [](char c) {
+             return std::isdigit(static_cast<unsigned char>(c));
+           });
+  }
+
+  static size_t detector_id(const string &name) {
+    return std::stoul(name.substr(3));
+  }
+
+  void skip_whitespace() {
+    while (position < expression.size() &&
+           std::isspace(static_cast<unsigned char>(expression[position]))) {
+      ++position;
+    }
+  }
+
+  bool accept(const string &token) {
+    skip_whitespace();
+    if (expression.compare(position, token.size(), token) == 0) {
+      position += token.size();
+      return true;
+    }
+    return false;
+  }
+
+  void expect(const string &token) {
+    if (!accept(token)) {
+      error("expected '" + token + "'");
+    }
+  }
+
+  [[noreturn]] void error(const string &message) const {
+    throw runtime_error("Invalid trigger expression '" + expression +
+                        "': " + message + " at position " +
+                        to_string(position) + ".");
+  }
+
+  const string &expression;
+  size_t position;
+};
+
+} // namespace
+
+Trigger::Trigger(const string &_expression) : expression(_expression) {
+  condition = Parser(expression).parse().evaluate;
+}
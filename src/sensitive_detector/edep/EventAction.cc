@@ -17,41 +17,79 @@
     Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
 */
 
-#include <memory>
-
-using std::make_unique;
-using std::unique_ptr;
-
 #include "G4Event.hh"
 #include "G4EventManager.hh"
 #include "G4ios.hh"
 
 #include "DetectorHit.hh"
 #include "EventAction.hh"
+#include "LiveMetrics.hh"
+#include "PerfCounters.hh"
+#include "Tracer.hh"
 
 EventAction::EventAction(AnalysisManager *ana_man) : NEventAction(ana_man) {}
 
 void EventAction::EndOfEventAction(const G4Event *event) {
-  G4VHitsCollection *hc = nullptr;
-  unique_ptr<DetectorHit> cumulative_hit;
+  Tracer::End("Tracking");
+  PerfCounters::End(PerfCounters::tracking);
+  TraceScope trace("EndOfEventAction");
+  PerfCounterScope counters(PerfCounters::output);
+  LiveMetrics::EventFinished();
 
-  for (int n_hc = 0; n_hc < event->GetHCofThisEvent()->GetNumberOfCollections();
-       ++n_hc) {
-
-    hc = event->GetHCofThisEvent()->GetHC(n_hc);
+  const size_t n_variants = analysis_manager->GetNumberOfVariants();
+  collected_energies.resize(n_variants);
+  time_windows.Clear(n_variants);
+  G4HCofThisEvent *hcs = event->GetHCofThisEvent();
+  for (int n_hc = 0; n_hc < hcs->GetNumberOfCollections(); ++n_hc) {
+    G4VHitsCollection *hc = hcs->GetHC(n_hc);
+    for (size_t i = 0; i < hc->GetSize(); ++i) {
+      const auto *hit = static_cast<DetectorHit *>(hc->GetHit(i));
+      const auto detector_id = static_cast<size_t>(hit->GetDetectorID());
+      if (n_variants > 0) {
+        analysis_manager->CollectCharge(detector_id, hit->GetDepth(),
+                                        hit->GetEdep(),
+                                        collected_energies.data());
+      }
+      time_windows.Add(hit->GetGlobalTime(), detector_id, hit->GetEdep(),
+                       hit->GetWeight(), collected_energies.data());
+    }
+  }
+  time_windows.Group(analysis_manager->GetTimeWindow(),
+                     analysis_manager->GetMaxTimeWindows());
 
-    if (hc->GetSize() > 0) {
-      double edep = 0.;
-      for (size_t i = 0; i < hc->GetSize(); ++i)
-        edep += ((DetectorHit *)hc->GetHit(i))->GetEdep();
+  for (size_t window = 0; window < time_windows.GetNumberOfWindows();
+       ++window) {
+    const auto &energies = time_windows.GetEnergies(window);
+    if (!IsTriggered(energies)) {
+      continue;
+    }
+    analysis_manager->SetCurrentTimeWindow(window,
+                                           time_windows.GetStartTime(window));
+    analysis_manager->SetCurrentCollectedEnergies(
+        time_windows.GetCollectedEnergies(window));
+    if (analysis_manager->HasDigitizer()) {
+      analysis_manager->Digitize(energies, digitized_energies);
+    }
 
-      cumulative_hit = make_unique<DetectorHit>();
-      cumulative_hit->SetDetectorID(
-          ((DetectorHit *)hc->GetHit(0))->GetDetectorID());
-      cumulative_hit->SetEdep(edep);
+    for (size_t detector_id = 0; detector_id < energies.size();
+         ++detector_id) {
+      if (energies[detector_id] == 0.) {
+        continue;
+      }
+      DetectorHit cumulative_hit;
+      cumulative_hit.SetDetectorID(static_cast<int>(detector_id));
+      cumulative_hit.SetEdep(energies[detector_id]);
+      cumulative_hit.SetWeight(time_windows.GetWeights(window)[detector_id]);
+      if (analysis_manager->HasDigitizer()) {
+        if (!analysis_manager->WritesEdep() &&
+            digitized_energies[detector_id] == 0.) {
+          continue;
+        }
+        cumulative_hit.SetDigitizedEnergy(digitized_energies[detector_id]);
+      }
       vector<G4VHit *> hits{
-          cumulative_hit.get()}; // Wrap cumulative hit into a vector for
-                                 // compatibility with the AnalysisManager API.
+          &cumulative_hit}; // Wrap cumulative hit into a vector for
+                            // compatibility with the AnalysisManager API.
       analysis_manager->FillNtuple(event, hits);
     }
   }
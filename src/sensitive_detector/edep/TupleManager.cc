@@ -17,28 +17,91 @@
     Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
 */
 
-#include "TupleManager.hh"
+#include "G4RunManager.hh"
+
 #include "DetectorHit.hh"
+#include "NDetectorConstruction.hh"
+#include "TupleManager.hh"
 
-void TupleManager::CreateNtupleColumns(G4AnalysisManager *analysisManager) {
+void TupleManager::CreateNtupleColumns(OutputBackend *output) {
 
-  analysisManager->CreateNtuple("edep", "Energy Deposition");
+  output->CreateNtuple("edep", "Energy Deposition");
 
-  AnalysisManager::CreateNtupleColumns(analysisManager);
+  AnalysisManager::CreateNtupleColumns(output);
+  CreateTimeWindowColumns(output);
 
-  analysisManager->CreateNtupleIColumn("deid");
-  analysisManager->CreateNtupleDColumn("edep");
+  output->CreateNtupleIColumn("deid");
+  if (WritesEdep()) {
+    output->CreateNtupleDColumn("edep");
+  }
+  if (HasDigitizer()) {
+    output->CreateNtupleDColumn("digi");
+  }
+  for (size_t variant = 0; variant < GetNumberOfVariants(); ++variant) {
+    output->CreateNtupleDColumn("edep_" + GetVariants()[variant]);
+  }
+  if (WritesWeights()) {
+    output->CreateNtupleDColumn("weight");
+  }
+
+  // The spectra are named like the columns of the 'event' sensitive
+  // detector.
+  if (HasSpectra()) {
+    const size_t n_sensitive_detectors =
+        ((NDetectorConstruction *)G4RunManager::GetRunManager()
+             ->GetUserDetectorConstruction())
+            ->GetNumberOfSensitiveDetectors();
+    spectra_per_detector = (WritesEdep() ? 1 : 0) + (HasDigitizer() ? 1 : 0) +
+                           GetNumberOfVariants();
+    for (size_t i = 0; i < n_sensitive_detectors; ++i) {
+      if (WritesEdep()) {
+        CreateSpectrum("det" + to_string(i));
+      }
+      if (HasDigitizer()) {
+        CreateSpectrum("digi" + to_string(i));
+      }
+      for (size_t variant = 0; variant < GetNumberOfVariants(); ++variant) {
+        CreateSpectrum("det" + to_string(i) + "_" + GetVariants()[variant]);
+      }
+    }
+  }
 }
 
-size_t TupleManager::FillNtupleColumns(G4AnalysisManager *analysisManager,
+size_t TupleManager::FillNtupleColumns(OutputBackend *output,
                                        [[maybe_unused]] const G4Event *event,
                                        vector<G4VHit *> hits) {
 
-  auto col = AnalysisManager::FillNtupleColumns(analysisManager, event, hits);
+  auto col = AnalysisManager::FillNtupleColumns(output, event, hits);
+  col = FillTimeWindowColumns(output, col);
+
+  const auto *hit = static_cast<DetectorHit *>(hits[0]);
+  output->FillNtupleIColumn(0, col++, hit->GetDetectorID());
+  if (WritesEdep()) {
+    output->FillNtupleDColumn(0, col++, hit->GetEdep());
+  }
+  if (HasDigitizer()) {
+    output->FillNtupleDColumn(0, col++, hit->GetDigitizedEnergy());
+  }
+  for (size_t variant = 0; variant < GetNumberOfVariants(); ++variant) {
+    output->FillNtupleDColumn(
+        0, col++, CollectedEnergy(hit->GetDetectorID(), variant));
+  }
+  if (WritesWeights()) {
+    output->FillNtupleDColumn(0, col++, hit->GetWeight());
+  }
 
-  analysisManager->FillNtupleIColumn(
-      0, col++, static_cast<DetectorHit *>(hits[0])->GetDetectorID());
-  analysisManager->FillNtupleDColumn(
-      0, col++, static_cast<DetectorHit *>(hits[0])->GetEdep());
+  if (HasSpectra()) {
+    size_t spectrum = hit->GetDetectorID() * spectra_per_detector;
+    if (WritesEdep()) {
+      FillSpectrum(spectrum++, hit->GetEdep(), hit->GetWeight());
+    }
+    if (HasDigitizer()) {
+      FillSpectrum(spectrum++, hit->GetDigitizedEnergy(), hit->GetWeight());
+    }
+    for (size_t variant = 0; variant < GetNumberOfVariants(); ++variant) {
+      FillSpectrum(spectrum++, CollectedEnergy(hit->GetDetectorID(), variant),
+                   hit->GetWeight());
+    }
+  }
   return col;
 }
@@ -18,19 +18,36 @@
 */
 
 #include "DetectorHit.hh"
+#include "MemoryMonitor.hh"
 
 G4ThreadLocal G4Allocator<DetectorHit> *DetectorHitAllocator = 0;
 
-DetectorHit::DetectorHit() : NDetectorHit(), fEdep(0.) {}
+[[maybe_unused]] static const bool detector_hit_allocator_registered =
+    MemoryMonitor::RegisterAllocator("DetectorHit", []() -> size_t {
+      return DetectorHitAllocator ? DetectorHitAllocator->GetAllocatedSize()
+                                  : 0;
+    });
+
+DetectorHit::DetectorHit()
+    : NDetectorHit(), fEdep(0.), fGlobalTime(0.), fDigitizedEnergy(0.),
+      fDepth(0.f) {}
 
 DetectorHit::DetectorHit(const DetectorHit &right) : NDetectorHit() {
   fDetectorID = right.fDetectorID;
+  fWeight = right.fWeight;
   fEdep = right.fEdep;
+  fGlobalTime = right.fGlobalTime;
+  fDigitizedEnergy = right.fDigitizedEnergy;
+  fDepth = right.fDepth;
 }
 
 const DetectorHit &DetectorHit::operator=(const DetectorHit &right) {
   fDetectorID = right.fDetectorID;
+  fWeight = right.fWeight;
   fEdep = right.fEdep;
+  fGlobalTime = right.fGlobalTime;
+  fDigitizedEnergy = right.fDigitizedEnergy;
+  fDepth = right.fDepth;
 
   return *this;
 }
\ No newline at end of file
@@ -29,48 +29,97 @@ using std::unique_ptr;
 
 #include "DetectorHit.hh"
 #include "EventAction.hh"
+#include "LiveMetrics.hh"
+#include "PerfCounters.hh"
 #include "SensitiveDetectorBuildOptions.hh"
+#include "Tracer.hh"
 
 EventAction::EventAction(AnalysisManager *ana_man) : NEventAction(ana_man) {}
 
 void EventAction::EndOfEventAction(const G4Event *event) {
-  G4VHitsCollection *hc = nullptr;
+  Tracer::End("Tracking");
+  PerfCounters::End(PerfCounters::tracking);
+  TraceScope trace("EndOfEventAction");
+  PerfCounterScope counters(PerfCounters::output);
+  LiveMetrics::EventFinished();
+
+  const size_t n_variants = analysis_manager->GetNumberOfVariants();
+  collected_energies.resize(n_variants);
+  time_windows.Clear(n_variants);
+  G4HCofThisEvent *hcs = event->GetHCofThisEvent();
+  for (int n_hc = 0; n_hc < hcs->GetNumberOfCollections(); ++n_hc) {
+    G4VHitsCollection *hc = hcs->GetHC(n_hc);
+    for (size_t i = 0; i < hc->GetSize(); ++i) {
+      const auto *hit = static_cast<DetectorHit *>(hc->GetHit(i));
+      const auto detector_id = static_cast<size_t>(hit->GetDetectorID());
+      if (n_variants > 0) {
+        analysis_manager->CollectCharge(detector_id, hit->GetDepth(),
+                                        hit->GetEdep(),
+                                        collected_energies.data());
+      }
+      time_windows.Add(hit->GetGlobalTime(), detector_id, hit->GetEdep(),
+                       hit->GetWeight(), collected_energies.data());
+    }
+  }
+  time_windows.Group(analysis_manager->GetTimeWindow(),
+                     analysis_manager->GetMaxTimeWindows());
+
+  // An event without any energy deposition is still written if the primary
+  // vertex is tracked.
+  if (time_windows.GetNumberOfWindows() == 0) {
+    energies.clear();
+    if (IsTriggered(energies)) {
+      analysis_manager->SetCurrentTimeWindow(0, 0.);
+      analysis_manager->SetCurrentCollectedEnergies(energies);
+      FillTimeWindow(event, energies, energies);
+    }
+    return;
+  }
 
+  for (size_t window = 0; window < time_windows.GetNumberOfWindows();
+       ++window) {
+    const auto &window_energies = time_windows.GetEnergies(window);
+    if (IsTriggered(window_energies)) {
+      analysis_manager->SetCurrentTimeWindow(
+          window, time_windows.GetStartTime(window));
+      analysis_manager->SetCurrentCollectedEnergies(
+          time_windows.GetCollectedEnergies(window));
+      FillTimeWindow(event, window_energies, time_windows.GetWeights(window));
+    }
+  }
+}
+
+void EventAction::FillTimeWindow(const G4Event *event,
+                                 const vector<double> &window_energies,
+                                 const vector<double> &window_weights) {
   vector<unique_ptr<DetectorHit>> hits_owned;
-  hits_owned.push_back(make_unique<DetectorHit>());
+  for (size_t i = 0; i < std::max(window_energies.size(), size_t(1)); ++i) {
+    hits_owned.push_back(make_unique<DetectorHit>());
+  }
 
-  int current_deid{0};
-  int max_deid{0};
   double sum_edep = 0.;
+  for (size_t i = 0; i < window_energies.size(); ++i) {
+    hits_owned[i]->SetEdep(window_energies[i]);
+    hits_owned[i]->SetWeight(window_weights[i]);
+    sum_edep += window_energies[i];
+  }
 
-  for (int n_hc = 0; n_hc < event->GetHCofThisEvent()->GetNumberOfCollections();
-       ++n_hc) {
-
-    hc = event->GetHCofThisEvent()->GetHC(n_hc);
-
-    if (hc->GetSize() > 0) {
-      current_deid = ((DetectorHit *)hc->GetHit(0))->GetDetectorID();
-
-      // Fill the list of hits up to the current detector ID, if it is larger
-      // than the current maximum.
-      if (current_deid > max_deid) {
-        for (int i = 0; i < current_deid - max_deid; ++i) {
-          hits_owned.push_back(make_unique<DetectorHit>());
-        }
-        max_deid = current_deid;
-      }
-
-      double edep = 0.;
-      for (size_t i = 0; i < hc->GetSize(); ++i) {
-        edep += ((DetectorHit *)hc->GetHit(i))->GetEdep();
-      }
-
-      sum_edep += edep;
-      hits_owned[current_deid]->SetEdep(edep);
+  // Without the deposited energies, an event is only written if any
+  // detector responds.
+  double sum_written = sum_edep;
+  if (analysis_manager->HasDigitizer()) {
+    analysis_manager->Digitize(window_energies, digitized_energies);
+    double sum_digitized = 0.;
+    for (size_t i = 0; i < window_energies.size(); ++i) {
+      hits_owned[i]->SetDigitizedEnergy(digitized_energies[i]);
+      sum_digitized += digitized_energies[i];
+    }
+    if (!analysis_manager->WritesEdep()) {
+      sum_written = sum_digitized;
     }
   }
 
-  if (sensitive_detector_build_options.track_primary || sum_edep > 0.) {
+  if (sensitive_detector_build_options.track_primary || sum_written > 0.) {
     vector<G4VHit *> hits_raw;
     std::transform(hits_owned.begin(), hits_owned.end(),
                    std::back_inserter(hits_raw),
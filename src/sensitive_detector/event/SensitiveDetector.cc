@@ -19,6 +19,8 @@
 
 #include "G4SDManager.hh"
 
+#include "NutrMessenger.hh"
+#include "PerfCounters.hh"
 #include "SensitiveDetector.hh"
 
 void SensitiveDetector::Initialize(G4HCofThisEvent *hce) {
@@ -31,6 +33,8 @@ void SensitiveDetector::Initialize(G4HCofThisEvent *hce) {
 }
 
 G4bool SensitiveDetector::ProcessHits(G4Step *aStep, G4TouchableHistory *) {
+  PerfCounterScope counters(PerfCounters::process_hits);
+
   double edep = aStep->GetTotalEnergyDeposit();
   if (edep == 0.)
     return false;
@@ -38,7 +42,12 @@ G4bool SensitiveDetector::ProcessHits(G4Step *aStep, G4TouchableHistory *) {
   DetectorHit *newDetectorHit = new DetectorHit();
 
   newDetectorHit->SetDetectorID(fDetectorID);
+  newDetectorHit->SetWeight(aStep->GetTrack()->GetWeight());
   newDetectorHit->SetEdep(edep);
+  newDetectorHit->SetGlobalTime(aStep->GetPreStepPoint()->GetGlobalTime());
+  if (!NutrMessenger::GetChargeCollection().empty()) {
+    newDetectorHit->SetDepth(Depth(aStep));
+  }
 
   fDetectorHitsCollection->insert(newDetectorHit);
 
@@ -18,8 +18,10 @@
 */
 
 #include <memory>
+#include <stdexcept>
 
 using std::dynamic_pointer_cast;
+using std::runtime_error;
 
 #include "G4RunManager.hh"
 
@@ -27,38 +29,187 @@ using std::dynamic_pointer_cast;
 #include "NDetectorConstruction.hh"
 #include "TupleManager.hh"
 
-void TupleManager::CreateNtupleColumns(G4AnalysisManager *analysisManager) {
+void TupleManager::CreateNtupleColumns(OutputBackend *output) {
 
-  analysisManager->CreateNtuple("edep", "Energy Deposition");
+  output->CreateNtuple("edep", "Energy Deposition");
 
-  AnalysisManager::CreateNtupleColumns(analysisManager);
+  AnalysisManager::CreateNtupleColumns(output);
+  CreateTimeWindowColumns(output);
 
+  const auto *detector_construction =
+      (NDetectorConstruction *)G4RunManager::GetRunManager()
+          ->GetUserDetectorConstruction();
   n_sensitive_detectors =
-      ((NDetectorConstruction *)G4RunManager::GetRunManager()
-           ->GetUserDetectorConstruction())
-          ->GetNumberOfSensitiveDetectors();
+      detector_construction->GetNumberOfSensitiveDetectors();
+
+  written_detectors.assign(n_sensitive_detectors, true);
+  addback_groups.clear();
+  if (HasAddback()) {
+    for (const auto &group :
+         detector_construction->GetSensitiveDetectorGroups()) {
+      if (group.size() < 2) {
+        continue;
+      }
+      if (group.size() > 31) {
+        throw runtime_error("The hit pattern of the detector with the "
+                            "crystals " +
+                            to_string(group.front()) + " to " +
+                            to_string(group.back()) +
+                            " does not fit into an integer column.");
+      }
+      addback_groups.push_back(group);
+      for (const auto detector_id : group) {
+        written_detectors[detector_id] = WritesCrystals();
+      }
+    }
+  }
 
+  if (WritesWeights()) {
+    output->CreateNtupleDColumn("weight");
+  }
+  // Each energy column has a spectrum with the same name.
+  if (WritesEdep()) {
+    for (size_t i = 0; i < n_sensitive_detectors; ++i) {
+      if (written_detectors[i]) {
+        output->CreateNtupleDColumn("det" + to_string(i));
+        if (HasSpectra()) {
+          CreateSpectrum("det" + to_string(i));
+        }
+      }
+    }
+  }
+  if (HasDigitizer()) {
+    for (size_t i = 0; i < n_sensitive_detectors; ++i) {
+      if (written_detectors[i]) {
+        output->CreateNtupleDColumn("digi" + to_string(i));
+        if (HasSpectra()) {
+          CreateSpectrum("digi" + to_string(i));
+        }
+      }
+    }
+  }
   for (size_t i = 0; i < n_sensitive_detectors; ++i) {
-    analysisManager->CreateNtupleDColumn("det" + to_string(i));
+    if (written_detectors[i]) {
+      for (size_t variant = 0; variant < GetNumberOfVariants(); ++variant) {
+        const string name = "det" + to_string(i) + "_" + GetVariants()[variant];
+        output->CreateNtupleDColumn(name);
+        if (HasSpectra()) {
+          CreateSpectrum(name);
+        }
+      }
+    }
+  }
+  for (const auto &group : addback_groups) {
+    output->CreateNtupleDColumn("addb" + to_string(group.front()));
+    output->CreateNtupleIColumn("fold" + to_string(group.front()));
+    output->CreateNtupleIColumn("pat" + to_string(group.front()));
+    if (HasSpectra()) {
+      CreateSpectrum("addb" + to_string(group.front()));
+    }
   }
 }
 
-size_t TupleManager::FillNtupleColumns(G4AnalysisManager *analysisManager,
+double TupleManager::AddbackEnergy(const vector<G4VHit *> &hits,
+                                   const size_t detector_id) const {
+  if (detector_id >= hits.size()) {
+    return 0.;
+  }
+  const auto *hit = static_cast<DetectorHit *>(hits[detector_id]);
+  return HasDigitizer() ? hit->GetDigitizedEnergy() : hit->GetEdep();
+}
+
+double TupleManager::Weight(const vector<G4VHit *> &hits,
+                            const size_t detector_id) const {
+  if (detector_id >= hits.size()) {
+    return 1.;
+  }
+  return static_cast<DetectorHit *>(hits[detector_id])->GetWeight();
+}
+
+size_t TupleManager::FillNtupleColumns(OutputBackend *output,
                                        const G4Event *event,
                                        vector<G4VHit *> hits) {
 
-  auto col = AnalysisManager::FillNtupleColumns(analysisManager, event, hits);
-
-  for (size_t i = 0; i < hits.size(); ++i) {
-    analysisManager->FillNtupleDColumn(
-        0, col++, static_cast<DetectorHit *>(hits[i])->GetEdep());
+  auto col = AnalysisManager::FillNtupleColumns(output, event, hits);
+  col = FillTimeWindowColumns(output, col);
+
+  if (WritesWeights()) {
+    double sum_edep = 0., sum_weighted_edep = 0.;
+    for (const auto *hit : hits) {
+      const auto *detector_hit = static_cast<const DetectorHit *>(hit);
+      sum_edep += detector_hit->GetEdep();
+      sum_weighted_edep += detector_hit->GetEdep() * detector_hit->GetWeight();
+    }
+    output->FillNtupleDColumn(
+        0, col++, sum_edep > 0. ? sum_weighted_edep / sum_edep : 1.);
   }
+
   // The number of entries in std::vector hits will only be as large as highest
   // ID of all detectors that were hit. There may be detectors with an even
   // higher ID which were not hit. Fill all higher IDs than hits.size()-1 with
   // zeros.
-  for (size_t i = hits.size(); i < n_sensitive_detectors; ++i) {
-    analysisManager->FillNtupleDColumn(0, col++, 0.);
+  size_t spectrum = 0;
+  if (WritesEdep()) {
+    for (size_t i = 0; i < n_sensitive_detectors; ++i) {
+      if (written_detectors[i]) {
+        const double edep =
+            i < hits.size() ? static_cast<DetectorHit *>(hits[i])->GetEdep()
+                            : 0.;
+        output->FillNtupleDColumn(0, col++, edep);
+        if (HasSpectra()) {
+          FillSpectrum(spectrum++, edep, Weight(hits, i));
+        }
+      }
+    }
+  }
+  if (HasDigitizer()) {
+    for (size_t i = 0; i < n_sensitive_detectors; ++i) {
+      if (written_detectors[i]) {
+        const double digitized_energy =
+            i < hits.size()
+                ? static_cast<DetectorHit *>(hits[i])->GetDigitizedEnergy()
+                : 0.;
+        output->FillNtupleDColumn(0, col++, digitized_energy);
+        if (HasSpectra()) {
+          FillSpectrum(spectrum++, digitized_energy, Weight(hits, i));
+        }
+      }
+    }
+  }
+  for (size_t i = 0; i < n_sensitive_detectors; ++i) {
+    if (written_detectors[i]) {
+      for (size_t variant = 0; variant < GetNumberOfVariants(); ++variant) {
+        const double collected_energy = CollectedEnergy(i, variant);
+        output->FillNtupleDColumn(0, col++, collected_energy);
+        if (HasSpectra()) {
+          FillSpectrum(spectrum++, collected_energy, Weight(hits, i));
+        }
+      }
+    }
+  }
+  for (const auto &group : addback_groups) {
+    double addback_energy = 0.;
+    double weighted_addback_energy = 0.;
+    int fold = 0;
+    int pattern = 0;
+    for (size_t crystal = 0; crystal < group.size(); ++crystal) {
+      const double energy = AddbackEnergy(hits, group[crystal]);
+      if (energy > 0.) {
+        addback_energy += energy;
+        weighted_addback_energy += energy * Weight(hits, group[crystal]);
+        ++fold;
+        pattern |= 1 << crystal;
+      }
+    }
+    output->FillNtupleDColumn(0, col++, addback_energy);
+    output->FillNtupleIColumn(0, col++, fold);
+    output->FillNtupleIColumn(0, col++, pattern);
+    if (HasSpectra()) {
+      FillSpectrum(spectrum++, addback_energy,
+                   addback_energy > 0.
+                       ? weighted_addback_energy / addback_energy
+                       : 1.);
+    }
   }
   return col;
 }
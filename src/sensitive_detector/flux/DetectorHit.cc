@@ -18,41 +18,58 @@
 */
 
 #include "DetectorHit.hh"
+#include "MemoryMonitor.hh"
 
 G4ThreadLocal G4Allocator<DetectorHit> *DetectorHitAllocator = 0;
 
+[[maybe_unused]] static const bool detector_hit_allocator_registered =
+    MemoryMonitor::RegisterAllocator("DetectorHit", []() -> size_t {
+      return DetectorHitAllocator ? DetectorHitAllocator->GetAllocatedSize()
+                                  : 0;
+    });
+
 DetectorHit::DetectorHit()
     : NDetectorHit(), fParticleID(0), fParentID(0), fTrackID(-1), fEkin(0.),
-      fPos(G4ThreeVector()), fMom(G4ThreeVector()) {}
+      fPos(G4ThreeVector()), fMom(G4ThreeVector()), fIncidenceAngle(0.),
+      fTrackLength(0.) {}
 
 DetectorHit::DetectorHit(const DetectorHit &right) : NDetectorHit() {
   fDetectorID = right.fDetectorID;
+  fWeight = right.fWeight;
   fParticleID = right.fParticleID;
   fParentID = right.fParentID;
   fTrackID = right.fTrackID;
   fEkin = right.fEkin;
   fPos = right.fPos;
   fMom = right.fMom;
+  fIncidenceAngle = right.fIncidenceAngle;
+  fTrackLength = right.fTrackLength;
 }
 
 DetectorHit::DetectorHit(DetectorHit *right) : NDetectorHit() {
   fDetectorID = right->fDetectorID;
+  fWeight = right->fWeight;
   fParticleID = right->fParticleID;
   fParentID = right->fParentID;
   fTrackID = right->fTrackID;
   fEkin = right->fEkin;
   fPos = right->fPos;
   fMom = right->fMom;
+  fIncidenceAngle = right->fIncidenceAngle;
+  fTrackLength = right->fTrackLength;
 }
 
 const DetectorHit &DetectorHit::operator=(const DetectorHit &right) {
   fDetectorID = right.fDetectorID;
+  fWeight = right.fWeight;
   fParticleID = right.fParticleID;
   fParentID = right.fParentID;
   fTrackID = right.fTrackID;
   fEkin = right.fEkin;
   fPos = right.fPos;
   fMom = right.fMom;
+  fIncidenceAngle = right.fIncidenceAngle;
+  fTrackLength = right.fTrackLength;
 
   return *this;
 }
\ No newline at end of file
@@ -27,10 +27,43 @@ using std::make_shared;
 
 #include "DetectorHit.hh"
 #include "EventAction.hh"
+#include "LiveMetrics.hh"
+#include "PerfCounters.hh"
+#include "Tracer.hh"
 
 EventAction::EventAction(AnalysisManager *ana_man) : NEventAction(ana_man) {}
 
 void EventAction::EndOfEventAction(const G4Event *event) {
+  Tracer::End("Tracking");
+  PerfCounters::End(PerfCounters::tracking);
+  TraceScope trace("EndOfEventAction");
+  PerfCounterScope counters(PerfCounters::output);
+  LiveMetrics::EventFinished();
+
+  // For flux spectra, the sensitive detector only records the entries of
+  // particles into a detector, or the steps for the track-length estimator,
+  // which are all counted, and no rows are written. Events that are not
+  // triggered count as empty events.
+  if (analysis_manager->HasSpectra()) {
+    spectrum_hits.clear();
+    if (IsTriggered(event)) {
+      for (int n_hc = 0;
+           n_hc < event->GetHCofThisEvent()->GetNumberOfCollections();
+           ++n_hc) {
+        G4VHitsCollection *hc = event->GetHCofThisEvent()->GetHC(n_hc);
+        for (size_t i = 0; i < hc->GetSize(); ++i) {
+          spectrum_hits.push_back(hc->GetHit(i));
+        }
+      }
+    }
+    analysis_manager->FillHistograms(spectrum_hits);
+    return;
+  }
+
+  if (!IsTriggered(event)) {
+    return;
+  }
+
   G4VHitsCollection *hc = nullptr;
   int particleID{0}, trackID{0};
   DetectorHit *hit;
@@ -57,3 +90,21 @@ void EventAction::EndOfEventAction(const G4Event *event) {
     }
   }
 }
+
+double EventAction::DetectorEnergy(G4VHitsCollection *hc) const {
+  // Count each particle only once, like in EndOfEventAction().
+  DetectorHit *hit = (DetectorHit *)hc->GetHit(0);
+  double ekin = hit->GetEkin();
+  int particleID = hit->GetParticleID();
+  int trackID = hit->GetTrackID();
+
+  for (size_t i = 1; i < hc->GetSize(); ++i) {
+    hit = (DetectorHit *)hc->GetHit(i);
+    if (hit->GetParticleID() != particleID || hit->GetTrackID() != trackID) {
+      ekin += hit->GetEkin();
+      particleID = hit->GetParticleID();
+      trackID = hit->GetTrackID();
+    }
+  }
+  return ekin;
+}
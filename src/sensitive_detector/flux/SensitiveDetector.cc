@@ -19,6 +19,9 @@
 
 #include "G4SDManager.hh"
 
+#include "FluxSpectra.hh"
+#include "NutrMessenger.hh"
+#include "PerfCounters.hh"
 #include "SensitiveDetector.hh"
 
 void SensitiveDetector::Initialize(G4HCofThisEvent *hce) {
@@ -31,9 +34,23 @@ void SensitiveDetector::Initialize(G4HCofThisEvent *hce) {
 }
 
 G4bool SensitiveDetector::ProcessHits(G4Step *aStep, G4TouchableHistory *) {
+  PerfCounterScope counters(PerfCounters::process_hits);
+
+  // For flux spectra, a track is only counted when it enters the detector
+  // through its surface, so all other steps are skipped without a hit. The
+  // track-length estimator uses all steps instead.
+  const bool spectra = NutrMessenger::GetSpectrum().n_bins > 0;
+  const bool track_length = spectra && NutrMessenger::GetTrackLength();
+  const G4StepPoint *pre_step_point = aStep->GetPreStepPoint();
+  if (spectra && !track_length &&
+      pre_step_point->GetStepStatus() != fGeomBoundary) {
+    return false;
+  }
+
   DetectorHit *newDetectorHit = new DetectorHit();
 
   newDetectorHit->SetDetectorID(fDetectorID);
+  newDetectorHit->SetWeight(aStep->GetTrack()->GetWeight());
   newDetectorHit->SetParticleID(
       aStep->GetTrack()->GetDynamicParticle()->GetPDGcode());
   newDetectorHit->SetParentID(aStep->GetTrack()->GetParentID());
@@ -41,8 +58,16 @@ G4bool SensitiveDetector::ProcessHits(G4Step *aStep, G4TouchableHistory *) {
   newDetectorHit->SetEkin(aStep->GetTrack()->GetKineticEnergy());
   newDetectorHit->SetPos(aStep->GetPostStepPoint()->GetPosition());
   newDetectorHit->SetMom(aStep->GetTrack()->GetMomentum());
+  if (track_length) {
+    newDetectorHit->SetEkin(pre_step_point->GetKineticEnergy());
+    newDetectorHit->SetTrackLength(aStep->GetStepLength());
+  } else if (spectra) {
+    newDetectorHit->SetEkin(pre_step_point->GetKineticEnergy());
+    newDetectorHit->SetIncidenceAngle(
+        FluxSpectra::IncidenceAngle(pre_step_point));
+  }
 
   fDetectorHitsCollection->insert(newDetectorHit);
 
   return true;
-}
\ No newline at end of file
+}
@@ -17,53 +17,88 @@
     Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
 */
 
-#include "TupleManager.hh"
+#include "G4SystemOfUnits.hh"
+
 #include "DetectorHit.hh"
+#include "NutrMessenger.hh"
+#include "TupleManager.hh"
+
+void TupleManager::CreateNtupleColumns(OutputBackend *output) {
+  const bool track_length = NutrMessenger::GetTrackLength();
+  flux_spectra.Reset(track_length ? "tl" : "det", spectrum,
+                     {"angle", NutrMessenger::GetAngleBins(), 0., 90. * deg},
+                     track_length, NutrMessenger::GetBatchSize());
 
-void TupleManager::CreateNtupleColumns(G4AnalysisManager *analysisManager) {
-  analysisManager->CreateNtuple("part", "Particles");
-  AnalysisManager::CreateNtupleColumns(analysisManager);
-  analysisManager->CreateNtupleIColumn("deid");
-  analysisManager->CreateNtupleIColumn("pid");
-  analysisManager->CreateNtupleIColumn("paid");
-  analysisManager->CreateNtupleIColumn("trid");
-  analysisManager->CreateNtupleDColumn("ekin");
-  analysisManager->CreateNtupleDColumn("x");
-  analysisManager->CreateNtupleDColumn("y");
-  analysisManager->CreateNtupleDColumn("z");
-  analysisManager->CreateNtupleDColumn("px");
-  analysisManager->CreateNtupleDColumn("py");
-  analysisManager->CreateNtupleDColumn("pz");
+  output->CreateNtuple("part", "Particles");
+  AnalysisManager::CreateNtupleColumns(output);
+  output->CreateNtupleIColumn("deid");
+  output->CreateNtupleIColumn("pid");
+  output->CreateNtupleIColumn("paid");
+  output->CreateNtupleIColumn("trid");
+  output->CreateNtupleDColumn("ekin");
+  output->CreateNtupleDColumn("x");
+  output->CreateNtupleDColumn("y");
+  output->CreateNtupleDColumn("z");
+  output->CreateNtupleDColumn("px");
+  output->CreateNtupleDColumn("py");
+  output->CreateNtupleDColumn("pz");
+  if (WritesWeights()) {
+    output->CreateNtupleDColumn("weight");
+  }
 }
 
-size_t TupleManager::FillNtupleColumns(G4AnalysisManager *analysisManager,
+size_t TupleManager::FillNtupleColumns(OutputBackend *output,
                                        [[maybe_unused]] const G4Event *event,
                                        vector<G4VHit *> hits) {
 
-  auto col = AnalysisManager::FillNtupleColumns(analysisManager, event, hits);
+  auto col = AnalysisManager::FillNtupleColumns(output, event, hits);
 
-  analysisManager->FillNtupleIColumn(
+  output->FillNtupleIColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetDetectorID());
-  analysisManager->FillNtupleIColumn(
+  output->FillNtupleIColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetParticleID());
-  analysisManager->FillNtupleIColumn(
+  output->FillNtupleIColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetParentID());
-  analysisManager->FillNtupleIColumn(
+  output->FillNtupleIColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetTrackID());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetEkin());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetPos().x());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetPos().y());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetPos().z());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetMom().x());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetMom().y());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetMom().z());
+  if (WritesWeights()) {
+    output->FillNtupleDColumn(
+        0, col++, static_cast<DetectorHit *>(hits[0])->GetWeight());
+  }
 
   return col;
 }
+
+void TupleManager::FillHistograms(const vector<G4VHit *> &hits) {
+  for (const auto *h : hits) {
+    const auto *hit = static_cast<const DetectorHit *>(h);
+    if (flux_spectra.IsTrackLength()) {
+      flux_spectra.FillStep(hit->GetDetectorID(), hit->GetParticleID(),
+                            hit->GetEkin(), hit->GetTrackLength(),
+                            hit->GetWeight());
+    } else {
+      flux_spectra.FillEntry(hit->GetDetectorID(), hit->GetParticleID(),
+                             hit->GetEkin(), hit->GetIncidenceAngle(),
+                             hit->GetWeight());
+    }
+  }
+  flux_spectra.EndOfEvent();
+}
+
+void TupleManager::FinishHistograms() {
+  flux_spectra.Finish(histograms, batches);
+}
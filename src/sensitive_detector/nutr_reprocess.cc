@@ -0,0 +1,337 @@
+/*
+    This file is part of nutr.
+
+    nutr is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    nutr is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with nutr.  If not, see <https://www.gnu.org/licenses/>.
+
+    Copyright (C) 2020-2022 Udo Friman-Gayer and Oliver Papst
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+#include "CLHEP/Random/MixMaxRng.h"
+#include "G4PhysicalConstants.hh"
+
+#include "ChargeCollection.hh"
+#include "ColumnarOutputBackend.hh"
+#include "Digitizer.hh"
+#include "StepReader.hh"
+
+namespace {
+
+/**
+ * \brief Segmentation of the detectors in their own frame, by the azimuthal
+ * angle around the z axis and by boundaries along the z axis
+ */
+struct Segmentation {
+  unsigned int phi_segments = 1;
+  vector<double> z_boundaries; /**< Ascending. */
+
+  unsigned int GetNumberOfSegments() const {
+    return phi_segments * static_cast<unsigned int>(z_boundaries.size() + 1);
+  }
+  unsigned int Segment(const double *position) const {
+    const double phi = std::atan2(position[1], position[0]) + pi;
+    const unsigned int phi_segment = std::min(
+        static_cast<unsigned int>(phi / twopi * phi_segments),
+        phi_segments - 1);
+    const auto z_segment = static_cast<unsigned int>(
+        std::upper_bound(z_boundaries.begin(), z_boundaries.end(),
+                         position[2]) -
+        z_boundaries.begin());
+    return phi_segment * static_cast<unsigned int>(z_boundaries.size() + 1) +
+           z_segment;
+  }
+};
+
+vector<double> ParseBoundaries(const string &list) {
+  vector<double> boundaries;
+  std::istringstream fields(list);
+  string field;
+  while (std::getline(fields, field, ',')) {
+    size_t end = 0;
+    try {
+      boundaries.push_back(std::stod(field, &end));
+    } catch (const std::exception &) {
+      end = 0;
+    }
+    if (end == 0 || end != field.size()) {
+      throw runtime_error("Invalid z boundary '" + field + "'.");
+    }
+  }
+  if (!std::is_sorted(boundaries.begin(), boundaries.end())) {
+    throw runtime_error("The z boundaries must be in ascending order.");
+  }
+  return boundaries;
+}
+
+struct Options {
+  string input;
+  unsigned int n_threads;
+  long seed;
+  Segmentation segmentation;
+  const ChargeCollection *charge_collection;
+  string calibration;
+};
+
+/**
+ * \brief Apply the detector response to every n_threads-th event of the step
+ * file, starting with the event thread_index
+ *
+ * Every event draws its random numbers from an engine that is seeded with
+ * the seed and the event ID, so that the result does not depend on the
+ * number of threads.
+ */
+void Reprocess(const Options &options, const unsigned int thread_index,
+               ColumnarOutputBackend &output) {
+  // Each thread passes its own engine to the digitizer. The engine of CLHEP
+  // is only thread-local in multithreaded builds of Geant4.
+  CLHEP::MixMaxRng engine;
+  auto digitizer = options.calibration.empty()
+                       ? nullptr
+                       : std::make_unique<Digitizer>(options.calibration);
+  const size_t n_variants =
+      options.charge_collection == nullptr
+          ? 0
+          : options.charge_collection->GetNumberOfVariants();
+  const size_t n_energies = 1 + n_variants;
+  const bool segmented = options.segmentation.GetNumberOfSegments() > 1;
+
+  StepReader reader(options.input);
+  StepReader::Event event;
+  // Energies of each segment of each detector that was hit, keyed by the
+  // segment and the detector ID.
+  std::map<std::pair<unsigned int, uint32_t>, vector<double>> hits;
+  vector<double> energies, digitized;
+  vector<double> collected(n_variants);
+  for (uint64_t index = 0;; ++index) {
+    if (index % options.n_threads != thread_index) {
+      if (!reader.Skip()) {
+        break;
+      }
+      continue;
+    }
+    if (!reader.Next(event)) {
+      break;
+    }
+
+    hits.clear();
+    for (const auto &point : event.points) {
+      auto &hit = hits[{options.segmentation.Segment(point.position),
+                        point.detector_id}];
+      hit.resize(2 * n_energies, 0.);
+      hit[0] += point.edep;
+      if (n_variants > 0) {
+        options.charge_collection->Collect(point.detector_id, point.depth,
+                                           point.edep, collected.data());
+        for (size_t variant = 0; variant < n_variants; ++variant) {
+          hit[1 + variant] += collected[variant];
+        }
+      }
+    }
+    if (hits.empty()) {
+      continue;
+    }
+
+    // The digitizer is indexed by the detector ID, so each segment and each
+    // variant is digitized separately.
+    if (digitizer != nullptr) {
+      const long seeds[] = {options.seed, static_cast<long>(event.event_id),
+                            0};
+      engine.setSeeds(seeds, 2);
+      for (auto first = hits.begin(); first != hits.end();) {
+        auto last = first;
+        while (last != hits.end() && last->first.first == first->first.first) {
+          ++last;
+        }
+        energies.assign(std::prev(last)->first.second + 1, 0.);
+        for (size_t i = 0; i < n_energies; ++i) {
+          for (auto hit = first; hit != last; ++hit) {
+            energies[hit->first.second] = hit->second[i];
+          }
+          digitizer->Digitize(energies, digitized, &engine);
+          for (auto hit = first; hit != last; ++hit) {
+            hit->second[n_energies + i] = digitized[hit->first.second];
+          }
+        }
+        first = last;
+      }
+    }
+
+    for (const auto &[key, hit] : hits) {
+      int col = 0;
+      output.FillNtupleLColumn(0, col++, event.event_id);
+      output.FillNtupleIColumn(0, col++, event.run_id);
+      output.FillNtupleIColumn(0, col++, static_cast<int>(key.second));
+      if (segmented) {
+        output.FillNtupleIColumn(0, col++, static_cast<int>(key.first));
+      }
+      const size_t n_columns = (digitizer != nullptr ? 2 : 1) * n_energies;
+      for (size_t i = 0; i < n_columns; ++i) {
+        output.FillNtupleDColumn(0, col++, hit[i]);
+      }
+      output.AddNtupleRow(0);
+    }
+    output.NewEvent();
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  po::options_description desc(
+      "nutr_reprocess: apply a detector response to the step points of the "
+      "'step_points' scorer and write the energy of each detector in each "
+      "event in the columnar format");
+  desc.add_options()("help", "Show help message.")(
+      "input", po::value<string>(), "Step-point file ('.nutrstp').")(
+      "output,o", po::value<string>(), "Output file ('.nutr').")(
+      "threads,j",
+      po::value<unsigned int>()->default_value(
+          std::max(std::thread::hardware_concurrency(), 1u)),
+      "Number of threads (default: number of cores).")(
+      "calibration", po::value<string>(),
+      "Energy resolution, threshold and gain of each detector, in the format "
+      "of /analysis/calibration. Adds the columns 'digi' and "
+      "'digi_VARIANT'.")(
+      "charge-collection", po::value<string>(),
+      "Dead layer and charge collection of each detector, in the format of "
+      "/analysis/charge_collection. Adds the columns 'edep_VARIANT'.")(
+      "phi-segments", po::value<unsigned int>()->default_value(1),
+      "Number of segments of each detector in the azimuthal angle around its "
+      "z axis.")("z-segments", po::value<string>(),
+                 "Comma-separated boundaries of the segments of each detector "
+                 "along its z axis, in mm.")(
+      "seed", po::value<long>()->default_value(1),
+      "Seed of the random numbers of the calibration.");
+  po::positional_options_description positional;
+  positional.add("input", 1);
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv)
+                .options(desc)
+                .positional(positional)
+                .run(),
+            vm);
+  po::notify(vm);
+
+  if (vm.count("help") || !vm.count("input") || !vm.count("output")) {
+    cout << desc << endl;
+    return 1;
+  }
+
+  try {
+    Options options;
+    options.input = vm["input"].as<string>();
+    options.n_threads = std::max(vm["threads"].as<unsigned int>(), 1u);
+    options.seed = vm["seed"].as<long>();
+    options.segmentation.phi_segments =
+        std::max(vm["phi-segments"].as<unsigned int>(), 1u);
+    if (vm.count("z-segments")) {
+      options.segmentation.z_boundaries =
+          ParseBoundaries(vm["z-segments"].as<string>());
+    }
+    std::unique_ptr<ChargeCollection> charge_collection;
+    if (vm.count("charge-collection")) {
+      charge_collection = std::make_unique<ChargeCollection>(
+          vm["charge-collection"].as<string>());
+    }
+    options.charge_collection = charge_collection.get();
+    if (vm.count("calibration")) {
+      options.calibration = vm["calibration"].as<string>();
+      // Fail before starting the threads if the file is invalid.
+      Digitizer digitizer(options.calibration);
+    }
+    // Also checks the header of the input.
+    StepReader reader(options.input);
+
+    // All threads write to the same file, which stays open until every
+    // thread has finished.
+    vector<string> columns{"edep"};
+    if (charge_collection != nullptr) {
+      for (const auto &variant : charge_collection->GetVariants()) {
+        columns.push_back("edep_" + variant);
+      }
+    }
+    if (!options.calibration.empty()) {
+      const size_t n_energies = columns.size();
+      for (size_t i = 0; i < n_energies; ++i) {
+        columns.push_back("digi" + columns[i].substr(4));
+      }
+    }
+    vector<ColumnarOutputBackend> outputs(options.n_threads);
+    for (auto &output : outputs) {
+      output.OpenFile(vm["output"].as<string>());
+      output.CreateNtuple("edep", "Energy Deposition");
+      output.CreateNtupleLColumn("evid");
+      output.CreateNtupleIColumn("runid");
+      output.CreateNtupleIColumn("deid");
+      if (options.segmentation.GetNumberOfSegments() > 1) {
+        output.CreateNtupleIColumn("seg");
+      }
+      for (const auto &column : columns) {
+        output.CreateNtupleDColumn(column);
+      }
+      output.FinishNtuple();
+    }
+
+    vector<std::thread> threads;
+    vector<std::exception_ptr> errors(options.n_threads);
+    for (unsigned int t = 0; t < options.n_threads; ++t) {
+      threads.emplace_back([&options, &outputs, &errors, t]() {
+        try {
+          Reprocess(options, t, outputs[t]);
+        } catch (...) {
+          errors[t] = std::current_exception();
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    for (auto &output : outputs) {
+      output.CloseFile();
+    }
+    for (const auto &error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+  } catch (const std::exception &e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return 0;
+}
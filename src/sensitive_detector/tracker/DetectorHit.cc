@@ -18,9 +18,16 @@
 */
 
 #include "DetectorHit.hh"
+#include "MemoryMonitor.hh"
 
 G4ThreadLocal G4Allocator<DetectorHit> *DetectorHitAllocator = 0;
 
+[[maybe_unused]] static const bool detector_hit_allocator_registered =
+    MemoryMonitor::RegisterAllocator("DetectorHit", []() -> size_t {
+      return DetectorHitAllocator ? DetectorHitAllocator->GetAllocatedSize()
+                                  : 0;
+    });
+
 DetectorHit::DetectorHit()
     : NDetectorHit(), fTrackID(-1), fParticleID(0), fGlobalTime(0.), fEdep(0.),
       fEkin(0.), fPos(G4ThreeVector()), fMom(G4ThreeVector()) {}
@@ -29,6 +36,7 @@ DetectorHit::DetectorHit(const DetectorHit &right) : NDetectorHit() {
   fTrackID = right.fTrackID;
   fParticleID = right.fParticleID;
   fDetectorID = right.fDetectorID;
+  fWeight = right.fWeight;
   fGlobalTime = right.fGlobalTime;
   fEdep = right.fEdep;
   fEkin = right.fEkin;
@@ -40,6 +48,7 @@ DetectorHit::DetectorHit(DetectorHit *right) : NDetectorHit() {
   fTrackID = right->fTrackID;
   fParticleID = right->fParticleID;
   fDetectorID = right->fDetectorID;
+  fWeight = right->fWeight;
   fGlobalTime = right->fGlobalTime;
   fEdep = right->fEdep;
   fEkin = right->fEkin;
@@ -51,6 +60,7 @@ const DetectorHit &DetectorHit::operator=(const DetectorHit &right) {
   fTrackID = right.fTrackID;
   fParticleID = right.fParticleID;
   fDetectorID = right.fDetectorID;
+  fWeight = right.fWeight;
   fGlobalTime = right.fGlobalTime;
   fEkin = right.fEkin;
   fEdep = right.fEdep;
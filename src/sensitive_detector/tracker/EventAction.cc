@@ -27,10 +27,23 @@ using std::make_shared;
 
 #include "DetectorHit.hh"
 #include "EventAction.hh"
+#include "LiveMetrics.hh"
+#include "PerfCounters.hh"
+#include "Tracer.hh"
 
 EventAction::EventAction(AnalysisManager *ana_man) : NEventAction(ana_man) {}
 
 void EventAction::EndOfEventAction(const G4Event *event) {
+  Tracer::End("Tracking");
+  PerfCounters::End(PerfCounters::tracking);
+  TraceScope trace("EndOfEventAction");
+  PerfCounterScope counters(PerfCounters::output);
+  LiveMetrics::EventFinished();
+
+  if (!IsTriggered(event)) {
+    return;
+  }
+
   G4VHitsCollection *hc = nullptr;
   for (int n_hc = 0; n_hc < event->GetHCofThisEvent()->GetNumberOfCollections();
        ++n_hc) {
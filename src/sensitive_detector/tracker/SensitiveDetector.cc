@@ -19,6 +19,7 @@
 
 #include "G4SDManager.hh"
 
+#include "PerfCounters.hh"
 #include "SensitiveDetector.hh"
 
 void SensitiveDetector::Initialize(G4HCofThisEvent *hce) {
@@ -31,6 +32,8 @@ void SensitiveDetector::Initialize(G4HCofThisEvent *hce) {
 }
 
 G4bool SensitiveDetector::ProcessHits(G4Step *aStep, G4TouchableHistory *) {
+  PerfCounterScope counters(PerfCounters::process_hits);
+
   // Hits with no energy deposition are recorded as well.
   // This makes it possible to read out the point where a particle entered a
   // detector volume, because movement ('transportation') counts as a 'hit' with
@@ -42,6 +45,7 @@ G4bool SensitiveDetector::ProcessHits(G4Step *aStep, G4TouchableHistory *) {
   newDetectorHit->SetParticleID(
       aStep->GetTrack()->GetDynamicParticle()->GetPDGcode());
   newDetectorHit->SetDetectorID(fDetectorID);
+  newDetectorHit->SetWeight(aStep->GetTrack()->GetWeight());
   newDetectorHit->SetGlobalTime(aStep->GetPreStepPoint()->GetGlobalTime());
   newDetectorHit->SetEdep(aStep->GetTotalEnergyDeposit());
   newDetectorHit->SetEnergy(aStep->GetPreStepPoint()->GetKineticEnergy());
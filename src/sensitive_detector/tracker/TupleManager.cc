@@ -20,51 +20,58 @@
 #include "TupleManager.hh"
 #include "DetectorHit.hh"
 
-void TupleManager::CreateNtupleColumns(G4AnalysisManager *analysisManager) {
-  analysisManager->CreateNtuple("hits", "Hits");
-  AnalysisManager::CreateNtupleColumns(analysisManager);
-  analysisManager->CreateNtupleIColumn("trid");
-  analysisManager->CreateNtupleIColumn("paid");
-  analysisManager->CreateNtupleIColumn("deid");
-  analysisManager->CreateNtupleDColumn("time");
-  analysisManager->CreateNtupleDColumn("edep");
-  analysisManager->CreateNtupleDColumn("ekin");
-  analysisManager->CreateNtupleDColumn("posx");
-  analysisManager->CreateNtupleDColumn("posy");
-  analysisManager->CreateNtupleDColumn("posz");
-  analysisManager->CreateNtupleDColumn("momx");
-  analysisManager->CreateNtupleDColumn("momy");
-  analysisManager->CreateNtupleDColumn("momz");
+void TupleManager::CreateNtupleColumns(OutputBackend *output) {
+  output->CreateNtuple("hits", "Hits");
+  AnalysisManager::CreateNtupleColumns(output);
+  output->CreateNtupleIColumn("trid");
+  output->CreateNtupleIColumn("paid");
+  output->CreateNtupleIColumn("deid");
+  output->CreateNtupleDColumn("time");
+  output->CreateNtupleDColumn("edep");
+  output->CreateNtupleDColumn("ekin");
+  output->CreateNtupleDColumn("posx");
+  output->CreateNtupleDColumn("posy");
+  output->CreateNtupleDColumn("posz");
+  output->CreateNtupleDColumn("momx");
+  output->CreateNtupleDColumn("momy");
+  output->CreateNtupleDColumn("momz");
+  if (WritesWeights()) {
+    output->CreateNtupleDColumn("weight");
+  }
 }
 
-size_t TupleManager::FillNtupleColumns(G4AnalysisManager *analysisManager,
+size_t TupleManager::FillNtupleColumns(OutputBackend *output,
                                        const G4Event *event,
                                        vector<G4VHit *> hits) {
-  auto col = AnalysisManager::FillNtupleColumns(analysisManager, event, hits);
-  analysisManager->FillNtupleIColumn(
+  auto col = AnalysisManager::FillNtupleColumns(output, event, hits);
+  output->FillNtupleIColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetTrackID());
-  analysisManager->FillNtupleIColumn(
+  output->FillNtupleIColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetParticleID());
-  analysisManager->FillNtupleIColumn(
+  output->FillNtupleIColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetDetectorID());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetGlobalTime());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetEdep());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetEkin());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetPos().x());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetPos().y());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetPos().z());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetMom().x());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetMom().y());
-  analysisManager->FillNtupleDColumn(
+  output->FillNtupleDColumn(
       0, col++, static_cast<DetectorHit *>(hits[0])->GetMom().z());
+  if (WritesWeights()) {
+    output->FillNtupleDColumn(
+        0, col++, static_cast<DetectorHit *>(hits[0])->GetWeight());
+  }
 
   return col;
 }